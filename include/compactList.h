@@ -0,0 +1,93 @@
+/** compactList.h - Declarations of compact index linked list type/operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef COMPACTLIST_H
+#define COMPACTLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ltypes.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Compact list
+//
+// A compact list is a doubly linked list whose nodes all live in one
+// growable array of slots.  Each slot holds a 32 bit index of the previous
+// and next slot followed by the element data inline, so the links cost 8
+// bytes per node rather than the 24 bytes of a dLinkedListNode, and the
+// nodes stay close together in memory.  Slots freed by removals are kept on
+// an index free list and reused before the array grows.
+//
+// Nodes are referred to by their slot index, CL_NIL marks the end of the
+// list.  Indices stay valid until the node is removed or the list is
+// compacted, but pointers returned by cl_data are invalidated whenever the
+// array grows.  Since there are no pointers inside the array the whole list
+// can be copied or written out with its slots as they are.
+///////////////////////////////////////////////////////////////////////////////
+
+// Index that refers to no node
+#define CL_NIL UINT32_MAX
+
+// Compact list
+typedef struct compactList {
+    size_t logicalLength;       // number of nodes in the list
+    size_t elementSize;         // size of each element in bytes
+    size_t slotSize;            // size of each slot in bytes
+    uint32_t capacity;          // number of slots allocated
+    uint32_t used;              // number of slots ever handed out
+    uint32_t head;              // index of the beginning/head of the list
+    uint32_t tail;              // index of the end/tail of the list
+    uint32_t freeSlots;         // index of the first free slot
+    unsigned char *slots;       // array of slots
+    freeFunction freeFn;        // optional function used to free nodes
+} compactList;
+
+// Forward declarations of compact list operations
+compactList *cl_create(size_t, freeFunction);
+void cl_delete(compactList *);
+void cl_reserve(compactList *, size_t);
+uint32_t cl_push(compactList *, void *);
+uint32_t cl_append(compactList *, void *);
+uint32_t cl_insertAfter(compactList *, uint32_t, void *);
+uint32_t cl_insertBefore(compactList *, uint32_t, void *);
+void cl_deleteNode(compactList *, void *, nodeComparator);
+void cl_removeAt(compactList *, uint32_t);
+uint32_t cl_getNodeAt(compactList *, size_t);
+bool cl_search(compactList *, void *, nodeComparator);
+void cl_foreach(compactList *, listIterator, displayFunction);
+void cl_head(compactList *, void *, bool);
+uint32_t cl_first(compactList *);
+void cl_tail(compactList *, void *);
+uint32_t cl_last(compactList *);
+uint32_t cl_next(compactList *, uint32_t);
+uint32_t cl_prev(compactList *, uint32_t);
+void *cl_data(compactList *, uint32_t);
+bool cl_isEmpty(compactList *);
+size_t cl_length(compactList *);
+void cl_reverse(compactList *);
+void cl_swapNodeData(compactList *, uint32_t, uint32_t);
+void cl_selectionSort(compactList *, nodeComparator);
+compactList *cl_split(compactList *);
+void cl_compact(compactList *);
+
+#endif
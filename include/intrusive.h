@@ -0,0 +1,420 @@
+/** intrusive.h - Declarations of intrusive list types and operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef INTRUSIVE_H
+#define INTRUSIVE_H
+
+#include <stddef.h>
+#include <assert.h>
+#include "ltypes.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Intrusive lists
+//
+// An intrusive list does not own its elements.  Instead of copying each
+// element into a node it allocates, the caller embeds a link struct in its
+// own objects and the list threads those links together.  Inserting and
+// removing never allocates or copies, the list always refers to the
+// caller's object itself, and an object with several links can sit on
+// several lists at once (one list per link).
+//
+// A list is initialized with the offset of the link within the objects it
+// holds so that operations taking a nodeComparator or listIterator can hand
+// them the object rather than the link.  container_of turns a link pointer
+// back into a pointer to the object that embeds it.
+//
+// Link and unlink operations are inline.  The list never frees anything,
+// the caller owns every object and must remove it from all its lists before
+// freeing it.
+///////////////////////////////////////////////////////////////////////////////
+
+// Return a pointer to the object of `type` whose `member` is at `ptr`
+#ifndef container_of
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+// Singly linked intrusive link
+typedef struct iListLink {
+    struct iListLink *next;     // pointer to the next link in the list
+} iListLink;
+
+// Singly linked intrusive list
+typedef struct iList {
+    size_t logicalLength;       // number of links in the list
+    size_t offset;              // offset of the link within each object
+    iListLink *head;            // pointer to the beginning/head of the list
+    iListLink *tail;            // pointer to the end/tail of the list
+} iList;
+
+// Doubly linked intrusive link
+typedef struct idListLink {
+    struct idListLink *prev;    // pointer to previous link
+    struct idListLink *next;    // pointer to next link
+} idListLink;
+
+// Doubly linked intrusive list
+typedef struct idList {
+    size_t logicalLength;       // number of links in the list
+    size_t offset;              // offset of the link within each object
+    idListLink *head;           // pointer to the beginning/head of the list
+    idListLink *tail;           // pointer to the end/tail of the list
+} idList;
+
+// Forward declarations of intrusive list operations
+void il_foreach(iList *, listIterator, displayFunction);
+iListLink *il_find(iList *, const void *, nodeComparator);
+void il_reverse(iList *);
+void il_split(iList *, iList *);
+void il_sort(iList *, nodeComparator);
+void idl_foreach(idList *, listIterator, displayFunction);
+idListLink *idl_find(idList *, const void *, nodeComparator);
+void idl_reverse(idList *);
+void idl_split(idList *, idList *);
+void idl_sort(idList *, nodeComparator);
+
+/**
+ * il_init:
+ *      Initialize an empty list of objects whose link is at `offset`.
+ */
+static inline void il_init(iList *l, size_t offset)
+{
+    l->logicalLength = 0;
+    l->offset = offset;
+    l->head = l->tail = NULL;
+}
+
+/**
+ * il_object:
+ *      Return the object embedding a link of the list.
+ */
+static inline void *il_object(iList *l, iListLink *link)
+{
+    return (char *)link - l->offset;
+}
+
+/**
+ * il_push:
+ *      Link an object in at the front of the list.
+ */
+static inline void il_push(iList *l, iListLink *link)
+{
+    link->next = l->head;
+    l->head = link;
+    if (!l->tail)
+        l->tail = link;
+    l->logicalLength++;
+}
+
+/**
+ * il_append:
+ *      Link an object in at the end of the list.
+ */
+static inline void il_append(iList *l, iListLink *link)
+{
+    link->next = NULL;
+    if (l->tail)
+        l->tail->next = link;
+    else
+        l->head = link;
+    l->tail = link;
+    l->logicalLength++;
+}
+
+/**
+ * il_insertAfter:
+ *      Link an object in after `prev`, or at the front if `prev` is NULL.
+ */
+static inline void il_insertAfter(iList *l, iListLink *prev, iListLink *link)
+{
+    if (!prev) {
+        il_push(l, link);
+        return;
+    }
+
+    link->next = prev->next;
+    prev->next = link;
+    if (l->tail == prev)
+        l->tail = link;
+    l->logicalLength++;
+}
+
+/**
+ * il_removeAfter:
+ *      Unlink and return the link following `prev`, or the head if `prev`
+ *      is NULL.  Returns NULL if there is no such link.
+ */
+static inline iListLink *il_removeAfter(iList *l, iListLink *prev)
+{
+    iListLink *link = prev ? prev->next : l->head;
+    if (!link)
+        return NULL;
+
+    if (prev)
+        prev->next = link->next;
+    else
+        l->head = link->next;
+    if (l->tail == link)
+        l->tail = prev;
+    link->next = NULL;
+    l->logicalLength--;
+
+    return link;
+}
+
+/**
+ * il_remove:
+ *      Unlink a link from the list.  A singly linked link does not know
+ *      its predecessor so this walks the list, use il_removeAfter when the
+ *      predecessor is at hand.
+ *      Returns false if the link was not in the list.
+ */
+static inline bool il_remove(iList *l, iListLink *link)
+{
+    iListLink *prev = NULL;
+
+    for (iListLink *curr = l->head; curr; prev = curr, curr = curr->next)
+        if (curr == link)
+            return il_removeAfter(l, prev) != NULL;
+
+    return false;
+}
+
+/**
+ * il_first:
+ *      Return the head link of the list.
+ */
+static inline iListLink *il_first(iList *l)
+{
+    return l->head;
+}
+
+/**
+ * il_last:
+ *      Return the tail link of the list.
+ */
+static inline iListLink *il_last(iList *l)
+{
+    return l->tail;
+}
+
+/**
+ * il_next:
+ *      Return the link following `link`.
+ */
+static inline iListLink *il_next(iListLink *link)
+{
+    return link->next;
+}
+
+/**
+ * il_isEmpty:
+ *      Return true if the list is empty.
+ */
+static inline bool il_isEmpty(iList *l)
+{
+    return l->logicalLength == 0;
+}
+
+/**
+ * il_length:
+ *      Return the number of links in the list.
+ */
+static inline size_t il_length(iList *l)
+{
+    return l->logicalLength;
+}
+
+/**
+ * idl_init:
+ *      Initialize an empty list of objects whose link is at `offset`.
+ */
+static inline void idl_init(idList *l, size_t offset)
+{
+    l->logicalLength = 0;
+    l->offset = offset;
+    l->head = l->tail = NULL;
+}
+
+/**
+ * idl_object:
+ *      Return the object embedding a link of the list.
+ */
+static inline void *idl_object(idList *l, idListLink *link)
+{
+    return (char *)link - l->offset;
+}
+
+/**
+ * idl_push:
+ *      Link an object in at the front of the list.
+ */
+static inline void idl_push(idList *l, idListLink *link)
+{
+    link->prev = NULL;
+    link->next = l->head;
+    if (l->head)
+        l->head->prev = link;
+    else
+        l->tail = link;
+    l->head = link;
+    l->logicalLength++;
+}
+
+/**
+ * idl_append:
+ *      Link an object in at the end of the list.
+ */
+static inline void idl_append(idList *l, idListLink *link)
+{
+    link->next = NULL;
+    link->prev = l->tail;
+    if (l->tail)
+        l->tail->next = link;
+    else
+        l->head = link;
+    l->tail = link;
+    l->logicalLength++;
+}
+
+/**
+ * idl_insertAfter:
+ *      Link an object in after `prev`, or at the front if `prev` is NULL.
+ */
+static inline void idl_insertAfter(idList *l, idListLink *prev,
+                                   idListLink *link)
+{
+    if (!prev) {
+        idl_push(l, link);
+        return;
+    }
+
+    link->prev = prev;
+    link->next = prev->next;
+    if (prev->next)
+        prev->next->prev = link;
+    else
+        l->tail = link;
+    prev->next = link;
+    l->logicalLength++;
+}
+
+/**
+ * idl_insertBefore:
+ *      Link an object in before `next`, or at the end if `next` is NULL.
+ */
+static inline void idl_insertBefore(idList *l, idListLink *next,
+                                    idListLink *link)
+{
+    if (!next) {
+        idl_append(l, link);
+        return;
+    }
+
+    link->next = next;
+    link->prev = next->prev;
+    if (next->prev)
+        next->prev->next = link;
+    else
+        l->head = link;
+    next->prev = link;
+    l->logicalLength++;
+}
+
+/**
+ * idl_remove:
+ *      Unlink a link from the list in constant time.
+ */
+static inline void idl_remove(idList *l, idListLink *link)
+{
+    assert(l->logicalLength);
+
+    if (link->prev)
+        link->prev->next = link->next;
+    else
+        l->head = link->next;
+
+    if (link->next)
+        link->next->prev = link->prev;
+    else
+        l->tail = link->prev;
+
+    link->prev = link->next = NULL;
+    l->logicalLength--;
+}
+
+/**
+ * idl_first:
+ *      Return the head link of the list.
+ */
+static inline idListLink *idl_first(idList *l)
+{
+    return l->head;
+}
+
+/**
+ * idl_last:
+ *      Return the tail link of the list.
+ */
+static inline idListLink *idl_last(idList *l)
+{
+    return l->tail;
+}
+
+/**
+ * idl_next:
+ *      Return the link following `link`.
+ */
+static inline idListLink *idl_next(idListLink *link)
+{
+    return link->next;
+}
+
+/**
+ * idl_prev:
+ *      Return the link preceding `link`.
+ */
+static inline idListLink *idl_prev(idListLink *link)
+{
+    return link->prev;
+}
+
+/**
+ * idl_isEmpty:
+ *      Return true if the list is empty.
+ */
+static inline bool idl_isEmpty(idList *l)
+{
+    return l->logicalLength == 0;
+}
+
+/**
+ * idl_length:
+ *      Return the number of links in the list.
+ */
+static inline size_t idl_length(idList *l)
+{
+    return l->logicalLength;
+}
+
+#endif
@@ -0,0 +1,72 @@
+/** lazyList.h - Declarations of lazy list type and operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef LAZYLIST_H
+#define LAZYLIST_H
+
+#include <stddef.h>
+#include "lists.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Lazy list
+//
+// A lazy list is a singly linked list whose elements come from a generator
+// function and its state, produced one at a time only when they are first
+// needed.  lz_head, lz_getNodeAt and lz_foreach pull as many elements from
+// the generator as they need and keep them, so the first element is ready
+// after a single call and a long or endless sequence is never built
+// eagerly.
+//
+// An optional window bounds the number of elements kept: once more are
+// generated the oldest are freed, so memory is proportional to the window
+// rather than to the sequence.  Positions passed to lz_getNodeAt count
+// from the start of the sequence, positions that have left the window
+// return NULL.  A node returned by lz_getNodeAt is freed when it leaves
+// the window or is removed.
+///////////////////////////////////////////////////////////////////////////////
+
+// Generator writing the next element of a sequence to its first argument,
+// returns false once the sequence has ended
+typedef bool (*generatorFunction)(void *, void *);
+
+// Lazy list
+typedef struct lazyList {
+    linkedList *nodes;          // elements generated and kept
+    size_t dropped;             // elements no longer kept
+    size_t window;              // most elements kept, 0 for no bound
+    generatorFunction gen;      // produces the next element
+    void *state;                // state passed to the generator
+    void *scratch;              // element the generator writes to
+    bool done;                  // the generator has ended
+} lazyList;
+
+// Forward declarations of lazy list operations
+lazyList *lz_create(size_t, freeFunction, generatorFunction, void *, size_t);
+void lz_delete(lazyList *);
+bool lz_head(lazyList *, void *, bool);
+linkedListNode *lz_getNodeAt(lazyList *, size_t);
+void lz_foreach(lazyList *, listIterator, displayFunction);
+size_t lz_generated(lazyList *);
+bool lz_isDone(lazyList *);
+
+#endif
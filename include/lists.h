@@ -24,6 +24,8 @@ SOFTWARE.
 #ifndef LISTS_H
 #define LISTS_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "ltypes.h"
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -45,6 +47,11 @@ SOFTWARE.
 // node) in the list.  It also contains a freeFunction that can be called
 // when removing nodes if neccesary, if this function is not necessary it can
 // be provided as NULL and will be ignored.
+//
+// A node and a copy of its data are allocated as one block by the node
+// allocator (see nodeCache.h).  Lists created with ll_createCached or
+// dll_createCached, or with ll_create/dll_create after nc_setDefault(true),
+// take their nodes from per-thread node caches instead of the heap.
 ///////////////////////////////////////////////////////////////////////////////
 
 // Singly linked list node
@@ -60,18 +67,26 @@ typedef struct linkedList {
     linkedListNode *head;       // pointer to the beginning/head of the list
     linkedListNode *tail;       // pointer to the end/tail of the list
     freeFunction freeFn;        // optional function used to free nodes
+    bool cached;                // allocate nodes from per-thread caches
 }  linkedList;
 
 // Forward declarations of singly linked list operations
 linkedList *ll_create(size_t, freeFunction);
+linkedList *ll_createCached(size_t, freeFunction);
 void ll_delete(linkedList *);
 void ll_push(linkedList *, void *);
 void ll_append(linkedList *, void *);
 void ll_insertAfter(linkedList *, linkedListNode *, void *);
 void ll_deleteNode(linkedList *, void *, nodeComparator);
+size_t ll_removeIf(linkedList *, nodePredicate, void *);
+size_t ll_retainIf(linkedList *, nodePredicate, void *);
+size_t ll_moveIf(linkedList *, linkedList *, nodePredicate, void *);
 linkedListNode *ll_getNodeAt(linkedList *, size_t);
 bool ll_search(linkedList *, void *, nodeComparator);
 void ll_foreach(linkedList *, listIterator, displayFunction);
+void ll_foreachBatch(linkedList *, size_t, batchIterator, void *);
+void ll_foreachBatchCopy(linkedList *, size_t, copyBatchIterator, void *);
+size_t ll_toArray(linkedList *, void *);
 void ll_head(linkedList *, void *, bool);
 linkedListNode *ll_first(linkedList *);
 void ll_tail(linkedList *, void *);
@@ -107,19 +122,27 @@ typedef struct dLinkedList {
     dLinkedListNode *head;      // pointer to the beginning/head of the list
     dLinkedListNode *tail;      // pointer to the end/tail of the list
     freeFunction freeFn;        // optional function used to free nodes
+    bool cached;                // allocate nodes from per-thread caches
 } dLinkedList;
 
 // Forward declarations of doubly linked list operations
 dLinkedList *dll_create(size_t, freeFunction);
+dLinkedList *dll_createCached(size_t, freeFunction);
 void dll_delete(dLinkedList *);
 void dll_push(dLinkedList *, void *);
 void dll_append(dLinkedList *, void *);
 void dll_insertAfter(dLinkedList *, dLinkedListNode *, void *);
 void dll_insertBefore(dLinkedList *, dLinkedListNode *, void *);
 void dll_deleteNode(dLinkedList *, void *, nodeComparator);
+size_t dll_removeIf(dLinkedList *, nodePredicate, void *);
+size_t dll_retainIf(dLinkedList *, nodePredicate, void *);
+size_t dll_moveIf(dLinkedList *, dLinkedList *, nodePredicate, void *);
 dLinkedListNode *dll_getNodeAt(dLinkedList *, size_t);
 bool dll_search(dLinkedList *, void *, nodeComparator);
 void dll_foreach(dLinkedList *, listIterator, displayFunction);
+void dll_foreachBatch(dLinkedList *, size_t, batchIterator, void *);
+void dll_foreachBatchCopy(dLinkedList *, size_t, copyBatchIterator, void *);
+size_t dll_toArray(dLinkedList *, void *);
 void dll_head(dLinkedList *, void *, bool);
 dLinkedListNode *dll_first(dLinkedList *);
 void dll_tail(dLinkedList *, void *);
@@ -131,15 +154,280 @@ void dll_swapNodeData(dLinkedList *, dLinkedListNode *, dLinkedListNode *);
 void dll_selectionSort(dLinkedList *, nodeComparator);
 dLinkedList *dll_split(dLinkedList *);
 
+///////////////////////////////////////////////////////////////////////////////
+// Cursors
+//
+// A cursor stands on a node of a list and can get, replace or remove that
+// node's data and insert new nodes around it in O(1), without rescanning
+// the list from the head as ll_deleteNode does.  A singly linked list
+// cursor tracks the node before its own so that it can unlink it.
+//
+// Removing the cursor's node moves the cursor to the node that followed
+// it, so a filter is a single loop that either removes or moves on.  A
+// cursor that has moved past either end is no longer valid; inserting
+// before it appends.  Changing the list other than through the cursor
+// invalidates it, unless only nodes after the cursor's node are changed.
+///////////////////////////////////////////////////////////////////////////////
+
+// Position within a singly linked list
+typedef struct llCursor {
+    linkedList *list;           // list the cursor walks
+    linkedListNode *prev;       // node before the current node, NULL at head
+    linkedListNode *curr;       // current node, NULL past the tail
+} llCursor;
+
+// Position within a doubly linked list
+typedef struct dllCursor {
+    dLinkedList *list;          // list the cursor walks
+    dLinkedListNode *curr;      // current node, NULL past either end
+} dllCursor;
+
+// Forward declarations of cursor operations
+llCursor ll_cursor(linkedList *);
+bool llc_valid(llCursor *);
+void llc_next(llCursor *);
+void *llc_get(llCursor *);
+void llc_set(llCursor *, void *);
+void llc_remove(llCursor *);
+void llc_insertBefore(llCursor *, void *);
+void llc_insertAfter(llCursor *, void *);
+dllCursor dll_cursor(dLinkedList *);
+dllCursor dll_cursorLast(dLinkedList *);
+bool dlc_valid(dllCursor *);
+void dlc_next(dllCursor *);
+void dlc_prev(dllCursor *);
+void *dlc_get(dllCursor *);
+void dlc_set(dllCursor *, void *);
+void dlc_remove(dllCursor *);
+void dlc_insertBefore(dllCursor *, void *);
+void dlc_insertAfter(dllCursor *, void *);
+
+///////////////////////////////////////////////////////////////////////////////
+// Deferred reclamation
+//
+// Deleting a very large list frees every node and calls the freeFunction on
+// every element, which can stall the calling thread for a long time.
+// ll_deleteAsync and dll_deleteAsync detach the whole chain of nodes in
+// O(1), free the list itself and hand the chain to background reclaimer
+// threads.  A long chain is freed in chunks so that several reclaimer
+// threads can work on it at once.  The freeFunction is called on a
+// reclaimer thread and must be safe to call from there.
+//
+// The memory waiting to be reclaimed is bounded: when a deletion would
+// take the pending total over the limit the caller frees the list itself.
+// reclaim_flush waits until everything queued so far has been freed and
+// reclaim_shutdown also stops the reclaimer threads, e.g. before exit.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of deferred reclamation operations
+void ll_deleteAsync(linkedList *);
+void dll_deleteAsync(dLinkedList *);
+void reclaim_setThreads(size_t);
+void reclaim_setLimit(size_t);
+size_t reclaim_pending(void);
+void reclaim_flush(void);
+void reclaim_shutdown(void);
+
+///////////////////////////////////////////////////////////////////////////////
+// Jump pointer index
+//
+// Walking a list whose nodes are scattered over the heap stalls on a cache
+// miss at every node, and because each address comes from the node before
+// it the processor can not start the next miss early.  A jump index records
+// every stride'th node of a list, splitting it into segments that can be
+// walked side by side, so the misses of several segments overlap.  Searches
+// compare a node of each of `lanes` segments per step, foreach first walks
+// a window of `lanes` segments side by side to pull them into the cache and
+// then iterates over it in order, and getNodeAt walks at most stride - 1
+// nodes from the nearest jump pointer.
+//
+// Building an index walks the list once, so it pays off for lists that are
+// searched or iterated over many times between changes.  The index is only
+// valid until the list is next changed and must then be rebuilt.
+///////////////////////////////////////////////////////////////////////////////
+
+// Jump pointer index over the nodes of a list
+typedef struct jumpIndex {
+    size_t length;              // list length when the index was built
+    size_t stride;              // nodes between jump pointers
+    size_t lanes;               // segments walked side by side
+    size_t nextOffset;          // offset of the next link within a node
+    size_t count;               // number of jump pointers
+    void **jumps;               // first node of every segment
+} jumpIndex;
+
+// Forward declarations of jump index operations
+jumpIndex *ll_jumpIndex(linkedList *, size_t, size_t);
+bool ll_searchIndexed(linkedList *, jumpIndex *, void *, nodeComparator);
+void ll_foreachIndexed(linkedList *, jumpIndex *, listIterator,
+                       displayFunction);
+linkedListNode *ll_getNodeAtIndexed(linkedList *, jumpIndex *, size_t);
+jumpIndex *dll_jumpIndex(dLinkedList *, size_t, size_t);
+bool dll_searchIndexed(dLinkedList *, jumpIndex *, void *, nodeComparator);
+void dll_foreachIndexed(dLinkedList *, jumpIndex *, listIterator,
+                        displayFunction);
+dLinkedListNode *dll_getNodeAtIndexed(dLinkedList *, jumpIndex *, size_t);
+void ji_delete(jumpIndex *);
+
+///////////////////////////////////////////////////////////////////////////////
+// Compaction
+//
+// Nodes of a list that has been built up and churned over a long time end
+// up scattered over the heap, and every step of a traversal is a cache and
+// often a TLB miss.  ll_compact and dll_compact move every node, in list
+// order, into fresh runs of blocks laid out back to back (see nc_allocRun)
+// and free the old blocks.  Element bytes are moved unchanged, so pointers
+// held inside elements stay valid and are still freed by the freeFunction.
+//
+// ll_compactFrom and dll_compactFrom move at most `n` nodes following a
+// given node per call, so compaction can be spread over idle time: start
+// with NULL and pass each call the node the previous call returned, until
+// it returns NULL.  The list may be changed between calls as long as the
+// returned node is not removed.
+//
+// Invalidation: a node that is moved gets a new address, so any pointer to
+// it or to its data held outside the list, including jump indexes, is no
+// longer valid after the call that moved it.  Nodes that are not moved,
+// including the `prev` node passed in, keep their addresses.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of compaction operations
+void ll_compact(linkedList *);
+linkedListNode *ll_compactFrom(linkedList *, linkedListNode *, size_t);
+void dll_compact(dLinkedList *);
+dLinkedListNode *dll_compactFrom(dLinkedList *, dLinkedListNode *, size_t);
+
+///////////////////////////////////////////////////////////////////////////////
+// Cloning
+//
+// ll_clone and dll_clone return a new list with the same element size,
+// freeFunction and elements as the list given, built in a single pass with
+// its nodes carved from runs of blocks (see nc_allocRun) instead of being
+// allocated one by one, so the clone also starts with a compact layout.
+//
+// Element bytes are copied as they are unless a copyFunction is given, in
+// which case it is called with each new element and the element it is a
+// copy of.  Lists whose elements own memory, such as strings freed by
+// freeString, need one (copyString) so that the clone owns its own copies.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of cloning operations
+linkedList *ll_clone(linkedList *, copyFunction);
+dLinkedList *dll_clone(dLinkedList *, copyFunction);
+
+///////////////////////////////////////////////////////////////////////////////
+// Hashing
+//
+// ll_unique and dll_unique remove, in one pass, every node whose element
+// compares EQUAL to that of an earlier node, keeping first occurrences in
+// their order and passing the duplicates to the freeFunction.
+//
+// ll_groupBy and dll_groupBy move every node of a list, in order, onto one
+// sublist per distinct key and leave the list empty.  Nodes are relinked,
+// not copied.  They return a list of the sublists (elements of type
+// linkedList * or dLinkedList *) in order of first occurrence, which
+// deletes the sublists and their nodes when it is deleted.
+//
+// Both look elements up in an open addressing hash table sized from the
+// list's length, so they run in expected O(n).  The hashFunction must give
+// elements that compare EQUAL the same hash, hashInt and hashStr hash int
+// and string elements.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of hashing operations
+size_t ll_unique(linkedList *, hashFunction, nodeComparator);
+linkedList *ll_groupBy(linkedList *, hashFunction, nodeComparator);
+size_t dll_unique(dLinkedList *, hashFunction, nodeComparator);
+linkedList *dll_groupBy(dLinkedList *, hashFunction, nodeComparator);
+
+///////////////////////////////////////////////////////////////////////////////
+// Selection
+//
+// ll_partition and dll_partition relink a list so that the nodes
+// satisfying a predicate come first, each side keeping its order.
+//
+// ll_nthElement and dll_nthElement find the nth least element, counting
+// from 1, in expected O(n) by quickselect: the list is relinked around
+// random pivots until the nth node holds the element a sort would put
+// there, with no greater element before it and no lesser one after it.
+// The median of a list of length n is its (n + 1) / 2th element.
+//
+// ll_topK and dll_topK copy the k greatest elements to an array of k
+// elements, greatest first, in one pass over a list they leave unchanged,
+// keeping the candidates in a heap of k pointers.  The pth percentile of
+// n elements is the least of the n - n * p / 100 greatest.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of selection operations
+size_t ll_partition(linkedList *, nodePredicate, void *);
+linkedListNode *ll_nthElement(linkedList *, size_t, nodeComparator);
+size_t ll_topK(linkedList *, size_t, nodeComparator, void *);
+size_t dll_partition(dLinkedList *, nodePredicate, void *);
+dLinkedListNode *dll_nthElement(dLinkedList *, size_t, nodeComparator);
+size_t dll_topK(dLinkedList *, size_t, nodeComparator, void *);
+
+///////////////////////////////////////////////////////////////////////////////
+// Merging
+//
+// ll_mergeK and dll_mergeK merge an array of k lists, each sorted by the
+// comparator, into a new sorted list by relinking their nodes, in
+// O(n log k) rather than the O(n k) of merging them in pairs one after
+// another.  The first node of every list is kept in a binary heap, equal
+// elements keep the order of the lists they came from, and once a single
+// list is left its remaining nodes are appended whole.  The lists given
+// must share an element size and are left empty, the merged list takes
+// the freeFunction of the first.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of merging operations
+linkedList *ll_mergeK(linkedList **, size_t, nodeComparator);
+dLinkedList *dll_mergeK(dLinkedList **, size_t, nodeComparator);
+
+///////////////////////////////////////////////////////////////////////////////
+// String keys
+//
+// A strKey is a list element holding a string together with its length,
+// hash and first 8 bytes packed big-endian into an integer, computed once
+// when the key is made.  equalStrKey rejects keys whose length or hash
+// differ without reading the strings, making it the comparator to use with
+// ll_search, dll_search and ll_deleteNode; it only tells equal keys apart
+// from unequal ones.  compareStrKey orders keys like strcmp, deciding on
+// the prefix integers alone unless the first 8 bytes are the same, and can
+// be used with the sort routines.
+//
+// strKey_make copies the string into the key and freeStrKey, the list's
+// freeFunction, frees the copy.  strKey_view makes a key that refers to a
+// string it does not own, e.g. to search for, and must not be freed.
+///////////////////////////////////////////////////////////////////////////////
+
+// String element with precomputed metadata
+typedef struct strKey {
+    char *str;                  // NUL terminated string
+    size_t length;              // length of the string in bytes
+    uint64_t hash;              // hash_fnv1a of the string
+    uint64_t prefix;            // first 8 bytes big-endian, zero padded
+} strKey;
+
+// Forward declarations of string key operations
+strKey strKey_make(const char *, size_t);
+strKey strKey_view(const char *, size_t);
+result compareStrKey(const void *, const void *);
+result equalStrKey(const void *, const void *);
+void freeStrKey(void *);
+
 // Common iterator functions
 bool iterFunc_exists(void *, displayFunction);
 
 // Other useful operations
 void freeString(void *);
+void copyString(void *, const void *);
 void printReverseIntLinkedList(linkedListNode *);
 result compareInt(const void *, const void *);
-result comapareStr(const void *, const void *);
+result compareStr(const void *, const void *);
 void printInt(const void *);
 void printStr(const void *);
+uint64_t hash_fnv1a(const void *, size_t);
+uint64_t hashInt(const void *);
+uint64_t hashStr(const void *);
 
 #endif
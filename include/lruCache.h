@@ -0,0 +1,85 @@
+/** lruCache.h - Declarations of LRU cache type and operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lists.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// LRU cache
+//
+// A cache of fixed size keys and values that evicts the least recently
+// used entries once it holds more than a number of entries or bytes.  The
+// entries are the nodes of a dLinkedList kept in recency order, most
+// recent at the head, and an open addressing hash table maps each key to
+// its node, so get, put and evict relink nodes in O(1) instead of the
+// O(n) dll_deleteNode and dll_push of a hand built cache.
+//
+// Every entry is charged the number of bytes given to lru_put, the byte
+// bound applies to the sum of the charges.  Values that are evicted,
+// replaced or removed are passed to the freeFunction, as is every value
+// left when the cache is deleted.  Pointers returned by lru_get are valid
+// until the entry is next evicted, replaced or removed.
+//
+// A segmented cache (lru_createSegmented) resists scans: new entries go
+// into a probationary segment and are promoted to a protected segment,
+// holding up to 80% of the entries, only when they are used again, so a
+// burst of keys used once can only displace other such keys.  Entries
+// demoted from the protected segment get another chance in probation.
+///////////////////////////////////////////////////////////////////////////////
+
+// LRU cache
+typedef struct lruCache {
+    dLinkedList *probation;     // entries most recent first, new entries
+    dLinkedList *protectedList; // entries used again, NULL if not segmented
+    size_t keySize;             // size of each key in bytes
+    size_t valueSize;           // size of each value in bytes
+    size_t maxEntries;          // most entries kept, 0 for no bound
+    size_t maxBytes;            // most bytes charged, 0 for no bound
+    size_t maxProtected;        // most entries in the protected segment
+    size_t bytes;               // bytes charged for the entries kept
+    freeFunction freeFn;        // optional function used to free values
+    dLinkedListNode **slots;    // hash table of entry nodes
+    size_t slotCount;           // number of slots, a power of two
+    void *scratch;              // entry being inserted
+    size_t hits;                // lru_get calls that found their key
+    size_t misses;              // lru_get calls that did not
+    size_t evictions;           // entries evicted to respect the bounds
+} lruCache;
+
+// Forward declarations of LRU cache operations
+lruCache *lru_create(size_t, size_t, size_t, size_t, freeFunction);
+lruCache *lru_createSegmented(size_t, size_t, size_t, size_t, freeFunction);
+void lru_delete(lruCache *);
+void *lru_get(lruCache *, const void *);
+void *lru_peek(lruCache *, const void *);
+void lru_put(lruCache *, const void *, const void *, size_t);
+bool lru_remove(lruCache *, const void *);
+size_t lru_length(lruCache *);
+size_t lru_bytes(lruCache *);
+void lru_resetStats(lruCache *);
+
+#endif
@@ -24,7 +24,9 @@ SOFTWARE.
 #ifndef LTYPES_H
 #define LTYPES_H
 
+#include <stddef.h>             // for type size_t
 #include <stdbool.h>            // for type bool
+#include <stdint.h>             // for type uint64_t
 
 // result type used for nodeComparator functions
 typedef enum result {
@@ -36,7 +38,12 @@ typedef enum result {
 // Forward defintions of functions common to list/tree types
 typedef void (*displayFunction)(const void *);
 typedef void (*freeFunction)(void *);
+typedef void (*copyFunction)(void *, const void *);
 typedef bool (*listIterator)(void *, displayFunction);
 typedef result (*nodeComparator)(const void *, const void *);
+typedef uint64_t (*hashFunction)(const void *);
+typedef bool (*nodePredicate)(const void *, void *);
+typedef bool (*batchIterator)(void **, size_t, void *);
+typedef bool (*copyBatchIterator)(void *, size_t, void *);
 
 #endif
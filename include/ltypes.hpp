@@ -0,0 +1,821 @@
+/** ltypes.hpp - C++ typed lists built on the ltypes node model.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef LTYPES_HPP
+#define LTYPES_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+extern "C" {
+#include "intrusive.h"
+#include "nodeCache.h"
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// C++ lists
+//
+// ltypes::list<T> and ltypes::dlist<T> are singly and doubly linked lists
+// of T for C++17.  Each node is a single block holding an intrusive link
+// (see intrusive.h) followed by the element itself, constructed in place,
+// so any T can be stored, not just trivially copyable ones, and nothing is
+// copied through void pointers.  Linking and unlinking use the same inline
+// il_/idl_ operations as the C intrusive lists.
+//
+// Iterators are STL compatible, forward for list and bidirectional for
+// dlist, so the <algorithm> functions work on both.  sort is a stable merge
+// sort that relinks nodes and takes any comparator, including lambdas,
+// which the compiler can inline.  splice moves nodes between lists without
+// allocating.
+//
+// Nodes are allocated with Alloc rebound to the node type.  Using
+// ltypes::cache_allocator takes them from the calling thread's node cache
+// (see nodeCache.h) like linkedLists created with ll_createCached, it
+// aborts rather than throws when memory runs out.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace ltypes {
+
+// Allocator taking blocks from per-thread node caches
+template <typename T>
+struct cache_allocator {
+    using value_type = T;
+
+    cache_allocator() noexcept = default;
+
+    template <typename U>
+    cache_allocator(const cache_allocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(nc_alloc(n * sizeof(T), true));
+    }
+
+    void deallocate(T *p, std::size_t) noexcept
+    {
+        nc_free(p);
+    }
+
+    template <typename U>
+    bool operator==(const cache_allocator<U> &) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const cache_allocator<U> &) const noexcept
+    {
+        return false;
+    }
+};
+
+namespace detail {
+
+// Node allocation shared by list and dlist
+template <typename Node, typename Alloc>
+class node_owner {
+protected:
+    using traits = typename std::allocator_traits<Alloc>::
+        template rebind_traits<Node>;
+    using node_alloc = typename traits::allocator_type;
+
+    node_alloc alloc_;          // allocator for nodes
+
+    explicit node_owner(const Alloc &a) : alloc_(a) {}
+
+    // Allocate a node and construct its element from args
+    template <typename... Args>
+    Node *make(Args &&...args)
+    {
+        Node *n = traits::allocate(alloc_, 1);
+        try {
+            traits::construct(alloc_, n, std::forward<Args>(args)...);
+        } catch (...) {
+            traits::deallocate(alloc_, n, 1);
+            throw;
+        }
+        return n;
+    }
+
+    // Destroy a node's element and free the node
+    void destroy(Node *n) noexcept
+    {
+        traits::destroy(alloc_, n);
+        traits::deallocate(alloc_, n, 1);
+    }
+};
+
+// Merge two sorted chains of links linked through next, preferring a
+template <typename Link, typename Less>
+Link *merge(Link *a, Link *b, Less &less)
+{
+    Link head, *tail = &head;
+
+    while (a && b) {
+        if (less(b, a)) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+
+    return head.next;
+}
+
+// Stable bottom up merge sort of a NULL terminated chain of links
+template <typename Link, typename Less>
+Link *sort(Link *chain, Less less)
+{
+    Link *bins[sizeof(std::size_t) * 8] = {}; // bins[i] is a run of 2^i links
+    std::size_t top = 0, i;
+    Link *run;
+
+    // Merge each link into the bins like carries in a binary counter
+    while (chain) {
+        run = chain;
+        chain = chain->next;
+        run->next = nullptr;
+
+        for (i = 0; bins[i]; i++) {
+            run = merge(bins[i], run, less);
+            bins[i] = nullptr;
+        }
+        bins[i] = run;
+        if (i >= top)
+            top = i + 1;
+    }
+
+    // Older runs hold earlier links so they are merged in on the left
+    for (run = nullptr, i = 0; i < top; i++)
+        if (bins[i])
+            run = merge(bins[i], run, less);
+
+    return run;
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// Singly linked list
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Alloc = std::allocator<T>>
+class list;
+
+namespace detail {
+
+// Singly linked node, derived from its link so links convert to nodes
+template <typename T>
+struct slist_node : iListLink {
+    T value;                    // element
+
+    template <typename... Args>
+    explicit slist_node(Args &&...args)
+        : iListLink{nullptr}, value(std::forward<Args>(args)...) {}
+};
+
+// Forward iterator over a list
+template <typename T, bool Const>
+class slist_iterator {
+    template <typename, typename> friend class ltypes::list;
+    template <typename, bool> friend class slist_iterator;
+
+    using node = slist_node<T>;
+
+    iListLink *link_;           // current link, NULL past the end
+
+    explicit slist_iterator(iListLink *l) : link_(l) {}
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T *, T *>;
+    using reference = std::conditional_t<Const, const T &, T &>;
+
+    slist_iterator() : link_(nullptr) {}
+
+    // Iterators convert to const iterators
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    slist_iterator(const slist_iterator<T, false> &it) : link_(it.link_) {}
+
+    reference operator*() const
+    {
+        return static_cast<node *>(link_)->value;
+    }
+
+    pointer operator->() const { return &**this; }
+
+    slist_iterator &operator++()
+    {
+        link_ = link_->next;
+        return *this;
+    }
+
+    slist_iterator operator++(int)
+    {
+        slist_iterator it = *this;
+        link_ = link_->next;
+        return it;
+    }
+
+    friend bool operator==(const slist_iterator &a, const slist_iterator &b)
+    {
+        return a.link_ == b.link_;
+    }
+
+    friend bool operator!=(const slist_iterator &a, const slist_iterator &b)
+    {
+        return a.link_ != b.link_;
+    }
+};
+
+} // namespace detail
+
+// Singly linked list of T
+template <typename T, typename Alloc>
+class list : private detail::node_owner<detail::slist_node<T>, Alloc> {
+    using node = detail::slist_node<T>;
+    using base = detail::node_owner<node, Alloc>;
+    using traits = typename base::traits;
+    using base::alloc_;
+    using base::make;
+    using base::destroy;
+
+    iList l_;                   // links of the nodes
+
+    static node *to_node(iListLink *l) { return static_cast<node *>(l); }
+
+    void init() { il_init(&l_, 0); }
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = detail::slist_iterator<T, false>;
+    using const_iterator = detail::slist_iterator<T, true>;
+
+    list() : list(Alloc()) {}
+
+    explicit list(const Alloc &a) : base(a) { init(); }
+
+    list(std::initializer_list<T> il, const Alloc &a = Alloc()) : list(a)
+    {
+        for (const T &v : il)
+            push_back(v);
+    }
+
+    list(const list &o)
+        : list(traits::select_on_container_copy_construction(o.alloc_))
+    {
+        for (const T &v : o)
+            push_back(v);
+    }
+
+    list(list &&o) noexcept : base(std::move(o.alloc_))
+    {
+        l_ = o.l_;
+        o.init();
+    }
+
+    ~list() { clear(); }
+
+    list &operator=(const list &o)
+    {
+        if (this != &o) {
+            list tmp(o);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    list &operator=(list &&o) noexcept
+    {
+        if (this != &o) {
+            clear();
+            swap(o);
+        }
+        return *this;
+    }
+
+    void swap(list &o) noexcept
+    {
+        using std::swap;
+        swap(l_, o.l_);
+        swap(alloc_, o.alloc_);
+    }
+
+    allocator_type get_allocator() const { return Alloc(alloc_); }
+
+    // Iterators
+    iterator begin() noexcept { return iterator(l_.head); }
+    iterator end() noexcept { return iterator(nullptr); }
+    const_iterator begin() const noexcept { return const_iterator(l_.head); }
+    const_iterator end() const noexcept { return const_iterator(nullptr); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Capacity and element access
+    bool empty() const noexcept { return l_.logicalLength == 0; }
+    size_type size() const noexcept { return l_.logicalLength; }
+    reference front() { return to_node(l_.head)->value; }
+    const_reference front() const { return to_node(l_.head)->value; }
+    reference back() { return to_node(l_.tail)->value; }
+    const_reference back() const { return to_node(l_.tail)->value; }
+
+    // Insertion, elements are constructed in place
+    template <typename... Args>
+    reference emplace_front(Args &&...args)
+    {
+        node *n = make(std::forward<Args>(args)...);
+        il_push(&l_, n);
+        return n->value;
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args &&...args)
+    {
+        node *n = make(std::forward<Args>(args)...);
+        il_append(&l_, n);
+        return n->value;
+    }
+
+    // Construct an element after pos, or at the front if pos is end()
+    template <typename... Args>
+    iterator emplace_after(const_iterator pos, Args &&...args)
+    {
+        node *n = make(std::forward<Args>(args)...);
+        il_insertAfter(&l_, pos.link_, n);
+        return iterator(n);
+    }
+
+    void push_front(const T &v) { emplace_front(v); }
+    void push_front(T &&v) { emplace_front(std::move(v)); }
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+
+    iterator insert_after(const_iterator pos, const T &v)
+    {
+        return emplace_after(pos, v);
+    }
+
+    iterator insert_after(const_iterator pos, T &&v)
+    {
+        return emplace_after(pos, std::move(v));
+    }
+
+    // Removal
+    void pop_front() { destroy(to_node(il_removeAfter(&l_, nullptr))); }
+
+    // Remove the element after pos, or the front if pos is end()
+    iterator erase_after(const_iterator pos)
+    {
+        iListLink *removed = il_removeAfter(&l_, pos.link_);
+        assert(removed);
+        destroy(to_node(removed));
+        return iterator(pos.link_ ? pos.link_->next : l_.head);
+    }
+
+    void clear() noexcept
+    {
+        iListLink *link = l_.head;
+        while (link) {
+            iListLink *next = link->next;
+            destroy(to_node(link));
+            link = next;
+        }
+        init();
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred)
+    {
+        size_type removed = 0;
+        iListLink *prev = nullptr, *link = l_.head;
+
+        while (link) {
+            if (pred(to_node(link)->value)) {
+                destroy(to_node(il_removeAfter(&l_, prev)));
+                removed++;
+            } else {
+                prev = link;
+            }
+            link = prev ? prev->next : l_.head;
+        }
+        return removed;
+    }
+
+    // Operations that relink nodes without allocating
+    void reverse() noexcept { il_reverse(&l_); }
+
+    // Move every node of o to after pos, or to the front if pos is end()
+    void splice_after(const_iterator pos, list &o)
+    {
+        if (o.empty() || &o == this)
+            return;
+
+        iListLink *after = pos.link_;
+        iListLink *next = after ? after->next : l_.head;
+
+        o.l_.tail->next = next;
+        if (after)
+            after->next = o.l_.head;
+        else
+            l_.head = o.l_.head;
+        if (!next)
+            l_.tail = o.l_.tail;
+
+        l_.logicalLength += o.l_.logicalLength;
+        o.init();
+    }
+
+    template <typename Compare = std::less<>>
+    void sort(Compare comp = Compare())
+    {
+        iListLink *run = detail::sort(l_.head,
+            [&comp](iListLink *a, iListLink *b) {
+                return comp(to_node(a)->value, to_node(b)->value);
+            });
+
+        l_.head = l_.tail = run;
+        while (l_.tail && l_.tail->next)
+            l_.tail = l_.tail->next;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Doubly linked list
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Alloc = std::allocator<T>>
+class dlist;
+
+namespace detail {
+
+// Doubly linked node, derived from its link so links convert to nodes
+template <typename T>
+struct dlist_node : idListLink {
+    T value;                    // element
+
+    template <typename... Args>
+    explicit dlist_node(Args &&...args)
+        : idListLink{nullptr, nullptr}, value(std::forward<Args>(args)...) {}
+};
+
+// Bidirectional iterator over a dlist
+template <typename T, bool Const>
+class dlist_iterator {
+    template <typename, typename> friend class ltypes::dlist;
+    template <typename, bool> friend class dlist_iterator;
+
+    using node = dlist_node<T>;
+
+    idListLink *link_;          // current link, NULL past the end
+    const idList *list_;        // list iterated, so end() can step back
+
+    dlist_iterator(idListLink *l, const idList *il) : link_(l), list_(il) {}
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T *, T *>;
+    using reference = std::conditional_t<Const, const T &, T &>;
+
+    dlist_iterator() : link_(nullptr), list_(nullptr) {}
+
+    // Iterators convert to const iterators
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    dlist_iterator(const dlist_iterator<T, false> &it)
+        : link_(it.link_), list_(it.list_) {}
+
+    reference operator*() const
+    {
+        return static_cast<node *>(link_)->value;
+    }
+
+    pointer operator->() const { return &**this; }
+
+    dlist_iterator &operator++()
+    {
+        link_ = link_->next;
+        return *this;
+    }
+
+    dlist_iterator operator++(int)
+    {
+        dlist_iterator it = *this;
+        ++*this;
+        return it;
+    }
+
+    dlist_iterator &operator--()
+    {
+        link_ = link_ ? link_->prev : list_->tail;
+        return *this;
+    }
+
+    dlist_iterator operator--(int)
+    {
+        dlist_iterator it = *this;
+        --*this;
+        return it;
+    }
+
+    friend bool operator==(const dlist_iterator &a, const dlist_iterator &b)
+    {
+        return a.link_ == b.link_;
+    }
+
+    friend bool operator!=(const dlist_iterator &a, const dlist_iterator &b)
+    {
+        return a.link_ != b.link_;
+    }
+};
+
+} // namespace detail
+
+// Doubly linked list of T
+template <typename T, typename Alloc>
+class dlist : private detail::node_owner<detail::dlist_node<T>, Alloc> {
+    using node = detail::dlist_node<T>;
+    using base = detail::node_owner<node, Alloc>;
+    using traits = typename base::traits;
+    using base::alloc_;
+    using base::make;
+    using base::destroy;
+
+    idList l_;                  // links of the nodes
+
+    static node *to_node(idListLink *l) { return static_cast<node *>(l); }
+
+    void init() { idl_init(&l_, 0); }
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = detail::dlist_iterator<T, false>;
+    using const_iterator = detail::dlist_iterator<T, true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    dlist() : dlist(Alloc()) {}
+
+    explicit dlist(const Alloc &a) : base(a) { init(); }
+
+    dlist(std::initializer_list<T> il, const Alloc &a = Alloc()) : dlist(a)
+    {
+        for (const T &v : il)
+            push_back(v);
+    }
+
+    dlist(const dlist &o)
+        : dlist(traits::select_on_container_copy_construction(o.alloc_))
+    {
+        for (const T &v : o)
+            push_back(v);
+    }
+
+    // end() iterators refer to the list header and are not carried over
+    dlist(dlist &&o) noexcept : base(std::move(o.alloc_))
+    {
+        l_ = o.l_;
+        o.init();
+    }
+
+    ~dlist() { clear(); }
+
+    dlist &operator=(const dlist &o)
+    {
+        if (this != &o) {
+            dlist tmp(o);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    dlist &operator=(dlist &&o) noexcept
+    {
+        if (this != &o) {
+            clear();
+            swap(o);
+        }
+        return *this;
+    }
+
+    void swap(dlist &o) noexcept
+    {
+        using std::swap;
+        swap(l_, o.l_);
+        swap(alloc_, o.alloc_);
+    }
+
+    allocator_type get_allocator() const { return Alloc(alloc_); }
+
+    // Iterators
+    iterator begin() noexcept { return iterator(l_.head, &l_); }
+    iterator end() noexcept { return iterator(nullptr, &l_); }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(l_.head, &l_);
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(nullptr, &l_);
+    }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    // Capacity and element access
+    bool empty() const noexcept { return l_.logicalLength == 0; }
+    size_type size() const noexcept { return l_.logicalLength; }
+    reference front() { return to_node(l_.head)->value; }
+    const_reference front() const { return to_node(l_.head)->value; }
+    reference back() { return to_node(l_.tail)->value; }
+    const_reference back() const { return to_node(l_.tail)->value; }
+
+    // Insertion, elements are constructed in place
+    template <typename... Args>
+    reference emplace_front(Args &&...args)
+    {
+        node *n = make(std::forward<Args>(args)...);
+        idl_push(&l_, n);
+        return n->value;
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args &&...args)
+    {
+        node *n = make(std::forward<Args>(args)...);
+        idl_append(&l_, n);
+        return n->value;
+    }
+
+    // Construct an element before pos
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args &&...args)
+    {
+        node *n = make(std::forward<Args>(args)...);
+        idl_insertBefore(&l_, pos.link_, n);
+        return iterator(n, &l_);
+    }
+
+    void push_front(const T &v) { emplace_front(v); }
+    void push_front(T &&v) { emplace_front(std::move(v)); }
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+
+    iterator insert(const_iterator pos, const T &v) { return emplace(pos, v); }
+
+    iterator insert(const_iterator pos, T &&v)
+    {
+        return emplace(pos, std::move(v));
+    }
+
+    // Removal
+    void pop_front() { erase(begin()); }
+    void pop_back() { erase(iterator(l_.tail, &l_)); }
+
+    iterator erase(const_iterator pos)
+    {
+        idListLink *next = pos.link_->next;
+        idl_remove(&l_, pos.link_);
+        destroy(to_node(pos.link_));
+        return iterator(next, &l_);
+    }
+
+    void clear() noexcept
+    {
+        idListLink *link = l_.head;
+        while (link) {
+            idListLink *next = link->next;
+            destroy(to_node(link));
+            link = next;
+        }
+        init();
+    }
+
+    template <typename Pred>
+    size_type remove_if(Pred pred)
+    {
+        size_type removed = 0;
+
+        for (idListLink *link = l_.head, *next; link; link = next) {
+            next = link->next;
+            if (pred(to_node(link)->value)) {
+                idl_remove(&l_, link);
+                destroy(to_node(link));
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+    // Operations that relink nodes without allocating
+    void reverse() noexcept { idl_reverse(&l_); }
+
+    // Move every node of o to before pos
+    void splice(const_iterator pos, dlist &o)
+    {
+        if (o.empty() || &o == this)
+            return;
+
+        idListLink *next = pos.link_;
+        idListLink *prev = next ? next->prev : l_.tail;
+
+        o.l_.head->prev = prev;
+        o.l_.tail->next = next;
+        if (prev)
+            prev->next = o.l_.head;
+        else
+            l_.head = o.l_.head;
+        if (next)
+            next->prev = o.l_.tail;
+        else
+            l_.tail = o.l_.tail;
+
+        l_.logicalLength += o.l_.logicalLength;
+        o.init();
+    }
+
+    // Move the node at it in o to before pos
+    void splice(const_iterator pos, dlist &o, const_iterator it)
+    {
+        if (pos == it)
+            return;
+
+        idl_remove(&o.l_, it.link_);
+        idl_insertBefore(&l_, pos.link_, it.link_);
+    }
+
+    template <typename Compare = std::less<>>
+    void sort(Compare comp = Compare())
+    {
+        idListLink *run = detail::sort(l_.head,
+            [&comp](idListLink *a, idListLink *b) {
+                return comp(to_node(a)->value, to_node(b)->value);
+            });
+
+        // Restore prev pointers and the tail
+        idListLink *prev = nullptr;
+        for (idListLink *link = run; link; prev = link, link = link->next)
+            link->prev = prev;
+
+        l_.head = run;
+        l_.tail = prev;
+    }
+};
+
+} // namespace ltypes
+
+#endif
@@ -0,0 +1,69 @@
+/** nodeCache.h - Declarations of the list node allocator.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef NODECACHE_H
+#define NODECACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// List node allocator
+//
+// Every node of a linkedList or dLinkedList is a single block holding the
+// node followed by its element data.  Blocks carry a small header recording
+// where they came from so that any thread can free them.
+//
+// Plain blocks come straight from the heap.  Cached blocks come from the
+// calling thread's node cache: per size class magazines of free blocks that
+// are refilled from blocks other threads have returned, from a shared depot
+// and finally by carving new slabs.  Allocating and freeing on the owning
+// thread touches no shared state.
+//
+// A block freed by a thread other than the one that allocated it is not
+// handed to the freeing thread's cache, it is queued in a batch and the
+// whole batch is pushed back to the owning cache with a single atomic
+// operation.  nc_flush pushes the calling thread's partial batch early.
+//
+// A run is a number of uncached blocks laid out back to back in a single
+// allocation, used to give the nodes of a list a compact layout again (see
+// ll_compact).  Run blocks are freed individually with nc_free like any
+// other block; the run's memory is released with its last block.
+//
+// When built with the numa option, slabs are mapped and bound to the local
+// memory node of the thread that carves them and touched by that thread.
+///////////////////////////////////////////////////////////////////////////////
+
+// Round a size up to the alignment of node data
+#define NC_ALIGN(n) (((n) + _Alignof(max_align_t) - 1) & \
+                     ~(_Alignof(max_align_t) - 1))
+
+// Forward declarations of node allocator operations
+void *nc_alloc(size_t, bool);
+void *nc_allocRun(size_t, size_t, size_t *);
+void nc_free(void *);
+void nc_flush(void);
+void nc_setDefault(bool);
+bool nc_getDefault(void);
+
+#endif
@@ -0,0 +1,93 @@
+/** persistentList.h - Declarations of persistent list type and operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef PERSISTENTLIST_H
+#define PERSISTENTLIST_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "lists.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Persistent list
+//
+// A persistent list is a singly linked list whose nodes never change once
+// built, so any number of versions of the list can share them.  Every
+// operation leaves the list passed to it untouched and returns a new
+// version: pl_push and pl_pop share the whole list behind the new head,
+// pl_set and pl_deleteNode copy only the nodes in front of the change and
+// share the rest, and pl_snapshot shares everything.  A snapshot therefore
+// costs one allocation whatever the length of the list.
+//
+// Nodes are reference counted by the versions and nodes that point to
+// them, with atomic counts, so versions of one list may be read and
+// deleted by different threads at the same time.  A version itself is not
+// shared: give each thread its own with pl_snapshot.
+//
+// pl_fromList turns a linkedList into a persistent list once, after which
+// readers can be handed snapshots that share its storage and only the
+// nodes in front of each later change are copied, giving the list copy on
+// write duplication without the cost of a full copy per reader.
+//
+// A copied node does not copy its element, it shares the data of the node
+// it was copied from.  Elements are reference counted apart from nodes: a
+// node no longer referenced releases the rest of its list at once, even
+// while copies keep its element, whose block is freed and passed to the
+// freeFunction when the last node holding the element goes.
+///////////////////////////////////////////////////////////////////////////////
+
+// Persistent list node
+typedef struct persistentListNode {
+    void *data;                         // node data
+    struct persistentListNode *next;    // rest of the list, maybe shared
+    struct persistentListNode *owner;   // node holding data, NULL if this
+    atomic_size_t refs;                 // versions and nodes pointing here
+    atomic_size_t dataRefs;             // nodes sharing data held here
+} persistentListNode;
+
+// Persistent list version
+typedef struct persistentList {
+    size_t logicalLength;       // number of nodes in the list
+    size_t elementSize;         // size of each element in bytes
+    persistentListNode *head;   // pointer to the beginning/head of the list
+    freeFunction freeFn;        // optional function used to free elements
+    bool cached;                // allocate nodes from per-thread caches
+} persistentList;
+
+// Forward declarations of persistent list operations
+persistentList *pl_create(size_t, freeFunction);
+void pl_delete(persistentList *);
+persistentList *pl_fromList(linkedList *, copyFunction);
+persistentList *pl_snapshot(persistentList *);
+persistentList *pl_push(persistentList *, void *);
+persistentList *pl_pop(persistentList *, void *);
+persistentList *pl_set(persistentList *, size_t, void *);
+persistentList *pl_deleteNode(persistentList *, void *, nodeComparator);
+persistentListNode *pl_first(persistentList *);
+persistentListNode *pl_getNodeAt(persistentList *, size_t);
+bool pl_search(persistentList *, void *, nodeComparator);
+void pl_foreach(persistentList *, listIterator, displayFunction);
+size_t pl_length(persistentList *);
+bool pl_isEmpty(persistentList *);
+
+#endif
@@ -0,0 +1,79 @@
+/** queues.h - Declarations of a bounded blocking queue.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef QUEUES_H
+#define QUEUES_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "ltypes.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Bounded blocking queue
+//
+// A blocking queue connects the stages of a producer/consumer pipeline.  It
+// holds at most `capacity` elements of `elementSize` bytes each, copied in
+// and out just like the elements of a linkedList, in a circular buffer.
+//
+// Producers block while the queue is full (backpressure) and consumers block
+// while it is empty.  The batch operations move up to N elements for each
+// lock acquisition instead of paying one lock round trip per element.
+//
+// Timeouts are given in milliseconds, a negative timeout waits forever and
+// a timeout of 0 never blocks.
+//
+// Closing a queue wakes every waiter.  Enqueueing into a closed queue fails,
+// dequeueing keeps returning the elements left in the queue until it has
+// been drained.  Elements still queued when the queue is deleted are passed
+// to the freeFunction.
+///////////////////////////////////////////////////////////////////////////////
+
+// Bounded blocking queue
+typedef struct blockingQueue {
+    size_t logicalLength;       // number of queued elements
+    size_t elementSize;         // size of each element in bytes
+    size_t capacity;            // maximum number of queued elements
+    size_t head;                // slot of the oldest element
+    unsigned char *buffer;      // circular element storage
+    freeFunction freeFn;        // optional function used to free leftovers
+    bool closed;                // set by bq_close
+    size_t waitingProducers;    // producers blocked on a full queue
+    size_t waitingConsumers;    // consumers blocked on an empty queue
+    pthread_mutex_t lock;       // guards the queue
+    pthread_cond_t notFull;     // signalled when space frees up
+    pthread_cond_t notEmpty;    // signalled when elements arrive
+} blockingQueue;
+
+// Forward declarations of blocking queue operations
+blockingQueue *bq_create(size_t, size_t, freeFunction);
+void bq_delete(blockingQueue *);
+bool bq_enqueue(blockingQueue *, void *, long);
+size_t bq_enqueueBatch(blockingQueue *, void *, size_t, long);
+bool bq_dequeue(blockingQueue *, void *, long);
+size_t bq_dequeueBatch(blockingQueue *, void *, size_t, long);
+void bq_close(blockingQueue *);
+bool bq_isClosed(blockingQueue *);
+bool bq_isDrained(blockingQueue *);
+size_t bq_length(blockingQueue *);
+
+#endif
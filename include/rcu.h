@@ -0,0 +1,131 @@
+/** rcu.h - Declarations of a read-copy-update linked list.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef RCU_H
+#define RCU_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "ltypes.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Quiescent-state-based reclamation
+//
+// An rcuDomain tracks a grace period counter and the reader threads that
+// may hold pointers into RCU protected lists.  Each reader thread registers
+// once and then periodically announces a quiescent state, a point at which
+// it holds no pointers to list nodes (for example between two packets).
+//
+// A node removed by a writer is stamped with a new grace period number and
+// may only be freed once every online reader has announced a quiescent
+// state in that grace period or a later one.  Readers that are blocked or
+// idle for a long time should go offline so they don't hold back reclaim.
+///////////////////////////////////////////////////////////////////////////////
+
+// Reader thread state
+typedef struct rcuReader {
+    atomic_ulong ctr;           // last grace period observed, 0 if offline
+    struct rcuDomain *domain;   // domain the reader is registered with
+    struct rcuReader *next;     // next registered reader
+} rcuReader;
+
+// Set of readers sharing grace periods
+typedef struct rcuDomain {
+    atomic_ulong gp;            // current grace period
+    rcuReader *readers;         // registered readers
+    pthread_mutex_t lock;       // guards the reader registry
+} rcuDomain;
+
+// Forward declarations of quiescent state operations
+rcuDomain *rcu_createDomain(void);
+void rcu_deleteDomain(rcuDomain *);
+rcuReader *rcu_registerReader(rcuDomain *);
+void rcu_unregisterReader(rcuReader *);
+void rcu_quiescent(rcuReader *);
+void rcu_offline(rcuReader *);
+void rcu_online(rcuReader *);
+unsigned long rcu_retireEpoch(rcuDomain *);
+bool rcu_epochElapsed(rcuDomain *, unsigned long);
+void rcu_synchronize(rcuDomain *);
+
+///////////////////////////////////////////////////////////////////////////////
+// RCU linked list
+//
+// An RCU list is a doubly linked list for read-mostly data.  Readers call
+// rl_search, rl_find, rl_foreach or walk the list with rl_first/rl_next
+// concurrently with writers and without taking any lock, the only cost on
+// the read side is an acquire load per link followed.
+//
+// Writers are serialized by a mutex.  A new node is fully initialized before
+// it is published with a release store.  Removed nodes are unlinked but not
+// freed, they are queued with their retire epoch and the freeFn/free calls
+// are deferred until the grace period has elapsed.  Updating an element is
+// done by replacing its node with a new copy (rl_replace) so readers never
+// see a half written element.
+//
+// Pointers returned by rl_find, rl_first and rl_next are valid until the
+// reader's next quiescent state.
+///////////////////////////////////////////////////////////////////////////////
+
+// RCU list node
+typedef struct rcuListNode {
+    void *data;                           // node data, immutable once published
+    _Atomic(struct rcuListNode *) next;   // pointer to next node, read by readers
+    struct rcuListNode *prev;             // previous node, writers only, links
+                                          // the retired queue once removed
+    unsigned long retireEpoch;            // grace period the node was removed in
+} rcuListNode;
+
+// RCU list
+typedef struct rcuList {
+    atomic_size_t logicalLength;    // number of nodes in the list
+    size_t elementSize;             // size of each element in bytes
+    _Atomic(rcuListNode *) head;    // pointer to the beginning/head of the list
+    rcuListNode *tail;              // pointer to the end/tail, writers only
+    freeFunction freeFn;            // optional function used to free nodes
+    rcuDomain *domain;              // readers that may access the list
+    pthread_mutex_t writeLock;      // serializes writers
+    rcuListNode *retired;           // removed nodes awaiting a grace period
+    rcuListNode *retiredTail;       // newest removed node
+    size_t retiredCount;            // number of nodes awaiting reclaim
+} rcuList;
+
+// Forward declarations of RCU list operations
+rcuList *rl_create(size_t, freeFunction, rcuDomain *);
+void rl_delete(rcuList *);
+void rl_push(rcuList *, void *);
+void rl_append(rcuList *, void *);
+bool rl_deleteNode(rcuList *, void *, nodeComparator);
+bool rl_replace(rcuList *, void *, void *, nodeComparator);
+size_t rl_reclaim(rcuList *);
+void rl_barrier(rcuList *);
+bool rl_search(rcuList *, void *, nodeComparator);
+const void *rl_find(rcuList *, void *, nodeComparator);
+void rl_foreach(rcuList *, listIterator, displayFunction);
+rcuListNode *rl_first(rcuList *);
+rcuListNode *rl_next(rcuListNode *);
+bool rl_isEmpty(rcuList *);
+size_t rl_length(rcuList *);
+
+#endif
@@ -0,0 +1,53 @@
+/** simd.h - Declarations of vectorized search kernels.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Vectorized search kernels
+//
+// Kernels that search arrays of 32 bit integers many elements at a time,
+// for elements stored contiguously such as the arrays filled by ll_toArray
+// and dll_toArray.  On x86 the fastest implementation the processor
+// supports (AVX2 or SSE2) is picked the first time a kernel is called,
+// elsewhere a scalar implementation is used.  Setting the environment
+// variable LTYPES_SIMD to "sse2" or "scalar" caps the level picked.
+//
+// simd_findInt32 returns the index of the first element equal to the key,
+// or the array length when there is none.  The range kernel counts the
+// elements with lo <= x <= hi.
+///////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations of vectorized search operations
+size_t simd_findInt32(const int32_t *, size_t, int32_t);
+size_t simd_countInt32(const int32_t *, size_t, int32_t);
+size_t simd_countRangeInt32(const int32_t *, size_t, int32_t, int32_t);
+bool simd_minMaxInt32(const int32_t *, size_t, int32_t *, int32_t *);
+const char *simd_level(void);
+
+#endif
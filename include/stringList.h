@@ -0,0 +1,85 @@
+/** stringList.h - Declarations of string list type and operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef STRINGLIST_H
+#define STRINGLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ltypes.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// String list
+//
+// A linkedList of strings stores a char * in each node pointing to a
+// separate strdup'd copy, so comparing an element follows two pointers
+// into two allocations and deleting the list needs freeString.  A string
+// list is a singly linked list that stores the string bytes inline in the
+// node, NUL terminated, together with their length and hash.  Comparing a
+// node against a string checks the length and hash before any bytes, so
+// most mismatches never touch the string, and freeing a node frees its
+// string with it.
+//
+// Strings are passed as a pointer and a length and may contain NUL bytes.
+// Iterators and display functions passed to sl_foreach receive the char *
+// of the string itself, not a char ** as with printStr.
+///////////////////////////////////////////////////////////////////////////////
+
+// String list node, the string bytes follow it in the same block
+typedef struct stringListNode {
+    struct stringListNode *next;  // pointer to the next node in the list
+    uint32_t length;              // length of the string in bytes
+    uint32_t hash;                // hash of the string (hash_fnv1a)
+    char str[];                   // the string, NUL terminated
+} stringListNode;
+
+// String list
+typedef struct stringList {
+    size_t logicalLength;       // number of nodes in the list
+    stringListNode *head;       // pointer to the beginning/head of the list
+    stringListNode *tail;       // pointer to the end/tail of the list
+    bool cached;                // allocate nodes from per-thread caches
+} stringList;
+
+// Forward declarations of string list operations
+stringList *sl_create(void);
+stringList *sl_createCached(void);
+void sl_delete(stringList *);
+stringListNode *sl_push(stringList *, const char *, size_t);
+stringListNode *sl_append(stringList *, const char *, size_t);
+stringListNode *sl_insertAfter(stringList *, stringListNode *, const char *,
+                               size_t);
+bool sl_deleteNode(stringList *, const char *, size_t);
+stringListNode *sl_find(stringList *, const char *, size_t);
+bool sl_search(stringList *, const char *, size_t);
+bool sl_equals(const stringListNode *, const stringListNode *);
+result sl_compare(const stringListNode *, const stringListNode *);
+void sl_foreach(stringList *, listIterator, displayFunction);
+bool sl_removeHead(stringList *);
+stringListNode *sl_first(stringList *);
+stringListNode *sl_last(stringList *);
+bool sl_isEmpty(stringList *);
+size_t sl_length(stringList *);
+void sl_reverse(stringList *);
+
+#endif
@@ -0,0 +1,133 @@
+/** tasks.h - Declarations of a work-stealing task scheduler.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "lists.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Work-stealing task deque
+//
+// A task deque is a Chase-Lev deque, the lock free cousin of a dLinkedList
+// used as a double ended queue.  The owning worker thread pushes and pops
+// tasks at the bottom (like dll_append and removing the tail), while other
+// worker threads steal tasks from the top (like dll_head with remove set).
+//
+// Tasks are stored in a circular array that grows when it fills up.  Arrays
+// replaced by a resize may still be read by a thief, so they are retired to
+// a linkedList and only freed when the deque itself is deleted.
+///////////////////////////////////////////////////////////////////////////////
+
+// Function run by a task
+typedef void (*taskFunction)(void *);
+
+// A unit of work
+typedef struct task {
+    taskFunction fn;            // function to run
+    void *arg;                  // argument passed to fn
+    atomic_bool done;           // set once fn has returned
+    bool detached;              // allocated by ts_submit, freed when finished
+    bool injected;              // queued on the scheduler's injection queue
+} task;
+
+// Circular array of task pointers
+typedef struct taskDequeArray {
+    int64_t capacity;           // number of slots, always a power of two
+    _Atomic(task *) slots[];    // task slots
+} taskDequeArray;
+
+// Chase-Lev work-stealing deque
+typedef struct taskDeque {
+    _Alignas(64) _Atomic int64_t top;   // index thieves steal from
+    _Alignas(64) _Atomic int64_t bottom;// index the owner pushes/pops at
+    _Atomic(taskDequeArray *) array;    // current circular array
+    linkedList *retired;                // arrays replaced by a resize
+} taskDeque;
+
+// Forward declarations of task deque operations
+taskDeque *td_create(void);
+void td_delete(taskDeque *);
+void td_push(taskDeque *, task *);
+task *td_pop(taskDeque *);
+task *td_steal(taskDeque *);
+size_t td_length(taskDeque *);
+
+///////////////////////////////////////////////////////////////////////////////
+// Work-stealing task scheduler
+//
+// A task scheduler owns a fixed set of worker threads, each with its own
+// task deque.  Tasks spawned from a worker go onto that worker's deque, tasks
+// submitted from any other thread go onto a shared injection queue (a
+// dLinkedList guarded by a mutex).  A worker that runs out of work first
+// drains its own deque, then the injection queue, then tries to steal from
+// the other workers before it parks on a condition variable.
+//
+// Fork-join parallelism is expressed with ts_spawn and ts_sync.  The task
+// passed to ts_spawn is owned by the caller, usually on its stack, so
+// spawning does not allocate.  A worker waiting in ts_sync keeps executing
+// other tasks until the one it waits on has finished.
+///////////////////////////////////////////////////////////////////////////////
+
+struct taskScheduler;
+
+// Worker thread state
+typedef struct taskWorker {
+    struct taskScheduler *sched; // scheduler the worker belongs to
+    taskDeque *deque;           // the worker's own tasks
+    pthread_t thread;           // worker thread
+    size_t id;                  // index of the worker in the scheduler
+    unsigned int seed;          // random state used to pick steal victims
+} taskWorker;
+
+// Task scheduler
+typedef struct taskScheduler {
+    size_t nworkers;            // number of worker threads
+    taskWorker *workers;        // worker thread states
+    dLinkedList *injection;     // tasks submitted from outside the workers
+    atomic_size_t injected;     // number of tasks in the injection queue
+    atomic_size_t outstanding;  // detached tasks not yet finished
+    atomic_int sleepers;        // number of parked workers
+    unsigned int epoch;         // bumped under lock when work is published
+    bool shutdown;              // set when the scheduler is being deleted
+    pthread_mutex_t lock;       // guards injection queue, epoch and parking
+    pthread_cond_t wake;        // parked workers wait here
+    pthread_cond_t finished;    // signalled when an injected task finishes
+} taskScheduler;
+
+// Forward declarations of task scheduler operations
+taskScheduler *ts_create(size_t);
+void ts_delete(taskScheduler *);
+void ts_spawn(taskScheduler *, task *, taskFunction, void *);
+void ts_sync(taskScheduler *, task *);
+void ts_run(taskScheduler *, taskFunction, void *);
+void ts_submit(taskScheduler *, taskFunction, void *);
+void ts_wait(taskScheduler *);
+size_t ts_workers(taskScheduler *);
+taskWorker *ts_currentWorker(void);
+
+#endif
@@ -0,0 +1,315 @@
+/** typedList.h - Generator for type specialized singly linked lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TYPEDLIST_H
+#define TYPEDLIST_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "nodeCache.h"
+#include "errors.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Type specialized lists
+//
+// linkedList stores elements behind void pointers and compares them through
+// a nodeComparator, an indirect call the compiler can not inline or
+// optimize around.  LTYPES_DEFINE_LIST(name, type, cmp) instead emits a
+// singly linked list of `type` whose elements are stored inline in the
+// nodes and whose operations are static inline functions prefixed with
+// `name_`, mirroring the ll_ operations.
+//
+// `cmp` is an expression over two elements `a` and `b` of `type`, negative,
+// zero or positive like strcmp.  Elements are equal when it is zero.
+//
+//     LTYPES_DEFINE_LIST(intList, int, LTYPES_COMPARE(a, b))
+//     LTYPES_DEFINE_LIST(strList, char *, strcmp(a, b))
+//
+// The free function, if any, is passed a pointer to the element.  Nodes
+// come from the node allocator (see nodeCache.h) like those of linkedList.
+///////////////////////////////////////////////////////////////////////////////
+
+// Compare two scalars, negative, zero or positive
+#define LTYPES_COMPARE(a, b) (((a) > (b)) - ((a) < (b)))
+
+// Emit a singly linked list of `type` named `name`
+#define LTYPES_DEFINE_LIST(name, type, cmp)                                   \
+/* Singly linked list node, the element is stored inline */                   \
+typedef struct name##_node {                                                  \
+    struct name##_node *next;   /* pointer to the next node in the list */    \
+    type data;                  /* node data */                               \
+} name##_node;                                                                \
+                                                                              \
+/* Singly linked list of type */                                              \
+typedef struct name {                                                         \
+    size_t logicalLength;       /* number of nodes in the list */             \
+    name##_node *head;          /* pointer to the head of the list */         \
+    name##_node *tail;          /* pointer to the tail of the list */         \
+    void (*freeFn)(type *);     /* optional function used to free nodes */    \
+    bool cached;                /* allocate nodes from per-thread caches */   \
+} name;                                                                       \
+                                                                              \
+/* Compare two elements, negative, zero or positive like strcmp */            \
+static inline int name##_compare(type a, type b)                              \
+{                                                                             \
+    return (cmp);                                                             \
+}                                                                             \
+                                                                              \
+/* Create and initialize a list */                                            \
+static inline name *name##_create(void (*fn)(type *))                         \
+{                                                                             \
+    name *l = calloc(1, sizeof(name));                                        \
+    if (!l)                                                                   \
+        error_abort("Unable to allocate " #name);                             \
+                                                                              \
+    l->freeFn = fn;                                                           \
+    l->cached = nc_getDefault();                                              \
+                                                                              \
+    return l;                                                                 \
+}                                                                             \
+                                                                              \
+/* Create and initialize a list taking nodes from per-thread caches */        \
+static inline name *name##_createCached(void (*fn)(type *))                   \
+{                                                                             \
+    name *l = name##_create(fn);                                              \
+    l->cached = true;                                                         \
+                                                                              \
+    return l;                                                                 \
+}                                                                             \
+                                                                              \
+/* Allocate a node holding a copy of el */                                    \
+static inline name##_node *name##_newNode(name *l, type el)                   \
+{                                                                             \
+    name##_node *node = nc_alloc(sizeof(name##_node), l->cached);             \
+    node->next = NULL;                                                        \
+    node->data = el;                                                          \
+                                                                              \
+    return node;                                                              \
+}                                                                             \
+                                                                              \
+/* Free a node and its data */                                                \
+static inline void name##_freeNode(name *l, name##_node *node)                \
+{                                                                             \
+    if (l->freeFn)                                                            \
+        l->freeFn(&node->data);                                               \
+                                                                              \
+    nc_free(node);                                                            \
+}                                                                             \
+                                                                              \
+/* Remove each node from a list and free the list */                          \
+static inline void name##_delete(name *l)                                     \
+{                                                                             \
+    while (l->head) {                                                         \
+        name##_node *curr = l->head;                                          \
+        l->head = curr->next;                                                 \
+        name##_freeNode(l, curr);                                             \
+    }                                                                         \
+                                                                              \
+    free(l);                                                                  \
+}                                                                             \
+                                                                              \
+/* Push a new node to the front of a list */                                  \
+static inline void name##_push(name *l, type el)                              \
+{                                                                             \
+    name##_node *node = name##_newNode(l, el);                                \
+                                                                              \
+    node->next = l->head;                                                     \
+    l->head = node;                                                           \
+    if (!l->tail)                                                             \
+        l->tail = node;                                                       \
+    l->logicalLength++;                                                       \
+}                                                                             \
+                                                                              \
+/* Append a new node to the end of a list */                                  \
+static inline void name##_append(name *l, type el)                            \
+{                                                                             \
+    name##_node *node = name##_newNode(l, el);                                \
+                                                                              \
+    if (l->tail)                                                              \
+        l->tail->next = node;                                                 \
+    else                                                                      \
+        l->head = node;                                                       \
+    l->tail = node;                                                           \
+    l->logicalLength++;                                                       \
+}                                                                             \
+                                                                              \
+/* Insert a new node after a given node */                                    \
+static inline void name##_insertAfter(name *l, name##_node *prev, type el)    \
+{                                                                             \
+    assert(prev);                                                             \
+                                                                              \
+    if (prev == l->tail) {                                                    \
+        name##_append(l, el);                                                 \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    name##_node *node = name##_newNode(l, el);                                \
+    node->next = prev->next;                                                  \
+    prev->next = node;                                                        \
+    l->logicalLength++;                                                       \
+}                                                                             \
+                                                                              \
+/* Delete the first node of a list equal to el */                             \
+static inline void name##_deleteNode(name *l, type el)                        \
+{                                                                             \
+    name##_node *prev = NULL, *curr = l->head;                                \
+                                                                              \
+    for (; curr; prev = curr, curr = curr->next) {                            \
+        if (name##_compare(curr->data, el) == 0) {                            \
+            if (prev)                                                         \
+                prev->next = curr->next;                                      \
+            else                                                              \
+                l->head = curr->next;                                         \
+            if (l->tail == curr)                                              \
+                l->tail = prev;                                               \
+                                                                              \
+            name##_freeNode(l, curr);                                         \
+            l->logicalLength--;                                               \
+            return;                                                           \
+        }                                                                     \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+/* Return the node at a position in the list, counting from 1 */              \
+static inline name##_node *name##_getNodeAt(name *l, size_t index)            \
+{                                                                             \
+    if (index == 0 || index > l->logicalLength)                               \
+        return NULL;                                                          \
+                                                                              \
+    name##_node *curr = l->head;                                              \
+    while (--index)                                                           \
+        curr = curr->next;                                                    \
+                                                                              \
+    return curr;                                                              \
+}                                                                             \
+                                                                              \
+/* Return the first node equal to el, or NULL */                              \
+static inline name##_node *name##_find(name *l, type el)                      \
+{                                                                             \
+    for (name##_node *curr = l->head; curr; curr = curr->next)                \
+        if (name##_compare(curr->data, el) == 0)                              \
+            return curr;                                                      \
+                                                                              \
+    return NULL;                                                              \
+}                                                                             \
+                                                                              \
+/* Search a list for a node equal to el */                                    \
+static inline bool name##_search(name *l, type el)                            \
+{                                                                             \
+    return name##_find(l, el) != NULL;                                        \
+}                                                                             \
+                                                                              \
+/* Call it on each element until it returns false */                          \
+static inline void name##_foreach(name *l, bool (*it)(type *, void *),        \
+                                  void *ctx)                                  \
+{                                                                             \
+    for (name##_node *curr = l->head; curr; curr = curr->next)                \
+        if (!it(&curr->data, ctx))                                            \
+            return;                                                           \
+}                                                                             \
+                                                                              \
+/* Copy the head element and optionally remove/pop it from the list */        \
+static inline void name##_head(name *l, type *el, bool remove)                \
+{                                                                             \
+    assert(l->head);                                                          \
+                                                                              \
+    name##_node *node = l->head;                                              \
+    *el = node->data;                                                         \
+                                                                              \
+    if (remove) {                                                             \
+        l->head = node->next;                                                 \
+        if (!l->head)                                                         \
+            l->tail = NULL;                                                   \
+                                                                              \
+        name##_freeNode(l, node);                                             \
+        l->logicalLength--;                                                   \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+/* Return the head node of a list */                                          \
+static inline name##_node *name##_first(name *l)                              \
+{                                                                             \
+    return l->head;                                                           \
+}                                                                             \
+                                                                              \
+/* Copy the tail element */                                                   \
+static inline void name##_tail(name *l, type *el)                             \
+{                                                                             \
+    assert(l->tail);                                                          \
+                                                                              \
+    *el = l->tail->data;                                                      \
+}                                                                             \
+                                                                              \
+/* Return the tail node of a list */                                          \
+static inline name##_node *name##_last(name *l)                               \
+{                                                                             \
+    return l->tail;                                                           \
+}                                                                             \
+                                                                              \
+/* Return true if the list is empty */                                        \
+static inline bool name##_isEmpty(name *l)                                    \
+{                                                                             \
+    return l->logicalLength == 0;                                             \
+}                                                                             \
+                                                                              \
+/* Return the number of nodes in a list */                                    \
+static inline size_t name##_length(name *l)                                   \
+{                                                                             \
+    return l->logicalLength;                                                  \
+}                                                                             \
+                                                                              \
+/* Reverse the node order of a list */                                        \
+static inline void name##_reverse(name *l)                                    \
+{                                                                             \
+    name##_node *prev = NULL, *curr = l->head;                                \
+                                                                              \
+    l->tail = l->head;                                                        \
+    while (curr) {                                                            \
+        name##_node *next = curr->next;                                       \
+        curr->next = prev;                                                    \
+        prev = curr;                                                          \
+        curr = next;                                                          \
+    }                                                                         \
+    l->head = prev;                                                           \
+}                                                                             \
+                                                                              \
+/* Selection sort that compares elements inline and swaps node data */        \
+static inline void name##_selectionSort(name *l)                              \
+{                                                                             \
+    for (name##_node *start = l->head; start; start = start->next) {          \
+        name##_node *min = start;                                             \
+                                                                              \
+        for (name##_node *curr = start->next; curr; curr = curr->next)        \
+            if (name##_compare(min->data, curr->data) > 0)                    \
+                min = curr;                                                   \
+                                                                              \
+        if (min != start) {                                                   \
+            type tmp = start->data;                                           \
+            start->data = min->data;                                          \
+            min->data = tmp;                                                  \
+        }                                                                     \
+    }                                                                         \
+}
+
+#endif
@@ -0,0 +1,93 @@
+/** xorList.h - Declarations of XOR linked list type and operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XORLIST_H
+#define XORLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ltypes.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// XOR linked list
+//
+// An XOR linked list is a doubly linked list whose nodes store a single
+// link, the addresses of the previous and next nodes XORed together.
+// Walking from either end, the address of the node just left is XORed with
+// the link to find the next one, so the list can be traversed in both
+// directions with half the link overhead of a dLinkedListNode.  The node
+// does not need a data pointer either, the element data follows the link
+// in the same block.  To keep nodes small the data is only aligned for
+// pointer sized types, not for max_align_t as in the other lists.
+//
+// Because a node alone does not say where its neighbours are, nodes are
+// reached through cursors, which remember the node before the current one.
+// Reversing the list only swaps its head and tail.
+///////////////////////////////////////////////////////////////////////////////
+
+// XOR linked list node, the element data follows it in the same block
+typedef struct xLinkedListNode {
+    uintptr_t link;             // address of previous XOR address of next
+} xLinkedListNode;
+
+// XOR linked list
+typedef struct xLinkedList {
+    size_t logicalLength;       // number of nodes in the list
+    size_t elementSize;         // size of each element in bytes
+    xLinkedListNode *head;      // pointer to the beginning/head of the list
+    xLinkedListNode *tail;      // pointer to the end/tail of the list
+    freeFunction freeFn;        // optional function used to free nodes
+    bool cached;                // allocate nodes from per-thread caches
+} xLinkedList;
+
+// Position within an XOR linked list
+typedef struct xlCursor {
+    xLinkedListNode *prev;      // node before the current node
+    xLinkedListNode *curr;      // current node, NULL past either end
+} xlCursor;
+
+// Forward declarations of XOR linked list operations
+xLinkedList *xl_create(size_t, freeFunction);
+xLinkedList *xl_createCached(size_t, freeFunction);
+void xl_delete(xLinkedList *);
+void xl_push(xLinkedList *, void *);
+void xl_append(xLinkedList *, void *);
+void xl_insertAfter(xLinkedList *, xlCursor *, void *);
+void xl_insertBefore(xLinkedList *, xlCursor *, void *);
+void xl_deleteNode(xLinkedList *, void *, nodeComparator);
+void xl_removeAt(xLinkedList *, xlCursor *);
+bool xl_search(xLinkedList *, void *, nodeComparator);
+void xl_foreach(xLinkedList *, listIterator, displayFunction);
+void xl_head(xLinkedList *, void *, bool);
+void xl_tail(xLinkedList *, void *, bool);
+bool xl_isEmpty(xLinkedList *);
+size_t xl_length(xLinkedList *);
+void xl_reverse(xLinkedList *);
+xlCursor xl_first(xLinkedList *);
+xlCursor xl_last(xLinkedList *);
+bool xl_valid(xlCursor *);
+void xl_next(xlCursor *);
+void xl_prev(xlCursor *);
+void *xl_data(xlCursor *);
+
+#endif
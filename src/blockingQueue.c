@@ -0,0 +1,338 @@
+/** blockingQueue.c - Bounded blocking queue implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include "queues.h"
+#include "errors.h"
+
+/**
+ * bq_create:
+ *      Create and initialize a blocking queue holding at most `capacity`
+ *      elements of `size` bytes.
+ *      Returns the queue.
+ */
+blockingQueue *bq_create(size_t size, size_t capacity, freeFunction fn)
+{
+    assert(size && capacity);
+
+    // Allocate queue
+    blockingQueue *q = calloc(1, sizeof(blockingQueue));
+    if (!q)
+        error_abort("Unable to allocate blockingQueue");
+
+    if (!(q->buffer = calloc(capacity, size)))
+        error_abort("Unable to allocate blockingQueue buffer");
+
+    // Initialize queue
+    q->logicalLength = 0;
+    q->elementSize = size;
+    q->capacity = capacity;
+    q->head = 0;
+    q->freeFn = fn;
+    q->closed = false;
+    q->waitingProducers = q->waitingConsumers = 0;
+    pthread_mutex_init(&q->lock, NULL);
+
+    // Timeouts are measured against the monotonic clock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->notFull, &attr);
+    pthread_cond_init(&q->notEmpty, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return q;                   // return new queue
+}
+
+/**
+ * bq_delete:
+ *      Free a queue, passing any elements left in it to the freeFunction.
+ *      No thread may be waiting on the queue.
+ */
+void bq_delete(blockingQueue *q)
+{
+    // Free leftover elements
+    if (q->freeFn) {
+        for (size_t i = 0; i < q->logicalLength; i++) {
+            size_t slot = (q->head + i) % q->capacity;
+            q->freeFn(q->buffer + slot * q->elementSize);
+        }
+    }
+
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->notFull);
+    pthread_cond_destroy(&q->notEmpty);
+    free(q->buffer);
+    free(q);
+}
+
+/**
+ * bq_deadline:
+ *      Convert a relative timeout in milliseconds to an absolute time.
+ */
+static struct timespec bq_deadline(long timeoutMs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeoutMs / 1000;
+    ts.tv_nsec += (timeoutMs % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return ts;
+}
+
+/**
+ * bq_wait:
+ *      Wait on a condition until signalled or the deadline passes.
+ *      Returns false on timeout.  Lock must be held.
+ */
+static bool bq_wait(blockingQueue *q, pthread_cond_t *cond,
+                    long timeoutMs, struct timespec *deadline)
+{
+    if (timeoutMs == 0)
+        return false;
+
+    if (timeoutMs < 0) {
+        pthread_cond_wait(cond, &q->lock);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, &q->lock, deadline) != ETIMEDOUT;
+}
+
+/**
+ * bq_copyIn:
+ *      Copy up to `n` elements into the free slots of a queue.
+ *      Returns the number copied.  Lock must be held.
+ */
+static size_t bq_copyIn(blockingQueue *q, unsigned char *els, size_t n)
+{
+    size_t count = q->capacity - q->logicalLength;
+    if (count > n)
+        count = n;
+
+    // Copy in at most two runs, before and after the buffer wraps
+    size_t tail = (q->head + q->logicalLength) % q->capacity;
+    size_t first = q->capacity - tail;
+    if (first > count)
+        first = count;
+
+    memcpy(q->buffer + tail * q->elementSize, els, first * q->elementSize);
+    memcpy(q->buffer, els + first * q->elementSize,
+           (count - first) * q->elementSize);
+    q->logicalLength += count;
+
+    return count;
+}
+
+/**
+ * bq_copyOut:
+ *      Copy up to `n` of the oldest elements out of a queue.
+ *      Returns the number copied.  Lock must be held.
+ */
+static size_t bq_copyOut(blockingQueue *q, unsigned char *els, size_t n)
+{
+    size_t count = q->logicalLength < n ? q->logicalLength : n;
+
+    // Copy out at most two runs, before and after the buffer wraps
+    size_t first = q->capacity - q->head;
+    if (first > count)
+        first = count;
+
+    memcpy(els, q->buffer + q->head * q->elementSize, first * q->elementSize);
+    memcpy(els + first * q->elementSize, q->buffer,
+           (count - first) * q->elementSize);
+    q->head = (q->head + count) % q->capacity;
+    q->logicalLength -= count;
+
+    return count;
+}
+
+/**
+ * bq_enqueueBatch:
+ *      Enqueue up to `n` contiguous elements, blocking while the queue is
+ *      full until the timeout expires or the queue is closed.
+ *      Returns the number of elements enqueued.
+ */
+size_t bq_enqueueBatch(blockingQueue *q, void *els, size_t n, long timeoutMs)
+{
+    struct timespec deadline = { 0, 0 };
+    size_t done = 0;
+
+    if (timeoutMs > 0)
+        deadline = bq_deadline(timeoutMs);
+
+    pthread_mutex_lock(&q->lock);
+
+    while (done < n && !q->closed) {
+        size_t count = bq_copyIn(q, (unsigned char *)els +
+                                 done * q->elementSize, n - done);
+        done += count;
+
+        // Wake consumers for what was just added
+        if (count && q->waitingConsumers) {
+            if (count > 1)
+                pthread_cond_broadcast(&q->notEmpty);
+            else
+                pthread_cond_signal(&q->notEmpty);
+        }
+
+        if (done == n)
+            break;
+
+        // Queue is full, apply backpressure
+        q->waitingProducers++;
+        bool signalled = bq_wait(q, &q->notFull, timeoutMs, &deadline);
+        q->waitingProducers--;
+
+        if (!signalled && q->logicalLength == q->capacity)
+            break;              // timed out
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    return done;
+}
+
+/**
+ * bq_enqueue:
+ *      Enqueue one element.  Returns false on timeout or if the queue
+ *      is closed.
+ */
+bool bq_enqueue(blockingQueue *q, void *el, long timeoutMs)
+{
+    return bq_enqueueBatch(q, el, 1, timeoutMs) == 1;
+}
+
+/**
+ * bq_dequeueBatch:
+ *      Dequeue up to `max` elements into `els`, blocking while the queue
+ *      is empty until at least one element arrives, the timeout expires,
+ *      or the queue is closed.
+ *      Returns the number of elements dequeued, 0 on timeout or once a
+ *      closed queue has been drained.
+ */
+size_t bq_dequeueBatch(blockingQueue *q, void *els, size_t max, long timeoutMs)
+{
+    struct timespec deadline = { 0, 0 };
+    size_t count = 0;
+
+    if (timeoutMs > 0)
+        deadline = bq_deadline(timeoutMs);
+
+    pthread_mutex_lock(&q->lock);
+
+    while (q->logicalLength == 0 && !q->closed) {
+        q->waitingConsumers++;
+        bool signalled = bq_wait(q, &q->notEmpty, timeoutMs, &deadline);
+        q->waitingConsumers--;
+
+        if (!signalled)
+            break;              // timed out
+    }
+
+    count = bq_copyOut(q, els, max);
+
+    // Wake producers blocked on a full queue
+    if (count && q->waitingProducers) {
+        if (count > 1)
+            pthread_cond_broadcast(&q->notFull);
+        else
+            pthread_cond_signal(&q->notFull);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    return count;
+}
+
+/**
+ * bq_dequeue:
+ *      Dequeue one element.  Returns false on timeout or once a closed
+ *      queue has been drained.
+ */
+bool bq_dequeue(blockingQueue *q, void *el, long timeoutMs)
+{
+    return bq_dequeueBatch(q, el, 1, timeoutMs) == 1;
+}
+
+/**
+ * bq_close:
+ *      Close a queue and wake every waiting producer and consumer.
+ */
+void bq_close(blockingQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    pthread_cond_broadcast(&q->notFull);
+    pthread_cond_broadcast(&q->notEmpty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * bq_isClosed:
+ *      Return true if the queue has been closed.
+ */
+bool bq_isClosed(blockingQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    bool closed = q->closed;
+    pthread_mutex_unlock(&q->lock);
+
+    return closed;
+}
+
+/**
+ * bq_isDrained:
+ *      Return true if the queue is closed and empty.
+ */
+bool bq_isDrained(blockingQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    bool drained = q->closed && q->logicalLength == 0;
+    pthread_mutex_unlock(&q->lock);
+
+    return drained;
+}
+
+/**
+ * bq_length:
+ *      Return the number of elements in the queue.
+ */
+size_t bq_length(blockingQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    size_t len = q->logicalLength;
+    pthread_mutex_unlock(&q->lock);
+
+    return len;
+}
@@ -0,0 +1,576 @@
+/** compactList.c - Compact index linked list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "compactList.h"
+#include "errors.h"
+
+#define CL_MIN_CAPACITY 16      // slots allocated by the first insert
+
+// Links at the start of every slot, the element follows
+typedef struct clLinks {
+    uint32_t prev;              // index of previous node, next free slot
+    uint32_t next;              // index of next node
+} clLinks;
+
+// Offset of a node's data within its slot
+#define CL_DATA_OFFSET sizeof(clLinks)
+
+/**
+ * cl_links:
+ *      Return the links of the slot at index `i`.
+ */
+static inline clLinks *cl_links(compactList *l, uint32_t i)
+{
+    return (clLinks *)(l->slots + (size_t)i * l->slotSize);
+}
+
+/**
+ * cl_create:
+ *      Create and initialize a compact list.
+ *      Returns the list.
+ */
+compactList *cl_create(size_t size, freeFunction fn)
+{
+    // Allocate list
+    compactList *l = calloc(1, sizeof(compactList));
+    if (!l)
+        error_abort("Unable to allocate compactList");
+
+    // Initialize list, slots keep elements 8 byte aligned
+    l->logicalLength = 0;
+    l->elementSize = size;
+    l->slotSize = (CL_DATA_OFFSET + size + 7) & ~(size_t)7;
+    l->capacity = l->used = 0;
+    l->head = l->tail = l->freeSlots = CL_NIL;
+    l->slots = NULL;
+    l->freeFn = fn;
+
+    return l;                   // return new list
+}
+
+/**
+ * cl_delete:
+ *      Remove each node from a list and free the list.
+ */
+void cl_delete(compactList *l)
+{
+    // Use freeFunction on each element if it exists
+    if (l->freeFn)
+        for (uint32_t i = l->head; i != CL_NIL; i = cl_links(l, i)->next)
+            l->freeFn(cl_data(l, i));
+
+    free(l->slots);
+    free(l);
+}
+
+/**
+ * cl_reserve:
+ *      Grow the slot array to hold at least `n` nodes.
+ */
+void cl_reserve(compactList *l, size_t n)
+{
+    if (n <= l->capacity)
+        return;
+
+    if (n >= CL_NIL)
+        error_abort("compactList can not hold %zu nodes", n);
+
+    unsigned char *slots = realloc(l->slots, n * l->slotSize);
+    if (!slots)
+        error_abort("Unable to allocate compactList slots");
+
+    l->slots = slots;
+    l->capacity = (uint32_t)n;
+}
+
+/**
+ * cl_newNode:
+ *      Take a slot from the free list, or a new one, and copy `el` in.
+ *      Returns the slot's index.
+ */
+static uint32_t cl_newNode(compactList *l, void *el)
+{
+    uint32_t i = l->freeSlots;
+
+    if (i != CL_NIL) {
+        l->freeSlots = cl_links(l, i)->prev;
+    } else {
+        // Double the array when every slot has been handed out
+        if (l->used == l->capacity) {
+            size_t n = l->capacity ? (size_t)l->capacity * 2 : CL_MIN_CAPACITY;
+            if (n >= CL_NIL)
+                n = CL_NIL - 1;
+            if (n == l->capacity)
+                error_abort("compactList is full");
+            cl_reserve(l, n);
+        }
+        i = l->used++;
+    }
+
+    memcpy(cl_data(l, i), el, l->elementSize);
+
+    return i;
+}
+
+/**
+ * cl_unlink:
+ *      Unlink a node from the list and put its slot on the free list,
+ *      the element is not freed.
+ */
+static void cl_unlink(compactList *l, uint32_t i)
+{
+    clLinks *node = cl_links(l, i);
+
+    if (node->prev != CL_NIL)
+        cl_links(l, node->prev)->next = node->next;
+    else
+        l->head = node->next;
+
+    if (node->next != CL_NIL)
+        cl_links(l, node->next)->prev = node->prev;
+    else
+        l->tail = node->prev;
+
+    node->next = CL_NIL;
+    node->prev = l->freeSlots;
+    l->freeSlots = i;
+    l->logicalLength--;         // decrease list's logical length
+}
+
+/**
+ * cl_push:
+ *      Push a new node to the front of a list.
+ *      Returns the new node's index.
+ */
+uint32_t cl_push(compactList *l, void *el)
+{
+    uint32_t i = cl_newNode(l, el);
+    clLinks *node = cl_links(l, i);
+
+    // Set new node links
+    node->prev = CL_NIL;
+    node->next = l->head;
+    if (l->head != CL_NIL)
+        cl_links(l, l->head)->prev = i;
+    else
+        l->tail = i;
+
+    l->head = i;
+    l->logicalLength++;         // increase list's logical length
+
+    return i;
+}
+
+/**
+ * cl_append:
+ *      Append a new node to the end of a list.
+ *      Returns the new node's index.
+ */
+uint32_t cl_append(compactList *l, void *el)
+{
+    uint32_t i = cl_newNode(l, el);
+    clLinks *node = cl_links(l, i);
+
+    // Set new node links
+    node->next = CL_NIL;
+    node->prev = l->tail;
+    if (l->tail != CL_NIL)
+        cl_links(l, l->tail)->next = i;
+    else
+        l->head = i;
+
+    l->tail = i;
+    l->logicalLength++;         // increase list's logical length
+
+    return i;
+}
+
+/**
+ * cl_insertAfter:
+ *      Insert a new node after a given node.
+ *      Returns the new node's index.
+ */
+uint32_t cl_insertAfter(compactList *l, uint32_t prev, void *el)
+{
+    assert(prev < l->used);
+
+    // Use append method if prev is list tail
+    if (prev == l->tail)
+        return cl_append(l, el);
+
+    uint32_t i = cl_newNode(l, el);
+    clLinks *node = cl_links(l, i), *p = cl_links(l, prev);
+
+    // Set new node links
+    node->prev = prev;
+    node->next = p->next;
+    cl_links(l, p->next)->prev = i;
+    p->next = i;
+    l->logicalLength++;         // increase list's logical length
+
+    return i;
+}
+
+/**
+ * cl_insertBefore:
+ *      Insert a new node before a given node.
+ *      Returns the new node's index.
+ */
+uint32_t cl_insertBefore(compactList *l, uint32_t next, void *el)
+{
+    assert(next < l->used);
+
+    // Use push method if next is list head
+    if (next == l->head)
+        return cl_push(l, el);
+
+    uint32_t i = cl_newNode(l, el);
+    clLinks *node = cl_links(l, i), *n = cl_links(l, next);
+
+    // Set new node links
+    node->next = next;
+    node->prev = n->prev;
+    cl_links(l, n->prev)->next = i;
+    n->prev = i;
+    l->logicalLength++;         // increase list's logical length
+
+    return i;
+}
+
+/**
+ * cl_deleteNode:
+ *      Delete a node from a list containing value `data`.
+ */
+void cl_deleteNode(compactList *l, void *data, nodeComparator cmp)
+{
+    // Assert that a node compare function was provided
+    assert(cmp);
+
+    // Traverse the list looking for the node to delete
+    for (uint32_t i = l->head; i != CL_NIL; i = cl_links(l, i)->next) {
+        if (cmp(cl_data(l, i), data) == EQUAL) {
+            cl_removeAt(l, i);
+            return;
+        }
+    }
+}
+
+/**
+ * cl_removeAt:
+ *      Remove the node at index `i` from a list.
+ */
+void cl_removeAt(compactList *l, uint32_t i)
+{
+    assert(i < l->used);
+
+    // Use freeFunction if it exists
+    if (l->freeFn)
+        l->freeFn(cl_data(l, i));
+
+    cl_unlink(l, i);
+}
+
+/**
+ * cl_getNodeAt:
+ *      Return the index of the node at given position in list, positions
+ *      count from 1 as with ll_getNodeAt.
+ */
+uint32_t cl_getNodeAt(compactList *l, size_t index)
+{
+    // Return CL_NIL if index given is outside the list
+    if (index == 0 || index > l->logicalLength)
+        return CL_NIL;
+
+    // Walk from whichever end is nearer
+    uint32_t i;
+    if (--index < l->logicalLength / 2) {
+        for (i = l->head; index--; )
+            i = cl_links(l, i)->next;
+    } else {
+        index = l->logicalLength - 1 - index;
+        for (i = l->tail; index--; )
+            i = cl_links(l, i)->prev;
+    }
+
+    return i;
+}
+
+/**
+ * cl_search:
+ *      Search a list for a node containing `data`.
+ */
+bool cl_search(compactList *l, void *data, nodeComparator cmp)
+{
+    // Assert that a node compare function was provided
+    assert(cmp);
+
+    for (uint32_t i = l->head; i != CL_NIL; i = cl_links(l, i)->next)
+        if (cmp(cl_data(l, i), data) == EQUAL)
+            return true;
+
+    return false;
+}
+
+/**
+ * cl_foreach:
+ *      Iterate over a compact list and perform the tasks in the
+ *      listIterator function on each node.
+ */
+void cl_foreach(compactList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    uint32_t i = l->head;
+    bool result = true;
+
+    // Iterate over the list
+    while (i != CL_NIL && result) {
+        result = it(cl_data(l, i), display);
+        i = cl_links(l, i)->next;
+    }
+}
+
+/**
+ * cl_head:
+ *      Return a copy of the head node's data of a compact list and
+ *      optionally remove/pop it from the list.
+ */
+void cl_head(compactList *l, void *el, bool remove)
+{
+    // Assert that the list is not empty
+    assert(l->head != CL_NIL);
+
+    // Copy the list's head to a new element
+    memcpy(el, cl_data(l, l->head), l->elementSize);
+
+    // Remove/pop head node from list
+    if (remove)
+        cl_removeAt(l, l->head);
+}
+
+/**
+ * cl_first:
+ *      Return the index of the head node of a compact list.
+ */
+uint32_t cl_first(compactList *l)
+{
+    return l->head;
+}
+
+/**
+ * cl_tail:
+ *      Return a copy of the tail node's data of a compact list.
+ */
+void cl_tail(compactList *l, void *el)
+{
+    // Assert that the list is not empty
+    assert(l->tail != CL_NIL);
+
+    // Copy the list's tail to a new element
+    memcpy(el, cl_data(l, l->tail), l->elementSize);
+}
+
+/**
+ * cl_last:
+ *      Return the index of the tail node of a compact list.
+ */
+uint32_t cl_last(compactList *l)
+{
+    return l->tail;
+}
+
+/**
+ * cl_next:
+ *      Return the index of the node following node `i`.
+ */
+uint32_t cl_next(compactList *l, uint32_t i)
+{
+    return cl_links(l, i)->next;
+}
+
+/**
+ * cl_prev:
+ *      Return the index of the node preceding node `i`.
+ */
+uint32_t cl_prev(compactList *l, uint32_t i)
+{
+    return cl_links(l, i)->prev;
+}
+
+/**
+ * cl_data:
+ *      Return a pointer to the data of node `i`, valid until the list grows.
+ */
+void *cl_data(compactList *l, uint32_t i)
+{
+    return l->slots + (size_t)i * l->slotSize + CL_DATA_OFFSET;
+}
+
+/**
+ * cl_isEmpty:
+ *      Return true if the compact list is empty, return false otherwise.
+ */
+bool cl_isEmpty(compactList *l)
+{
+    return l->logicalLength == 0;
+}
+
+/**
+ * cl_length:
+ *      Return the number of nodes in a compact list.
+ */
+size_t cl_length(compactList *l)
+{
+    return l->logicalLength;
+}
+
+/**
+ * cl_reverse:
+ *      Reverse the node order of a compact list.
+ */
+void cl_reverse(compactList *l)
+{
+    uint32_t i = l->head;
+
+    // Swap every node's links
+    while (i != CL_NIL) {
+        clLinks *node = cl_links(l, i);
+        uint32_t next = node->next;
+        node->next = node->prev;
+        node->prev = next;
+        i = next;
+    }
+
+    // Swap list head and tail
+    i = l->head;
+    l->head = l->tail;
+    l->tail = i;
+}
+
+/**
+ * cl_swapNodeData:
+ *      Swap the data of two nodes in a list.
+ */
+void cl_swapNodeData(compactList *l, uint32_t a, uint32_t b)
+{
+    if (a == b)
+        return;
+
+    // Swap data a byte at a time, the slots are already in hand
+    unsigned char *x = cl_data(l, a), *y = cl_data(l, b);
+    for (size_t n = 0; n < l->elementSize; n++) {
+        unsigned char tmp = x[n];
+        x[n] = y[n];
+        y[n] = tmp;
+    }
+}
+
+/**
+ * cl_selectionSort:
+ *      Selection sort that iterates the list using a node comparator
+ *      function and swaps node data.
+ */
+void cl_selectionSort(compactList *l, nodeComparator cmp)
+{
+    assert(cmp);
+
+    for (uint32_t start = l->head; start != CL_NIL;
+         start = cl_links(l, start)->next) {
+        uint32_t min = start;
+
+        // Find the lowest value from start in the list
+        for (uint32_t i = cl_links(l, start)->next; i != CL_NIL;
+             i = cl_links(l, i)->next)
+            if (cmp(cl_data(l, min), cl_data(l, i)) == GREATER)
+                min = i;
+
+        // Swap start with lowest value found
+        cl_swapNodeData(l, start, min);
+    }
+}
+
+/**
+ * cl_split:
+ *      Split a list into two halves.  If there is an odd number of nodes
+ *      in the original list it goes into the first half, the second half
+ *      is moved to a new compact list which is returned.
+ */
+compactList *cl_split(compactList *a)
+{
+    if (a->logicalLength <= 1)
+        return NULL;
+
+    // Find the first node of the second half
+    uint32_t i = cl_getNodeAt(a, (a->logicalLength + 1) / 2 + 1);
+
+    // Create a new list and move the second half into it
+    compactList *b = cl_create(a->elementSize, a->freeFn);
+    cl_reserve(b, a->logicalLength / 2);
+
+    while (i != CL_NIL) {
+        uint32_t next = cl_links(a, i)->next;
+        cl_append(b, cl_data(a, i));
+        cl_unlink(a, i);
+        i = next;
+    }
+
+    return b;                   // return the second half of the list
+}
+
+/**
+ * cl_compact:
+ *      Rewrite a list's slots in list order and release free slots, so
+ *      that traversal walks the array sequentially.  Invalidates every
+ *      node index.
+ */
+void cl_compact(compactList *l)
+{
+    size_t n = l->logicalLength;
+    unsigned char *slots = NULL;
+
+    if (n) {
+        if (!(slots = malloc(n * l->slotSize)))
+            error_abort("Unable to allocate compactList slots");
+
+        // Copy each node to its position and link it to its neighbours
+        uint32_t i = l->head;
+        for (uint32_t pos = 0; pos < n; pos++, i = cl_links(l, i)->next) {
+            unsigned char *slot = slots + (size_t)pos * l->slotSize;
+            memcpy(slot, l->slots + (size_t)i * l->slotSize, l->slotSize);
+            ((clLinks *)slot)->prev = pos ? pos - 1 : CL_NIL;
+            ((clLinks *)slot)->next = pos + 1 < n ? pos + 1 : CL_NIL;
+        }
+    }
+
+    free(l->slots);
+    l->slots = slots;
+    l->capacity = l->used = (uint32_t)n;
+    l->head = n ? 0 : CL_NIL;
+    l->tail = n ? (uint32_t)n - 1 : CL_NIL;
+    l->freeSlots = CL_NIL;
+}
@@ -26,8 +26,18 @@ SOFTWARE.
 #include <string.h>
 #include <assert.h>
 #include "lists.h"
+#include "nodeCache.h"
 #include "errors.h"
 
+// Offset of a node's data within its block
+#define DLL_DATA_OFFSET NC_ALIGN(sizeof(dLinkedListNode))
+
+// Default number of elements handed to a batch iterator at a time
+#define DLL_BATCH 64
+
+// Bytes of nodes moved into each run by compaction
+#define DLL_COMPACT_RUN (256 * 1024)
+
 /**
  * dll_create:
  *      Create and initialize a doubly linked list.
@@ -45,10 +55,56 @@ dLinkedList *dll_create(size_t size, freeFunction fn)
     l->elementSize = size;
     l->head = l->tail = NULL;
     l->freeFn = fn;
+    l->cached = nc_getDefault();
 
     return l;                   // return new list
 }
 
+/**
+ * dll_createCached:
+ *      Create and initialize a doubly linked list whose nodes are
+ *      allocated from per-thread node caches.
+ *      Returns the list.
+ */
+dLinkedList *dll_createCached(size_t size, freeFunction fn)
+{
+    dLinkedList *l = dll_create(size, fn);
+    l->cached = true;
+
+    return l;                   // return new list
+}
+
+/**
+ * dll_newNode:
+ *      Allocate a node holding a copy of `el`, the node and its data
+ *      share a single block.
+ */
+static dLinkedListNode *dll_newNode(dLinkedList *l, void *el)
+{
+    dLinkedListNode *node = nc_alloc(DLL_DATA_OFFSET + l->elementSize,
+                                     l->cached);
+
+    // Copy new data into node
+    node->data = (char *)node + DLL_DATA_OFFSET;
+    memcpy(node->data, el, l->elementSize);
+    node->prev = node->next = NULL;
+
+    return node;
+}
+
+/**
+ * dll_freeNode:
+ *      Free a node and its data.
+ */
+static void dll_freeNode(dLinkedList *l, dLinkedListNode *node)
+{
+    // Use freeFunction if it exists
+    if (l->freeFn)
+        l->freeFn(node->data);
+
+    nc_free(node);
+}
+
 /**
  * dll_delete:
  *      Remove each node from a list.
@@ -62,12 +118,7 @@ void dll_delete(dLinkedList *l)
         curr = l->head;
         l->head = curr->next;
 
-        // Free node
-        if (l->freeFn)
-            l->freeFn(curr->data);
-
-        free(curr->data);
-        free(curr);
+        dll_freeNode(l, curr);  // free node
         l->logicalLength--;     // decrease list's logical length
     }
 
@@ -82,23 +133,15 @@ void dll_delete(dLinkedList *l)
  */
 void dll_push(dLinkedList *l, void *el)
 {
-    // Allocate memory for new list node
-    dLinkedListNode *node = calloc(1, sizeof(dLinkedListNode));
-    if (!node)
-        error_abort("unable to allocate memory for node");
-
-    node->prev = NULL;
-
-    // Allocate memory for new node's data
-    if ((node->data = calloc(1, l->elementSize)) == NULL)
-        error_abort("unable to allocate memory for node");
-
-    // Copy new data to node
-    memcpy(node->data, el, l->elementSize);
+    // Allocate a new list node holding a copy of el
+    dLinkedListNode *node = dll_newNode(l, el);
 
     // Set node as new list head
     node->next = l->head;
-    l->head ->prev = node;
+    if (l->head)
+        l->head->prev = node;
+    else
+        l->tail = node;
     l->head = node;
     l->logicalLength++;         // increase list's logical length
 }
@@ -109,23 +152,12 @@ void dll_push(dLinkedList *l, void *el)
  */
 void dll_append(dLinkedList *l, void *el)
 {
-    // Allocate memory for a new node
-    dLinkedListNode *node = calloc(1, sizeof(dLinkedListNode));
-    if (!node)
-        error_abort("unable to allocate memory for node");
-
-    // Allocate memory for the new node's data
-    if ((node->data = calloc(1, l->elementSize)) == NULL)
-        error_abort("unable to allocate memory for node");
-
-    // Copy data into node
-    memcpy(node->data, el, l->elementSize);
+    // Allocate a new node holding a copy of el
+    dLinkedListNode *node = dll_newNode(l, el);
 
     // Reset node links
     if (l->logicalLength == 0) { // empty list
         l->head = l->tail = node;
-        l->head->prev = l->tail->next = NULL;
-        l->tail->prev = l->head;
     } else {
         l->tail->next = node;
         node->prev = l->tail;
@@ -150,17 +182,8 @@ void dll_insertAfter(dLinkedList *l, dLinkedListNode *prev, void *el)
         return;
     }
 
-    // Allocate memory for the new node
-    dLinkedListNode *node = calloc(1, sizeof(dLinkedListNode));
-    if (!node)
-        error_abort("Unable to allocate memory for new node");
-
-    // Allocate memory for the new node's data
-    if (!(node->data = calloc(1, l->elementSize)))
-        error_abort("unable to allocate memory for node");
-
-    // Copy data into node
-    memcpy(node->data, el, l->elementSize); // copy data
+    // Allocate a new node holding a copy of el
+    dLinkedListNode *node = dll_newNode(l, el);
 
     // Set new node links
     node->next = prev->next;
@@ -184,17 +207,8 @@ void dll_insertBefore(dLinkedList *l, dLinkedListNode *next, void *el)
         return;
     }
 
-    // Allocate memory for the new node
-    dLinkedListNode *node = calloc(1, sizeof(dLinkedListNode));
-    if (!node)
-        error_abort("Unable to allocate memory for new node");
-
-    // Allocate memory for the new node's data
-    if (!(node->data = calloc(1, l->elementSize)))
-        error_abort("unable to allocate memory for node");
-
-    // Copy data into node
-    memcpy(node->data, el, l->elementSize); // copy data
+    // Allocate a new node holding a copy of el
+    dLinkedListNode *node = dll_newNode(l, el);
 
     // Set new node links
     node->prev = next->prev;
@@ -218,19 +232,17 @@ void dll_deleteNode(dLinkedList *l, void *data, nodeComparator cmp)
     // Traverse the list looking for the node to delete
     while (entry) {
         if (cmp(entry->data, data) == EQUAL) { // compare entry data to data
-            // Reset node links
-            if (entry == l->head)
-                entry = entry->next;
-            if (entry->next)
-                entry->next->prev = entry->prev;
+            // Reset node links, including the list's head/tail
             if (entry->prev)
                 entry->prev->next = entry->next;
+            else
+                l->head = entry->next;
+            if (entry->next)
+                entry->next->prev = entry->prev;
+            else
+                l->tail = entry->prev;
 
-            // Free node data and node itself
-            if (l->freeFn)
-                l->freeFn(entry->data);
-            free(entry->data);
-            free(entry);        // remove entry
+            dll_freeNode(l, entry); // free node data and node itself
             l->logicalLength--; // decrease list's length
 
             return;
@@ -241,28 +253,118 @@ void dll_deleteNode(dLinkedList *l, void *data, nodeComparator cmp)
     }
 }
 
+/**
+ * dll_filter:
+ *      Unlink in one pass every node for which `pred` returns `match`,
+ *      appending it to `dst` if given or freeing it otherwise.
+ *      Returns the number of nodes unlinked.
+ */
+static size_t dll_filter(dLinkedList *l, nodePredicate pred, void *ctx,
+                         bool match, dLinkedList *dst)
+{
+    assert(pred);
+
+    dLinkedListNode *entry = l->head, *next;
+    size_t removed = 0;
+
+    for (; entry; entry = next) {
+        next = entry->next;
+        if (pred(entry->data, ctx) != match)
+            continue;
+
+        // Reset node links, including the list's head/tail
+        if (entry->prev)
+            entry->prev->next = next;
+        else
+            l->head = next;
+        if (next)
+            next->prev = entry->prev;
+        else
+            l->tail = entry->prev;
+        removed++;
+
+        if (!dst) {
+            dll_freeNode(l, entry);
+            continue;
+        }
+
+        // Append the node itself to the destination list
+        entry->next = NULL;
+        entry->prev = dst->tail;
+        if (dst->tail)
+            dst->tail->next = entry;
+        else
+            dst->head = entry;
+        dst->tail = entry;
+        dst->logicalLength++;
+    }
+
+    l->logicalLength -= removed;
+
+    return removed;
+}
+
+/**
+ * dll_removeIf:
+ *      Remove and free every node whose data satisfies `pred`.
+ *      Returns the number of nodes removed.
+ */
+size_t dll_removeIf(dLinkedList *l, nodePredicate pred, void *ctx)
+{
+    return dll_filter(l, pred, ctx, true, NULL);
+}
+
+/**
+ * dll_retainIf:
+ *      Remove and free every node whose data does not satisfy `pred`.
+ *      Returns the number of nodes removed.
+ */
+size_t dll_retainIf(dLinkedList *l, nodePredicate pred, void *ctx)
+{
+    return dll_filter(l, pred, ctx, false, NULL);
+}
+
+/**
+ * dll_moveIf:
+ *      Move every node whose data satisfies `pred` to the end of `dst`,
+ *      keeping their order, without copying or freeing them.  Both lists
+ *      must hold elements of the same size, the moved data is later freed
+ *      with the freeFunction of `dst`.
+ *      Returns the number of nodes moved.
+ */
+size_t dll_moveIf(dLinkedList *l, dLinkedList *dst, nodePredicate pred,
+                  void *ctx)
+{
+    assert(dst && dst != l && dst->elementSize == l->elementSize);
+
+    return dll_filter(l, pred, ctx, true, dst);
+}
+
 /**
  * dll_getNodeAt:
  *      Return node at given position in list.
  */
 dLinkedListNode *dll_getNodeAt(dLinkedList *l, size_t index)
 {
-    // Return NULL if index given exceeds the list's length
-    if (index > l->logicalLength)
+    // Return NULL if index given is 0 or exceeds the list's length
+    if (index == 0 || index > l->logicalLength)
         return NULL;
 
-    dLinkedListNode *curr = l->head;
+    dLinkedListNode *curr;
     size_t i;
 
-    // Iterate over list looking for node at index
-    for (i = 1; curr; i++) {
-        if (i == index)
-            return curr;
-
-        curr = curr->next;
+    // Walk from whichever end of the list is nearer
+    if (index > l->logicalLength / 2) {
+        curr = l->tail;
+        for (i = l->logicalLength; i > index; i--)
+            curr = curr->prev;
+    } else {
+        curr = l->head;
+        for (i = 1; i < index; i++)
+            curr = curr->next;
     }
 
-    return NULL;                // node not found
+    return curr;
 }
 
 /**
@@ -306,6 +408,93 @@ void dll_foreach(dLinkedList *l, listIterator it, displayFunction display)
     }
 }
 
+/**
+ * dll_foreachBatch:
+ *      Iterate over a doubly linked list handing `it` the data pointers
+ *      of up to `batch` nodes at a time, 0 picks a default batch size,
+ *      along with `ctx`.  Stops early when `it` returns false.
+ */
+void dll_foreachBatch(dLinkedList *l, size_t batch, batchIterator it,
+                      void *ctx)
+{
+    // Assert that a batch iterating function was passed
+    assert(it);
+
+    if (!batch)
+        batch = DLL_BATCH;
+
+    void **elements = malloc(batch * sizeof(void *));
+    if (!elements)
+        error_abort("Unable to allocate batch");
+
+    dLinkedListNode *node = l->head;
+    bool result = true;
+
+    // Gather a batch of data pointers and hand it over in one call
+    while (node && result) {
+        size_t n = 0;
+        for (; node && n < batch; node = node->next)
+            elements[n++] = node->data;
+
+        result = it(elements, n, ctx);
+    }
+
+    free(elements);
+}
+
+/**
+ * dll_foreachBatchCopy:
+ *      Iterate over a doubly linked list handing `it` contiguous copies of
+ *      the data of up to `batch` nodes at a time, 0 picks a default batch
+ *      size, along with `ctx`.  Changes to the copies are not written back.
+ *      Stops early when `it` returns false.
+ */
+void dll_foreachBatchCopy(dLinkedList *l, size_t batch, copyBatchIterator it,
+                          void *ctx)
+{
+    // Assert that a batch iterating function was passed
+    assert(it);
+
+    if (!batch)
+        batch = DLL_BATCH;
+
+    char *elements = malloc(batch * l->elementSize);
+    if (!elements)
+        error_abort("Unable to allocate batch");
+
+    dLinkedListNode *node = l->head;
+    bool result = true;
+
+    // Copy a batch of elements side by side and hand it over in one call
+    while (node && result) {
+        size_t n = 0;
+        for (; node && n < batch; node = node->next, n++)
+            memcpy(elements + n * l->elementSize, node->data, l->elementSize);
+
+        result = it(elements, n, ctx);
+    }
+
+    free(elements);
+}
+
+/**
+ * dll_toArray:
+ *      Copy the data of every node of a doubly linked list, in order, into
+ *      the contiguous buffer `arr` which must hold dll_length elements.
+ *      Returns the number of elements copied.
+ */
+size_t dll_toArray(dLinkedList *l, void *arr)
+{
+    char *dst = arr;
+    size_t n = 0;
+
+    // Copy each node's data to the next slot of the buffer
+    for (dLinkedListNode *node = l->head; node; node = node->next, n++)
+        memcpy(dst + n * l->elementSize, node->data, l->elementSize);
+
+    return n;                   // return number of elements copied
+}
+
 /**
  * dll_head:
  *      Return a copy of the head of a list's head and optionally
@@ -324,12 +513,13 @@ void dll_head(dLinkedList *l, void *el, bool remove)
     if (remove) {
         l->head = node->next;
 
-        // Use freeFunction if it exists
-        if (l->freeFn)
-            l->freeFn(node->data);
+        // Reset links of the new head, or the tail if the list is now empty
+        if (l->head)
+            l->head->prev = NULL;
+        else
+            l->tail = NULL;
 
-        free(node->data);
-        free(node);
+        dll_freeNode(l, node);
         l->logicalLength--;     // decrease list's logical length
     }
 }
@@ -392,6 +582,9 @@ void dll_reverse(dLinkedList *l)
 {
     dLinkedListNode *curr = l->head, *temp = NULL;
 
+    // Old head becomes the new tail
+    l->tail = l->head;
+
     // Reset node links
     while (curr) {
         temp = curr->prev;
@@ -410,21 +603,19 @@ void dll_reverse(dLinkedList *l)
  */
 void dll_swapNodeData(dLinkedList *l, dLinkedListNode *a, dLinkedListNode *b)
 {
-    // Allocate a temporary node
-    dLinkedListNode *temp = calloc(1, sizeof(dLinkedListNode));
-    if (!temp)
-        error_abort("Unable to allocate memory for a temporary node");
+    if (a == b)
+        return;
 
-    if (!(temp->data = calloc(1, sizeof(l->elementSize))))
+    // Allocate temporary storage for one element
+    void *temp = malloc(l->elementSize);
+    if (!temp)
         error_abort("Unable to allocate memory for temporary node data");
 
     // Swap data
-    memmove(temp->data, a->data, l->elementSize);
-    memmove(a->data, b->data, l->elementSize);
-    memmove(b->data, temp->data, l->elementSize);
+    memcpy(temp, a->data, l->elementSize);
+    memcpy(a->data, b->data, l->elementSize);
+    memcpy(b->data, temp, l->elementSize);
 
-    // Free temporary node
-    free(temp->data);
     free(temp);
 }
 
@@ -475,7 +666,6 @@ dLinkedList *dll_split(dLinkedList *a)
     while (fast->next && fast->next->next) {
         fast = fast->next->next;
         slow = slow->next;
-        a->logicalLength--;
     }
 
     // Create and initialize a new list with the second half of the original
@@ -484,16 +674,265 @@ dLinkedList *dll_split(dLinkedList *a)
         error_abort("Unable to allocate dLinkedList");
 
     b->elementSize = a->elementSize;
+    b->freeFn = a->freeFn;
+    b->cached = a->cached;
     b->head = slow->next;
+    b->head->prev = NULL;
+    b->tail = a->tail;
     slow->next = NULL;
 
     size_t i;
     dLinkedListNode *it = b->head;
-    for (i = 0; it; i++) {
-        b->tail = it;
+    for (i = 0; it; i++)
         it = it->next;
-    }
     b->logicalLength = i;
 
+    a->tail = slow;
+    a->logicalLength -= i;
+
     return b;                   // return the second half of the list
 }
+
+/**
+ * dll_compactFrom:
+ *      Move up to `n` nodes following `prev`, or from the head if `prev` is
+ *      NULL, into fresh runs of blocks laid out in list order and free
+ *      their old blocks.  Element bytes are moved unchanged, so whatever
+ *      they point to is still owned by the list's freeFunction.
+ *      Returns the new location of the last node moved, to be passed as
+ *      `prev` to the next call, or NULL if no node was left to move.
+ */
+dLinkedListNode *dll_compactFrom(dLinkedList *l, dLinkedListNode *prev,
+                                 size_t n)
+{
+    dLinkedListNode **link = prev ? &prev->next : &l->head;
+    dLinkedListNode *last = NULL;
+    size_t size = DLL_DATA_OFFSET + l->elementSize;
+    size_t runNodes = DLL_COMPACT_RUN / size ? DLL_COMPACT_RUN / size : 1;
+
+    // Never ask for more blocks than there can be nodes left
+    if (n > l->logicalLength)
+        n = l->logicalLength;
+
+    while (n && *link) {
+        size_t count = n < runNodes ? n : runNodes;
+        size_t stride, moved = 0;
+        char *block = nc_allocRun(size, count, &stride);
+
+        // Copy each node into the next block of the run
+        for (; moved < count && *link; moved++, block += stride) {
+            dLinkedListNode *old = *link, *node = (dLinkedListNode *)block;
+
+            node->data = block + DLL_DATA_OFFSET;
+            memcpy(node->data, old->data, l->elementSize);
+            node->next = old->next;
+            node->prev = old->prev;
+            if (old->next)
+                old->next->prev = node;
+            *link = node;
+            if (l->tail == old)
+                l->tail = node;
+
+            nc_free(old);
+            link = &node->next;
+            last = node;
+        }
+
+        // Give back the blocks the end of the list left unused
+        n -= moved;
+        for (size_t i = moved; i < count; i++, block += stride)
+            nc_free(block);
+    }
+
+    return last;
+}
+
+/**
+ * dll_compact:
+ *      Move every node of a doubly linked list into fresh runs of blocks
+ *      laid out in list order, restoring the locality a long lived list
+ *      loses as nodes are inserted and deleted.
+ */
+void dll_compact(dLinkedList *l)
+{
+    dll_compactFrom(l, NULL, l->logicalLength);
+}
+
+/**
+ * dll_clone:
+ *      Copy a list in one pass into nodes carved from runs of blocks,
+ *      copying each element with `copy` if given, else byte by byte.
+ *      Returns the new list.
+ */
+dLinkedList *dll_clone(dLinkedList *l, copyFunction copy)
+{
+    dLinkedList *c = dll_create(l->elementSize, l->freeFn);
+    size_t size = DLL_DATA_OFFSET + l->elementSize;
+    size_t runNodes = DLL_COMPACT_RUN / size ? DLL_COMPACT_RUN / size : 1;
+    size_t left = l->logicalLength, stride = 0, avail = 0;
+    dLinkedListNode *last = NULL;
+    char *block = NULL;
+
+    c->cached = l->cached;
+
+    for (dLinkedListNode *old = l->head; old; old = old->next, left--) {
+        // Start a new run sized for the nodes left
+        if (!avail) {
+            avail = left < runNodes ? left : runNodes;
+            block = nc_allocRun(size, avail, &stride);
+        }
+
+        dLinkedListNode *node = (dLinkedListNode *)block;
+        node->data = block + DLL_DATA_OFFSET;
+        if (copy)
+            copy(node->data, old->data);
+        else
+            memcpy(node->data, old->data, l->elementSize);
+
+        node->prev = last;
+        node->next = NULL;
+        if (last)
+            last->next = node;
+        else
+            c->head = node;
+
+        last = node;
+        block += stride;
+        avail--;
+    }
+
+    c->tail = last;
+    c->logicalLength = l->logicalLength;
+
+    return c;                   // return the clone
+}
+
+/**
+ * dll_cursor:
+ *      Return a cursor on the head node of a list.
+ */
+dllCursor dll_cursor(dLinkedList *l)
+{
+    dllCursor c = { l, l->head };
+
+    return c;
+}
+
+/**
+ * dll_cursorLast:
+ *      Return a cursor on the tail node of a list.
+ */
+dllCursor dll_cursorLast(dLinkedList *l)
+{
+    dllCursor c = { l, l->tail };
+
+    return c;
+}
+
+/**
+ * dlc_valid:
+ *      Return true if the cursor is on a node.
+ */
+bool dlc_valid(dllCursor *c)
+{
+    return c->curr != NULL;
+}
+
+/**
+ * dlc_next:
+ *      Move a cursor to the following node, past the tail it is no longer
+ *      valid.
+ */
+void dlc_next(dllCursor *c)
+{
+    if (c->curr)
+        c->curr = c->curr->next;
+}
+
+/**
+ * dlc_prev:
+ *      Move a cursor to the preceding node, past the head it is no longer
+ *      valid.  A cursor that is not valid moves to the tail.
+ */
+void dlc_prev(dllCursor *c)
+{
+    c->curr = c->curr ? c->curr->prev : c->list->tail;
+}
+
+/**
+ * dlc_get:
+ *      Return a pointer to the data of the cursor's node.
+ */
+void *dlc_get(dllCursor *c)
+{
+    assert(c->curr);
+
+    return c->curr->data;
+}
+
+/**
+ * dlc_set:
+ *      Replace the data of the cursor's node with a copy of `el`, the old
+ *      data is passed to the list's freeFunction first.
+ */
+void dlc_set(dllCursor *c, void *el)
+{
+    assert(c->curr);
+
+    if (c->list->freeFn)
+        c->list->freeFn(c->curr->data);
+
+    memcpy(c->curr->data, el, c->list->elementSize);
+}
+
+/**
+ * dlc_remove:
+ *      Remove the cursor's node and move the cursor to the node that
+ *      followed it.
+ */
+void dlc_remove(dllCursor *c)
+{
+    assert(c->curr);
+
+    dLinkedList *l = c->list;
+    dLinkedListNode *node = c->curr;
+
+    // Reset node links, including the list's head/tail
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        l->head = node->next;
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        l->tail = node->prev;
+
+    c->curr = node->next;
+    dll_freeNode(l, node);
+    l->logicalLength--;         // decrease list's logical length
+}
+
+/**
+ * dlc_insertBefore:
+ *      Insert a new node before the cursor's node, or append it if the
+ *      cursor is not valid.  The cursor stays on its node.
+ */
+void dlc_insertBefore(dllCursor *c, void *el)
+{
+    if (!c->curr)
+        dll_append(c->list, el);
+    else
+        dll_insertBefore(c->list, c->curr, el);
+}
+
+/**
+ * dlc_insertAfter:
+ *      Insert a new node after the cursor's node.  The cursor stays on
+ *      its node.
+ */
+void dlc_insertAfter(dllCursor *c, void *el)
+{
+    assert(c->curr);
+
+    dll_insertAfter(c->list, c->curr, el);
+}
@@ -0,0 +1,340 @@
+/** intrusiveList.c - Intrusive list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include "intrusive.h"
+
+// Number of sorted runs kept by the merge sorts, enough for any list
+#define SORT_BINS (sizeof(size_t) * 8)
+
+/**
+ * il_foreach:
+ *      Iterate over an intrusive singly linked list and perform the tasks
+ *      in the listIterator function on each object.
+ */
+void il_foreach(iList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    iListLink *link = l->head;
+    bool result = true;
+
+    // Iterate over the list, the iterator may unlink the current object
+    while (link && result) {
+        iListLink *next = link->next;
+        result = it(il_object(l, link), display);
+        link = next;
+    }
+}
+
+/**
+ * il_find:
+ *      Return the first link whose object compares EQUAL to `data`,
+ *      or NULL if there is none.
+ */
+iListLink *il_find(iList *l, const void *data, nodeComparator cmp)
+{
+    assert(cmp);
+
+    for (iListLink *link = l->head; link; link = link->next)
+        if (cmp(il_object(l, link), data) == EQUAL)
+            return link;
+
+    return NULL;
+}
+
+/**
+ * il_reverse:
+ *      Reverse the link order of an intrusive singly linked list.
+ */
+void il_reverse(iList *l)
+{
+    iListLink *next = NULL;
+    iListLink *prev = NULL;
+    iListLink *curr = l->head;
+
+    // Old head becomes the new tail
+    l->tail = l->head;
+
+    // Swap links
+    while (curr) {
+        next = curr->next;
+        curr->next = prev;
+        prev = curr;
+        curr = next;
+    }
+
+    // Reset list head
+    l->head = prev;
+}
+
+/**
+ * il_split:
+ *      Split a list into two halves.  If there is an odd number of links
+ *      in the original list it goes into the first half, the second half
+ *      is moved to the empty list `b`.
+ */
+void il_split(iList *a, iList *b)
+{
+    assert(il_isEmpty(b));
+
+    if (a->logicalLength <= 1)
+        return;
+
+    // The first half keeps the odd link
+    size_t half = (a->logicalLength + 1) / 2;
+    iListLink *last = a->head;
+    for (size_t i = 1; i < half; i++)
+        last = last->next;
+
+    b->head = last->next;
+    b->tail = a->tail;
+    b->logicalLength = a->logicalLength - half;
+    last->next = NULL;
+
+    a->tail = last;
+    a->logicalLength = half;
+}
+
+/**
+ * il_merge:
+ *      Merge two sorted chains of links into one, preferring `a` on ties.
+ */
+static iListLink *il_merge(iList *l, iListLink *a, iListLink *b,
+                           nodeComparator cmp)
+{
+    iListLink head, *tail = &head;
+
+    while (a && b) {
+        if (cmp(il_object(l, a), il_object(l, b)) == GREATER) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+
+    return head.next;
+}
+
+/**
+ * il_sort:
+ *      Stable bottom up merge sort that relinks the list's links in the
+ *      order given by a nodeComparator applied to their objects.
+ */
+void il_sort(iList *l, nodeComparator cmp)
+{
+    assert(cmp);
+
+    iListLink *bins[SORT_BINS] = { NULL }; // bins[i] is a run of 2^i links
+    iListLink *link = l->head, *run;
+    size_t top = 0, i;
+
+    // Merge each link into the bins like carries in a binary counter
+    while (link) {
+        run = link;
+        link = link->next;
+        run->next = NULL;
+
+        for (i = 0; bins[i]; i++) {
+            run = il_merge(l, bins[i], run, cmp);
+            bins[i] = NULL;
+        }
+        bins[i] = run;
+        if (i >= top)
+            top = i + 1;
+    }
+
+    // Older runs hold earlier links so they are merged in on the left
+    for (run = NULL, i = 0; i < top; i++)
+        if (bins[i])
+            run = il_merge(l, bins[i], run, cmp);
+
+    // Reset list head and tail
+    l->head = run;
+    l->tail = run;
+    while (l->tail && l->tail->next)
+        l->tail = l->tail->next;
+}
+
+/**
+ * idl_foreach:
+ *      Iterate over an intrusive doubly linked list and perform the tasks
+ *      in the listIterator function on each object.
+ */
+void idl_foreach(idList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    idListLink *link = l->head;
+    bool result = true;
+
+    // Iterate over the list, the iterator may unlink the current object
+    while (link && result) {
+        idListLink *next = link->next;
+        result = it(idl_object(l, link), display);
+        link = next;
+    }
+}
+
+/**
+ * idl_find:
+ *      Return the first link whose object compares EQUAL to `data`,
+ *      or NULL if there is none.
+ */
+idListLink *idl_find(idList *l, const void *data, nodeComparator cmp)
+{
+    assert(cmp);
+
+    for (idListLink *link = l->head; link; link = link->next)
+        if (cmp(idl_object(l, link), data) == EQUAL)
+            return link;
+
+    return NULL;
+}
+
+/**
+ * idl_reverse:
+ *      Reverse the link order of an intrusive doubly linked list.
+ */
+void idl_reverse(idList *l)
+{
+    idListLink *curr = l->head;
+
+    // Swap every link's pointers
+    while (curr) {
+        idListLink *next = curr->next;
+        curr->next = curr->prev;
+        curr->prev = next;
+        curr = next;
+    }
+
+    // Swap list head and tail
+    curr = l->head;
+    l->head = l->tail;
+    l->tail = curr;
+}
+
+/**
+ * idl_split:
+ *      Split a list into two halves.  If there is an odd number of links
+ *      in the original list it goes into the first half, the second half
+ *      is moved to the empty list `b`.
+ */
+void idl_split(idList *a, idList *b)
+{
+    assert(idl_isEmpty(b));
+
+    if (a->logicalLength <= 1)
+        return;
+
+    // The first half keeps the odd link
+    size_t half = (a->logicalLength + 1) / 2;
+    idListLink *last = a->head;
+    for (size_t i = 1; i < half; i++)
+        last = last->next;
+
+    b->head = last->next;
+    b->head->prev = NULL;
+    b->tail = a->tail;
+    b->logicalLength = a->logicalLength - half;
+    last->next = NULL;
+
+    a->tail = last;
+    a->logicalLength = half;
+}
+
+/**
+ * idl_merge:
+ *      Merge two sorted chains of links into one, preferring `a` on ties.
+ *      Only the next pointers are set.
+ */
+static idListLink *idl_merge(idList *l, idListLink *a, idListLink *b,
+                             nodeComparator cmp)
+{
+    idListLink head, *tail = &head;
+
+    while (a && b) {
+        if (cmp(idl_object(l, a), idl_object(l, b)) == GREATER) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+
+    return head.next;
+}
+
+/**
+ * idl_sort:
+ *      Stable bottom up merge sort that relinks the list's links in the
+ *      order given by a nodeComparator applied to their objects.
+ */
+void idl_sort(idList *l, nodeComparator cmp)
+{
+    assert(cmp);
+
+    idListLink *bins[SORT_BINS] = { NULL }; // bins[i] is a run of 2^i links
+    idListLink *link = l->head, *run;
+    size_t top = 0, i;
+
+    // Merge each link into the bins like carries in a binary counter
+    while (link) {
+        run = link;
+        link = link->next;
+        run->next = NULL;
+
+        for (i = 0; bins[i]; i++) {
+            run = idl_merge(l, bins[i], run, cmp);
+            bins[i] = NULL;
+        }
+        bins[i] = run;
+        if (i >= top)
+            top = i + 1;
+    }
+
+    // Older runs hold earlier links so they are merged in on the left
+    for (run = NULL, i = 0; i < top; i++)
+        if (bins[i])
+            run = idl_merge(l, bins[i], run, cmp);
+
+    // Restore prev pointers and reset list head and tail
+    idListLink *prev = NULL;
+    for (link = run; link; prev = link, link = link->next)
+        link->prev = prev;
+
+    l->head = run;
+    l->tail = prev;
+}
@@ -0,0 +1,283 @@
+/** jumpIndex.c - Jump pointer indexes for prefetching list traversal.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <assert.h>
+#include "lists.h"
+#include "errors.h"
+
+#define JUMP_STRIDE 64          // default nodes between jump pointers
+#define JUMP_LANES 8            // default chains walked at once
+#define JUMP_MAX_LANES 64       // upper bound on chains walked at once
+
+/**
+ * ji_next:
+ *      Return the node following `node`.
+ */
+static inline void *ji_next(const jumpIndex *ji, void *node)
+{
+    return *(void **)((char *)node + ji->nextOffset);
+}
+
+/**
+ * ji_data:
+ *      Return the data of `node`, data is the first member of both node types.
+ */
+static inline void *ji_data(void *node)
+{
+    return *(void **)node;
+}
+
+/**
+ * ji_build:
+ *      Walk a chain of nodes once and record every stride'th node.
+ *      Returns the index.
+ */
+static jumpIndex *ji_build(void *head, size_t nextOffset, size_t length,
+                           size_t stride, size_t lanes)
+{
+    jumpIndex *ji = malloc(sizeof(jumpIndex));
+    if (!ji)
+        error_abort("Unable to allocate jumpIndex");
+
+    ji->length = length;
+    ji->stride = stride ? stride : JUMP_STRIDE;
+    ji->lanes = lanes ? lanes : JUMP_LANES;
+    if (ji->lanes > JUMP_MAX_LANES)
+        ji->lanes = JUMP_MAX_LANES;
+    ji->nextOffset = nextOffset;
+    ji->count = (length + ji->stride - 1) / ji->stride;
+
+    ji->jumps = malloc((ji->count ? ji->count : 1) * sizeof(void *));
+    if (!ji->jumps)
+        error_abort("Unable to allocate jump pointers");
+
+    // Record the first node of every segment
+    size_t i = 0;
+    for (void *node = head; node; node = ji_next(ji, node), i++)
+        if (i % ji->stride == 0)
+            ji->jumps[i / ji->stride] = node;
+
+    return ji;                  // return new index
+}
+
+/**
+ * ji_warm:
+ *      Walk `n` segments starting at segment `seg` side by side so that
+ *      their cache misses overlap instead of stalling one after another.
+ */
+static void ji_warm(const jumpIndex *ji, size_t seg, size_t n)
+{
+    void *cursor[JUMP_MAX_LANES];
+
+    for (size_t w = 0; w < n; w++)
+        cursor[w] = ji->jumps[seg + w];
+
+    for (size_t step = 0; step < ji->stride; step++)
+        for (size_t w = 0; w < n; w++)
+            if (cursor[w]) {
+                __builtin_prefetch(ji_data(cursor[w]));
+                cursor[w] = ji_next(ji, cursor[w]);
+            }
+}
+
+/**
+ * ji_search:
+ *      Search every segment for a node containing `data`, several
+ *      segments at a time.
+ */
+static bool ji_search(const jumpIndex *ji, void *data, nodeComparator cmp)
+{
+    void *cursor[JUMP_MAX_LANES];
+
+    for (size_t seg = 0; seg < ji->count; seg += ji->lanes) {
+        size_t n = ji->count - seg < ji->lanes ? ji->count - seg : ji->lanes;
+
+        for (size_t w = 0; w < n; w++)
+            cursor[w] = ji->jumps[seg + w];
+
+        // Order does not matter, compare one node of each segment per step
+        for (size_t step = 0; step < ji->stride; step++)
+            for (size_t w = 0; w < n; w++)
+                if (cursor[w]) {
+                    if (cmp(ji_data(cursor[w]), data) == EQUAL)
+                        return true;
+                    cursor[w] = ji_next(ji, cursor[w]);
+                }
+    }
+
+    return false;
+}
+
+/**
+ * ji_foreach:
+ *      Warm a window of segments then iterate over it in list order.
+ */
+static void ji_foreach(const jumpIndex *ji, listIterator it,
+                       displayFunction display)
+{
+    bool result = true;
+
+    for (size_t seg = 0; seg < ji->count && result; seg += ji->lanes) {
+        size_t n = ji->count - seg < ji->lanes ? ji->count - seg : ji->lanes;
+        void *node = ji->jumps[seg];
+
+        ji_warm(ji, seg, n);
+        for (size_t i = 0; i < n * ji->stride && node && result; i++) {
+            result = it(ji_data(node), display);
+            node = ji_next(ji, node);
+        }
+    }
+}
+
+/**
+ * ji_getNodeAt:
+ *      Return node at given position, walking from the nearest jump pointer.
+ */
+static void *ji_getNodeAt(const jumpIndex *ji, size_t index)
+{
+    // Return NULL if index is 0 or exceeds the list's length
+    if (index == 0 || index > ji->length)
+        return NULL;
+
+    void *node = ji->jumps[(index - 1) / ji->stride];
+    for (size_t i = (index - 1) % ji->stride; i; i--)
+        node = ji_next(ji, node);
+
+    return node;
+}
+
+/**
+ * ll_jumpIndex:
+ *      Build a jump pointer index over a singly linked list, with a jump
+ *      pointer every `stride` nodes and `lanes` segments walked at once.
+ *      0 picks the default for either.  Returns the index.
+ */
+jumpIndex *ll_jumpIndex(linkedList *l, size_t stride, size_t lanes)
+{
+    return ji_build(l->head, offsetof(linkedListNode, next), l->logicalLength,
+                    stride, lanes);
+}
+
+/**
+ * ll_searchIndexed:
+ *      Search a list for a node containing `data` using a jump index.
+ */
+bool ll_searchIndexed(linkedList *l, jumpIndex *ji, void *data,
+                      nodeComparator cmp)
+{
+    assert(cmp);
+    assert(ji->length == l->logicalLength);
+
+    return ji_search(ji, data, cmp);
+}
+
+/**
+ * ll_foreachIndexed:
+ *      Iterate over a list in order using a jump index.
+ */
+void ll_foreachIndexed(linkedList *l, jumpIndex *ji, listIterator it,
+                       displayFunction display)
+{
+    assert(it);
+    assert(ji->length == l->logicalLength);
+
+    ji_foreach(ji, it, display);
+}
+
+/**
+ * ll_getNodeAtIndexed:
+ *      Return node at given position in list using a jump index.
+ */
+linkedListNode *ll_getNodeAtIndexed(linkedList *l, jumpIndex *ji,
+                                    size_t index)
+{
+    assert(ji->length == l->logicalLength);
+
+    return ji_getNodeAt(ji, index);
+}
+
+/**
+ * dll_jumpIndex:
+ *      Build a jump pointer index over a doubly linked list, with a jump
+ *      pointer every `stride` nodes and `lanes` segments walked at once.
+ *      0 picks the default for either.  Returns the index.
+ */
+jumpIndex *dll_jumpIndex(dLinkedList *l, size_t stride, size_t lanes)
+{
+    return ji_build(l->head, offsetof(dLinkedListNode, next),
+                    l->logicalLength, stride, lanes);
+}
+
+/**
+ * dll_searchIndexed:
+ *      Search a list for a node containing `data` using a jump index.
+ */
+bool dll_searchIndexed(dLinkedList *l, jumpIndex *ji, void *data,
+                       nodeComparator cmp)
+{
+    assert(cmp);
+    assert(ji->length == l->logicalLength);
+
+    return ji_search(ji, data, cmp);
+}
+
+/**
+ * dll_foreachIndexed:
+ *      Iterate over a list in order using a jump index.
+ */
+void dll_foreachIndexed(dLinkedList *l, jumpIndex *ji, listIterator it,
+                        displayFunction display)
+{
+    assert(it);
+    assert(ji->length == l->logicalLength);
+
+    ji_foreach(ji, it, display);
+}
+
+/**
+ * dll_getNodeAtIndexed:
+ *      Return node at given position in list using a jump index.
+ */
+dLinkedListNode *dll_getNodeAtIndexed(dLinkedList *l, jumpIndex *ji,
+                                      size_t index)
+{
+    assert(ji->length == l->logicalLength);
+
+    return ji_getNodeAt(ji, index);
+}
+
+/**
+ * ji_delete:
+ *      Free a jump index, the list it was built over is untouched.
+ */
+void ji_delete(jumpIndex *ji)
+{
+    if (!ji)
+        return;
+
+    free(ji->jumps);
+    free(ji);
+}
@@ -0,0 +1,190 @@
+/** lazyList.c - Lazy list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lazyList.h"
+#include "errors.h"
+
+/**
+ * lz_create:
+ *      Create a lazy list of elements of `size` bytes produced by `gen`
+ *      from `state`, keeping at most `window` elements, 0 for no bound.
+ *      Returns the list.
+ */
+lazyList *lz_create(size_t size, freeFunction fn, generatorFunction gen,
+                    void *state, size_t window)
+{
+    // Assert that a generator was passed
+    assert(gen);
+
+    // Allocate list
+    lazyList *l = calloc(1, sizeof(lazyList));
+    if (!l)
+        error_abort("Unable to allocate lazyList");
+
+    l->scratch = calloc(1, size ? size : 1);
+    if (!l->scratch)
+        error_abort("Unable to allocate lazyList element");
+
+    // Initialize list
+    l->nodes = ll_create(size, fn);
+    l->dropped = 0;
+    l->window = window;
+    l->gen = gen;
+    l->state = state;
+    l->done = false;
+
+    return l;                   // return new list
+}
+
+/**
+ * lz_delete:
+ *      Free every element kept and the list, the generator's state is
+ *      left to the caller.
+ */
+void lz_delete(lazyList *l)
+{
+    ll_delete(l->nodes);
+    free(l->scratch);
+    free(l);
+}
+
+/**
+ * lz_pull:
+ *      Append the next element of the sequence to the kept nodes.
+ *      Returns false if the sequence has ended.
+ */
+static bool lz_pull(lazyList *l)
+{
+    if (l->done)
+        return false;
+
+    if (!l->gen(l->scratch, l->state)) {
+        l->done = true;
+        return false;
+    }
+
+    ll_append(l->nodes, l->scratch);
+
+    return true;
+}
+
+/**
+ * lz_trim:
+ *      Free the oldest elements until no more than the window is kept.
+ */
+static void lz_trim(lazyList *l)
+{
+    while (l->window && l->nodes->logicalLength > l->window) {
+        ll_head(l->nodes, l->scratch, true);
+        l->dropped++;
+    }
+}
+
+/**
+ * lz_head:
+ *      Copy the first element kept to `el`, generating it if needed, and
+ *      optionally remove it from the list.
+ *      Returns false if there is no element left.
+ */
+bool lz_head(lazyList *l, void *el, bool remove)
+{
+    if (!l->nodes->head && !lz_pull(l))
+        return false;
+
+    ll_head(l->nodes, el, remove);
+    if (remove)
+        l->dropped++;
+
+    return true;
+}
+
+/**
+ * lz_getNodeAt:
+ *      Return node at given position in the sequence, generating elements
+ *      up to it if needed.  Returns NULL if the position is 0, has left
+ *      the window or is past the end of the sequence.
+ */
+linkedListNode *lz_getNodeAt(lazyList *l, size_t index)
+{
+    if (index <= l->dropped)
+        return NULL;
+
+    // Generate up to the position, trimming as the window slides
+    while (l->dropped + l->nodes->logicalLength < index) {
+        if (!lz_pull(l))
+            return NULL;
+        lz_trim(l);
+    }
+
+    return ll_getNodeAt(l->nodes, index - l->dropped);
+}
+
+/**
+ * lz_foreach:
+ *      Iterate over the elements kept and then over newly generated ones,
+ *      until the iterator returns false or the sequence ends.
+ */
+void lz_foreach(lazyList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    if (!l->nodes->head && !lz_pull(l))
+        return;
+
+    linkedListNode *node = l->nodes->head;
+    bool result = true;
+
+    while (node && result) {
+        result = it(node->data, display);
+
+        // Step to the next node, generating it from the tail
+        if (!node->next && result && !lz_pull(l))
+            break;
+
+        node = node->next;
+        lz_trim(l);             // may free nodes behind this one
+    }
+}
+
+/**
+ * lz_generated:
+ *      Return the number of elements generated so far.
+ */
+size_t lz_generated(lazyList *l)
+{
+    return l->dropped + l->nodes->logicalLength;
+}
+
+/**
+ * lz_isDone:
+ *      Return true once the generator has reported the end of the sequence.
+ */
+bool lz_isDone(lazyList *l)
+{
+    return l->done;
+}
@@ -26,8 +26,18 @@ SOFTWARE.
 #include <string.h>
 #include <assert.h>
 #include "lists.h"
+#include "nodeCache.h"
 #include "errors.h"
 
+// Offset of a node's data within its block
+#define LL_DATA_OFFSET NC_ALIGN(sizeof(linkedListNode))
+
+// Default number of elements handed to a batch iterator at a time
+#define LL_BATCH 64
+
+// Bytes of nodes moved into each run by compaction
+#define LL_COMPACT_RUN (256 * 1024)
+
 /**
  * ll_create:
  *      Create and initialize a singly linked list.
@@ -45,10 +55,56 @@ linkedList *ll_create(size_t size, freeFunction fn)
     l->elementSize = size;
     l->head = l->tail = NULL;
     l->freeFn = fn;
+    l->cached = nc_getDefault();
 
     return l;                   // return new list
 }
 
+/**
+ * ll_createCached:
+ *      Create and initialize a singly linked list whose nodes are
+ *      allocated from per-thread node caches.
+ *      Returns the list.
+ */
+linkedList *ll_createCached(size_t size, freeFunction fn)
+{
+    linkedList *l = ll_create(size, fn);
+    l->cached = true;
+
+    return l;                   // return new list
+}
+
+/**
+ * ll_newNode:
+ *      Allocate a node holding a copy of `el`, the node and its data
+ *      share a single block.
+ */
+static linkedListNode *ll_newNode(linkedList *l, void *el)
+{
+    linkedListNode *node = nc_alloc(LL_DATA_OFFSET + l->elementSize,
+                                    l->cached);
+
+    // Copy new data into node
+    node->data = (char *)node + LL_DATA_OFFSET;
+    memcpy(node->data, el, l->elementSize);
+    node->next = NULL;
+
+    return node;
+}
+
+/**
+ * ll_freeNode:
+ *      Free a node and its data.
+ */
+static void ll_freeNode(linkedList *l, linkedListNode *node)
+{
+    // Use freeFunction if it exists
+    if (l->freeFn)
+        l->freeFn(node->data);
+
+    nc_free(node);
+}
+
 /**
  * ll_delete:
  *      Remove each node from a list.
@@ -60,12 +116,7 @@ void ll_delete(linkedList *l)
         curr = l->head;
         l->head = curr->next;
 
-        // Free node
-        if (l->freeFn)
-            l->freeFn(curr->data);
-
-        free(curr->data);
-        free(curr);
+        ll_freeNode(l, curr);   // free node
         l->logicalLength--;     // decrease list's logical length
     }
 
@@ -79,18 +130,12 @@ void ll_delete(linkedList *l)
  */
 void ll_push(linkedList *l, void *el)
 {
-    // Allocate memory for a new list node
-    linkedListNode *node = calloc(1, sizeof(linkedListNode));
-    if (!node)
-        error_abort("unable to allocate memory for node");
+    // Allocate a new list node holding a copy of el
+    linkedListNode *node = ll_newNode(l, el);
 
-    // Allocate memory for node's new data
-    if ((node->data = calloc(1, l->elementSize)) == NULL)
-        error_abort("unable to allocate memory for node");
-
-    // Copy new data to node
-    memcpy(node->data, el, l->elementSize);
     node->next = l->head;
+    if (!l->head)
+        l->tail = node;
     l->head = node;             // reset list head
     l->logicalLength++;         // increase list's logical length
 }
@@ -101,17 +146,8 @@ void ll_push(linkedList *l, void *el)
  */
 void ll_append(linkedList *l, void *el)
 {
-    // Allocate memory for a new list node
-    linkedListNode *node = calloc(1, sizeof(linkedListNode));
-    if (!node)
-        error_abort("unable to allocate memory for node");
-
-    // Allocate memory for node's new data
-    if ((node->data = calloc(1, l->elementSize)) == NULL)
-        error_abort("unable to allocate memory for node");
-
-    // Copy new data into node
-    memcpy(node->data, el, l->elementSize);
+    // Allocate a new list node holding a copy of el
+    linkedListNode *node = ll_newNode(l, el);
 
     // Reset head/tail links
     if (l->logicalLength == 0) {
@@ -139,17 +175,8 @@ void ll_insertAfter(linkedList *l, linkedListNode *prev, void *data)
         return;
     }
 
-    // Allocate memory for the new node
-    linkedListNode *node = calloc(1, sizeof(linkedListNode));
-    if (!node)
-        error_abort("Unable to allocate memory for new node");
-
-    // Allocate memory for the new node's data
-    if (!(node->data = calloc(1, l->elementSize)))
-        error_abort("unable to allocate memory for node");
-
-    // Copy data
-    memcpy(node->data, data, l->elementSize);
+    // Allocate a new node holding a copy of data
+    linkedListNode *node = ll_newNode(l, data);
 
     // Set new node links
     node->next = prev->next;
@@ -171,12 +198,10 @@ void ll_deleteNode(linkedList *l, void *data, nodeComparator cmp)
     // Edge case where node to be deleted is the list's head
     if (entry && cmp(entry->data, data) == 0) {
         l->head = entry->next;
+        if (entry == l->tail)
+            l->tail = NULL;
 
-        if (l->freeFn)
-            l->freeFn(entry->data);
-
-        free(entry->data);
-        free(entry);
+        ll_freeNode(l, entry);
         l->logicalLength--;     // decrease list's length
 
         return;
@@ -186,12 +211,10 @@ void ll_deleteNode(linkedList *l, void *data, nodeComparator cmp)
     while (entry) {
         if (cmp(entry->data, data) == EQUAL) {
             prev->next = entry->next;
+            if (entry == l->tail)
+                l->tail = prev;
 
-            if (l->freeFn)
-                l->freeFn(entry->data);
-
-            free(entry->data);
-            free(entry);
+            ll_freeNode(l, entry);
             l->logicalLength--; // decrease list's length
 
             return;
@@ -226,6 +249,90 @@ void ll_deleteNode(linkedList *l, void *data, nodeComparator cmp)
     /* } */
 }
 
+/**
+ * ll_filter:
+ *      Unlink in one pass every node for which `pred` returns `match`,
+ *      appending it to `dst` if given or freeing it otherwise.
+ *      Returns the number of nodes unlinked.
+ */
+static size_t ll_filter(linkedList *l, nodePredicate pred, void *ctx,
+                        bool match, linkedList *dst)
+{
+    assert(pred);
+
+    linkedListNode **pp = &l->head, *prev = NULL;
+    size_t removed = 0;
+
+    while (*pp) {
+        linkedListNode *entry = *pp;
+
+        // Keep the node and move on
+        if (pred(entry->data, ctx) != match) {
+            prev = entry;
+            pp = &entry->next;
+            continue;
+        }
+
+        *pp = entry->next;
+        removed++;
+
+        if (!dst) {
+            ll_freeNode(l, entry);
+            continue;
+        }
+
+        // Append the node itself to the destination list
+        entry->next = NULL;
+        if (dst->tail)
+            dst->tail->next = entry;
+        else
+            dst->head = entry;
+        dst->tail = entry;
+        dst->logicalLength++;
+    }
+
+    l->tail = prev;
+    l->logicalLength -= removed;
+
+    return removed;
+}
+
+/**
+ * ll_removeIf:
+ *      Remove and free every node whose data satisfies `pred`.
+ *      Returns the number of nodes removed.
+ */
+size_t ll_removeIf(linkedList *l, nodePredicate pred, void *ctx)
+{
+    return ll_filter(l, pred, ctx, true, NULL);
+}
+
+/**
+ * ll_retainIf:
+ *      Remove and free every node whose data does not satisfy `pred`.
+ *      Returns the number of nodes removed.
+ */
+size_t ll_retainIf(linkedList *l, nodePredicate pred, void *ctx)
+{
+    return ll_filter(l, pred, ctx, false, NULL);
+}
+
+/**
+ * ll_moveIf:
+ *      Move every node whose data satisfies `pred` to the end of `dst`,
+ *      keeping their order, without copying or freeing them.  Both lists
+ *      must hold elements of the same size, the moved data is later freed
+ *      with the freeFunction of `dst`.
+ *      Returns the number of nodes moved.
+ */
+size_t ll_moveIf(linkedList *l, linkedList *dst, nodePredicate pred,
+                 void *ctx)
+{
+    assert(dst && dst != l && dst->elementSize == l->elementSize);
+
+    return ll_filter(l, pred, ctx, true, dst);
+}
+
 /**
  * ll_getNodeAt:
  *      Return node at given position in list.
@@ -236,6 +343,10 @@ linkedListNode *ll_getNodeAt(linkedList *l, size_t index)
     if (index > l->logicalLength)
         return NULL;
 
+    // The tail needs no walk
+    if (index && index == l->logicalLength)
+        return l->tail;
+
     linkedListNode *curr = l->head;
     size_t i;
 
@@ -291,6 +402,92 @@ void ll_foreach(linkedList *l, listIterator it, displayFunction display)
     }
 }
 
+/**
+ * ll_foreachBatch:
+ *      Iterate over a singly linked list handing `it` the data pointers
+ *      of up to `batch` nodes at a time, 0 picks a default batch size,
+ *      along with `ctx`.  Stops early when `it` returns false.
+ */
+void ll_foreachBatch(linkedList *l, size_t batch, batchIterator it, void *ctx)
+{
+    // Assert that a batch iterating function was passed
+    assert(it);
+
+    if (!batch)
+        batch = LL_BATCH;
+
+    void **elements = malloc(batch * sizeof(void *));
+    if (!elements)
+        error_abort("Unable to allocate batch");
+
+    linkedListNode *node = l->head;
+    bool result = true;
+
+    // Gather a batch of data pointers and hand it over in one call
+    while (node && result) {
+        size_t n = 0;
+        for (; node && n < batch; node = node->next)
+            elements[n++] = node->data;
+
+        result = it(elements, n, ctx);
+    }
+
+    free(elements);
+}
+
+/**
+ * ll_foreachBatchCopy:
+ *      Iterate over a singly linked list handing `it` contiguous copies of
+ *      the data of up to `batch` nodes at a time, 0 picks a default batch
+ *      size, along with `ctx`.  Changes to the copies are not written back.
+ *      Stops early when `it` returns false.
+ */
+void ll_foreachBatchCopy(linkedList *l, size_t batch, copyBatchIterator it,
+                         void *ctx)
+{
+    // Assert that a batch iterating function was passed
+    assert(it);
+
+    if (!batch)
+        batch = LL_BATCH;
+
+    char *elements = malloc(batch * l->elementSize);
+    if (!elements)
+        error_abort("Unable to allocate batch");
+
+    linkedListNode *node = l->head;
+    bool result = true;
+
+    // Copy a batch of elements side by side and hand it over in one call
+    while (node && result) {
+        size_t n = 0;
+        for (; node && n < batch; node = node->next, n++)
+            memcpy(elements + n * l->elementSize, node->data, l->elementSize);
+
+        result = it(elements, n, ctx);
+    }
+
+    free(elements);
+}
+
+/**
+ * ll_toArray:
+ *      Copy the data of every node of a singly linked list, in order, into
+ *      the contiguous buffer `arr` which must hold ll_length elements.
+ *      Returns the number of elements copied.
+ */
+size_t ll_toArray(linkedList *l, void *arr)
+{
+    char *dst = arr;
+    size_t n = 0;
+
+    // Copy each node's data to the next slot of the buffer
+    for (linkedListNode *node = l->head; node; node = node->next, n++)
+        memcpy(dst + n * l->elementSize, node->data, l->elementSize);
+
+    return n;                   // return number of elements copied
+}
+
 /**
  * ll_head:
  *      Return a copy of the head node's data of a singly linked list
@@ -308,14 +505,11 @@ void ll_head(linkedList *l, void *el, bool remove)
     // Remove/pop head node from list
     if (remove) {
         l->head = node->next;
+        if (!l->head)
+            l->tail = NULL;
 
-        // Use freeFuction if it exists
-        if (l->freeFn)
-            l->freeFn(node->data);
-
-        free(node->data);
-        free(node);
-        l->logicalLength--;     // increase list's logical length
+        ll_freeNode(l, node);
+        l->logicalLength--;     // decrease list's logical length
     }
 }
 
@@ -382,6 +576,9 @@ void ll_reverse(linkedList *l)
     linkedListNode *prev = NULL;
     linkedListNode *curr = l->head;
 
+    // Old head becomes the new tail
+    l->tail = l->head;
+
     // Swap nodes
     while (curr) {
         next = curr->next;
@@ -400,21 +597,19 @@ void ll_reverse(linkedList *l)
  */
 void ll_swapNodeData(linkedList *l, linkedListNode *a, linkedListNode *b)
 {
-    // Allocate a temporary node
-    linkedListNode *tmp = calloc(1, sizeof(linkedListNode));
-    if (!tmp)
-        error_abort("Unable to allocate memory for a temporary node");
+    if (a == b)
+        return;
 
-    if (!(tmp->data = calloc(1, sizeof(l->elementSize))))
+    // Allocate temporary storage for one element
+    void *tmp = malloc(l->elementSize);
+    if (!tmp)
         error_abort("Unable to allocate memory for temporary node data");
 
     // Swap data
-    memmove(tmp->data, a->data, l->elementSize);
-    memmove(a->data, b->data, l->elementSize);
-    memmove(b->data, tmp->data, l->elementSize);
+    memcpy(tmp, a->data, l->elementSize);
+    memcpy(a->data, b->data, l->elementSize);
+    memcpy(b->data, tmp, l->elementSize);
 
-    // Free temporary node
-    free(tmp->data);
     free(tmp);
 }
 
@@ -468,28 +663,136 @@ linkedList *ll_split(linkedList *a)
 
     // Create and initialize a new list with the second half of the original
     linkedList *b = calloc(1, sizeof(linkedList));
+    if (!b)
+        error_abort("Unable to allocate linkedList");
+
     b->elementSize = a->elementSize;
+    b->freeFn = a->freeFn;
+    b->cached = a->cached;
     b->head = slow->next;
+    b->tail = a->tail;
     slow->next = NULL;
     size_t b_len;
     linkedListNode *it = b->head;
-    for (b_len = 0; it; b_len++) {
-        b->tail = it;
+    for (b_len = 0; it; b_len++)
         it = it->next;
-    }
     b->logicalLength = b_len;
-    size_t a_len;
 
-    it = a->head;
-    for (a_len = 0; it; a_len++) {
-        it = it->next;
-    }
-    a->tail = it;
-    a->logicalLength = a_len;
+    a->tail = slow;
+    a->logicalLength -= b_len;
 
     return b;                   // return the second half of the list
 }
 
+/**
+ * ll_compactFrom:
+ *      Move up to `n` nodes following `prev`, or from the head if `prev` is
+ *      NULL, into fresh runs of blocks laid out in list order and free
+ *      their old blocks.  Element bytes are moved unchanged, so whatever
+ *      they point to is still owned by the list's freeFunction.
+ *      Returns the new location of the last node moved, to be passed as
+ *      `prev` to the next call, or NULL if no node was left to move.
+ */
+linkedListNode *ll_compactFrom(linkedList *l, linkedListNode *prev, size_t n)
+{
+    linkedListNode **link = prev ? &prev->next : &l->head;
+    linkedListNode *last = NULL;
+    size_t size = LL_DATA_OFFSET + l->elementSize;
+    size_t runNodes = LL_COMPACT_RUN / size ? LL_COMPACT_RUN / size : 1;
+
+    // Never ask for more blocks than there can be nodes left
+    if (n > l->logicalLength)
+        n = l->logicalLength;
+
+    while (n && *link) {
+        size_t count = n < runNodes ? n : runNodes;
+        size_t stride, moved = 0;
+        char *block = nc_allocRun(size, count, &stride);
+
+        // Copy each node into the next block of the run
+        for (; moved < count && *link; moved++, block += stride) {
+            linkedListNode *old = *link, *node = (linkedListNode *)block;
+
+            node->data = block + LL_DATA_OFFSET;
+            memcpy(node->data, old->data, l->elementSize);
+            node->next = old->next;
+            *link = node;
+            if (l->tail == old)
+                l->tail = node;
+
+            nc_free(old);
+            link = &node->next;
+            last = node;
+        }
+
+        // Give back the blocks the end of the list left unused
+        n -= moved;
+        for (size_t i = moved; i < count; i++, block += stride)
+            nc_free(block);
+    }
+
+    return last;
+}
+
+/**
+ * ll_compact:
+ *      Move every node of a singly linked list into fresh runs of blocks
+ *      laid out in list order, restoring the locality a long lived list
+ *      loses as nodes are inserted and deleted.
+ */
+void ll_compact(linkedList *l)
+{
+    ll_compactFrom(l, NULL, l->logicalLength);
+}
+
+/**
+ * ll_clone:
+ *      Copy a list in one pass into nodes carved from runs of blocks,
+ *      copying each element with `copy` if given, else byte by byte.
+ *      Returns the new list.
+ */
+linkedList *ll_clone(linkedList *l, copyFunction copy)
+{
+    linkedList *c = ll_create(l->elementSize, l->freeFn);
+    size_t size = LL_DATA_OFFSET + l->elementSize;
+    size_t runNodes = LL_COMPACT_RUN / size ? LL_COMPACT_RUN / size : 1;
+    size_t left = l->logicalLength, stride = 0, avail = 0;
+    linkedListNode *last = NULL;
+    char *block = NULL;
+
+    c->cached = l->cached;
+
+    for (linkedListNode *old = l->head; old; old = old->next, left--) {
+        // Start a new run sized for the nodes left
+        if (!avail) {
+            avail = left < runNodes ? left : runNodes;
+            block = nc_allocRun(size, avail, &stride);
+        }
+
+        linkedListNode *node = (linkedListNode *)block;
+        node->data = block + LL_DATA_OFFSET;
+        if (copy)
+            copy(node->data, old->data);
+        else
+            memcpy(node->data, old->data, l->elementSize);
+
+        node->next = NULL;
+        if (last)
+            last->next = node;
+        else
+            c->head = node;
+
+        last = node;
+        block += stride;
+        avail--;
+    }
+
+    c->tail = last;
+    c->logicalLength = l->logicalLength;
+
+    return c;                   // return the clone
+}
+
 /**
  * ll_hasCycle:
  *        Detect a cycle/loop in a linked list.
@@ -540,3 +843,117 @@ size_t ll_detectAndRemoveCycles(linkedList *l)
 
     return cycles;
 }
+
+/**
+ * ll_cursor:
+ *      Return a cursor on the head node of a list.
+ */
+llCursor ll_cursor(linkedList *l)
+{
+    llCursor c = { l, NULL, l->head };
+
+    return c;
+}
+
+/**
+ * llc_valid:
+ *      Return true if the cursor is on a node.
+ */
+bool llc_valid(llCursor *c)
+{
+    return c->curr != NULL;
+}
+
+/**
+ * llc_next:
+ *      Move a cursor to the following node, past the tail it is no longer
+ *      valid.
+ */
+void llc_next(llCursor *c)
+{
+    if (!c->curr)
+        return;
+
+    c->prev = c->curr;
+    c->curr = c->curr->next;
+}
+
+/**
+ * llc_get:
+ *      Return a pointer to the data of the cursor's node.
+ */
+void *llc_get(llCursor *c)
+{
+    assert(c->curr);
+
+    return c->curr->data;
+}
+
+/**
+ * llc_set:
+ *      Replace the data of the cursor's node with a copy of `el`, the old
+ *      data is passed to the list's freeFunction first.
+ */
+void llc_set(llCursor *c, void *el)
+{
+    assert(c->curr);
+
+    if (c->list->freeFn)
+        c->list->freeFn(c->curr->data);
+
+    memcpy(c->curr->data, el, c->list->elementSize);
+}
+
+/**
+ * llc_remove:
+ *      Remove the cursor's node and move the cursor to the node that
+ *      followed it.
+ */
+void llc_remove(llCursor *c)
+{
+    assert(c->curr);
+
+    linkedList *l = c->list;
+    linkedListNode *node = c->curr;
+
+    // Unlink the node using the tracked predecessor
+    if (c->prev)
+        c->prev->next = node->next;
+    else
+        l->head = node->next;
+    if (l->tail == node)
+        l->tail = c->prev;
+
+    c->curr = node->next;
+    ll_freeNode(l, node);
+    l->logicalLength--;         // decrease list's logical length
+}
+
+/**
+ * llc_insertBefore:
+ *      Insert a new node before the cursor's node, or append it if the
+ *      cursor is past the tail.  The cursor stays on its node.
+ */
+void llc_insertBefore(llCursor *c, void *el)
+{
+    linkedList *l = c->list;
+
+    if (!c->prev)
+        ll_push(l, el);
+    else
+        ll_insertAfter(l, c->prev, el);
+
+    c->prev = c->prev ? c->prev->next : l->head;
+}
+
+/**
+ * llc_insertAfter:
+ *      Insert a new node after the cursor's node.  The cursor stays on
+ *      its node.
+ */
+void llc_insertAfter(llCursor *c, void *el)
+{
+    assert(c->curr);
+
+    ll_insertAfter(c->list, c->curr, el);
+}
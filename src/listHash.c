@@ -0,0 +1,301 @@
+/** listHash.c - Hash based unique and groupBy list operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "lists.h"
+#include "nodeCache.h"
+#include "errors.h"
+
+#define LH_MIN_SLOTS 16         // smallest hash table
+
+// Hash table slot
+typedef struct hashSlot {
+    uint64_t hash;              // mixed hash of the key
+    const void *key;            // element looked up, NULL if the slot is free
+    void *item;                 // value kept for the key
+} hashSlot;
+
+// Hash table sized for a list
+typedef struct hashTable {
+    hashSlot *slots;            // slots, a power of two of them
+    size_t mask;                // number of slots minus one
+} hashTable;
+
+/**
+ * lh_create:
+ *      Create a table that stays at most half full holding `n` keys.
+ */
+static hashTable lh_create(size_t n)
+{
+    hashTable t;
+    size_t count = LH_MIN_SLOTS;
+
+    while (count < 2 * n)
+        count *= 2;
+
+    t.slots = calloc(count, sizeof(hashSlot));
+    if (!t.slots)
+        error_abort("Unable to allocate hash table");
+    t.mask = count - 1;
+
+    return t;
+}
+
+/**
+ * lh_mix:
+ *      Spread the bits of a hash so that weak hash functions, such as the
+ *      identity, still probe well.
+ */
+static inline uint64_t lh_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+/**
+ * lh_probe:
+ *      Return the slot holding a key EQUAL to `data`, or the free slot
+ *      where it would go.
+ */
+static hashSlot *lh_probe(hashTable *t, uint64_t hash, const void *data,
+                          nodeComparator cmp)
+{
+    size_t i = hash & t->mask;
+
+    // Linear probing, compare hashes before keys
+    while (t->slots[i].key && (t->slots[i].hash != hash ||
+                               cmp(t->slots[i].key, data) != EQUAL))
+        i = (i + 1) & t->mask;
+
+    return &t->slots[i];
+}
+
+/**
+ * lh_freeGroup, lh_freeDGroup:
+ *      Free functions deleting the sublists made by groupBy.
+ */
+static void lh_freeGroup(void *data)
+{
+    ll_delete(*(linkedList **)data);
+}
+
+static void lh_freeDGroup(void *data)
+{
+    dll_delete(*(dLinkedList **)data);
+}
+
+/**
+ * ll_unique:
+ *      Remove and free every node equal to an earlier node, keeping the
+ *      order of the nodes left.
+ *      Returns the number of nodes removed.
+ */
+size_t ll_unique(linkedList *l, hashFunction hash, nodeComparator cmp)
+{
+    assert(hash && cmp);
+
+    hashTable t = lh_create(l->logicalLength);
+    linkedListNode *prev = NULL, *node = l->head;
+    size_t removed = 0;
+
+    while (node) {
+        linkedListNode *next = node->next;
+        uint64_t h = lh_mix(hash(node->data));
+        hashSlot *s = lh_probe(&t, h, node->data, cmp);
+
+        if (s->key) {
+            // A duplicate is never the head, unlink it after prev
+            prev->next = next;
+            if (l->tail == node)
+                l->tail = prev;
+
+            // Use freeFunction if it exists
+            if (l->freeFn)
+                l->freeFn(node->data);
+            nc_free(node);
+            removed++;
+        } else {
+            s->hash = h;
+            s->key = node->data;
+            prev = node;
+        }
+
+        node = next;
+    }
+
+    l->logicalLength -= removed;
+    free(t.slots);
+
+    return removed;
+}
+
+/**
+ * ll_groupBy:
+ *      Move every node of a list onto a sublist of the nodes with equal
+ *      elements, leaving the list empty.
+ *      Returns a list of the sublists in order of first occurrence.
+ */
+linkedList *ll_groupBy(linkedList *l, hashFunction hash, nodeComparator cmp)
+{
+    assert(hash && cmp);
+
+    linkedList *groups = ll_create(sizeof(linkedList *), lh_freeGroup);
+    hashTable t = lh_create(l->logicalLength);
+    linkedListNode *node = l->head;
+
+    while (node) {
+        linkedListNode *next = node->next;
+        uint64_t h = lh_mix(hash(node->data));
+        hashSlot *s = lh_probe(&t, h, node->data, cmp);
+        linkedList *g = s->item;
+
+        // Start a sublist for a new key
+        if (!s->key) {
+            g = ll_create(l->elementSize, l->freeFn);
+            g->cached = l->cached;
+            ll_append(groups, &g);
+            s->hash = h;
+            s->key = node->data;
+            s->item = g;
+        }
+
+        // Relink the node at the end of its sublist
+        node->next = NULL;
+        if (g->tail)
+            g->tail->next = node;
+        else
+            g->head = node;
+        g->tail = node;
+        g->logicalLength++;
+
+        node = next;
+    }
+
+    l->head = l->tail = NULL;
+    l->logicalLength = 0;
+    free(t.slots);
+
+    return groups;
+}
+
+/**
+ * dll_unique:
+ *      Remove and free every node equal to an earlier node, keeping the
+ *      order of the nodes left.
+ *      Returns the number of nodes removed.
+ */
+size_t dll_unique(dLinkedList *l, hashFunction hash, nodeComparator cmp)
+{
+    assert(hash && cmp);
+
+    hashTable t = lh_create(l->logicalLength);
+    dLinkedListNode *node = l->head;
+    size_t removed = 0;
+
+    while (node) {
+        dLinkedListNode *next = node->next;
+        uint64_t h = lh_mix(hash(node->data));
+        hashSlot *s = lh_probe(&t, h, node->data, cmp);
+
+        if (s->key) {
+            // A duplicate is never the head, unlink it after its prev
+            node->prev->next = next;
+            if (next)
+                next->prev = node->prev;
+            else
+                l->tail = node->prev;
+
+            // Use freeFunction if it exists
+            if (l->freeFn)
+                l->freeFn(node->data);
+            nc_free(node);
+            removed++;
+        } else {
+            s->hash = h;
+            s->key = node->data;
+        }
+
+        node = next;
+    }
+
+    l->logicalLength -= removed;
+    free(t.slots);
+
+    return removed;
+}
+
+/**
+ * dll_groupBy:
+ *      Move every node of a list onto a sublist of the nodes with equal
+ *      elements, leaving the list empty.
+ *      Returns a list of the sublists in order of first occurrence.
+ */
+linkedList *dll_groupBy(dLinkedList *l, hashFunction hash,
+                        nodeComparator cmp)
+{
+    assert(hash && cmp);
+
+    linkedList *groups = ll_create(sizeof(dLinkedList *), lh_freeDGroup);
+    hashTable t = lh_create(l->logicalLength);
+    dLinkedListNode *node = l->head;
+
+    while (node) {
+        dLinkedListNode *next = node->next;
+        uint64_t h = lh_mix(hash(node->data));
+        hashSlot *s = lh_probe(&t, h, node->data, cmp);
+        dLinkedList *g = s->item;
+
+        // Start a sublist for a new key
+        if (!s->key) {
+            g = dll_create(l->elementSize, l->freeFn);
+            g->cached = l->cached;
+            ll_append(groups, &g);
+            s->hash = h;
+            s->key = node->data;
+            s->item = g;
+        }
+
+        // Relink the node at the end of its sublist
+        node->prev = g->tail;
+        node->next = NULL;
+        if (g->tail)
+            g->tail->next = node;
+        else
+            g->head = node;
+        g->tail = node;
+        g->logicalLength++;
+
+        node = next;
+    }
+
+    l->head = l->tail = NULL;
+    l->logicalLength = 0;
+    free(t.slots);
+
+    return groups;
+}
@@ -0,0 +1,227 @@
+/** listMerge.c - K-way merge of sorted lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "lists.h"
+#include "errors.h"
+
+// Head of one list being merged
+typedef struct mergeEntry {
+    void *node;                 // next node to take from the list
+    const void *data;           // its data
+    void *tail;                 // last node of the list
+    size_t index;               // position of the list, breaks ties
+} mergeEntry;
+
+/**
+ * lm_less:
+ *      Return true if entry `a` is to be taken before entry `b`, lists
+ *      earlier in the array winning ties so that the merge is stable.
+ */
+static inline bool lm_less(const mergeEntry *a, const mergeEntry *b,
+                           nodeComparator cmp)
+{
+    result r = cmp(a->data, b->data);
+
+    return r == LESS || (r == EQUAL && a->index < b->index);
+}
+
+/**
+ * lm_siftDown:
+ *      Sift the entry at `i` down a heap of list heads.
+ */
+static void lm_siftDown(mergeEntry *heap, size_t size, size_t i,
+                        nodeComparator cmp)
+{
+    mergeEntry e = heap[i];
+
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= size)
+            break;
+
+        // Pick the child taken first
+        if (child + 1 < size && lm_less(&heap[child + 1], &heap[child], cmp))
+            child++;
+        if (!lm_less(&heap[child], &e, cmp))
+            break;
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    heap[i] = e;
+}
+
+/**
+ * lm_heapify:
+ *      Order an array of list heads as a heap.
+ */
+static void lm_heapify(mergeEntry *heap, size_t size, nodeComparator cmp)
+{
+    for (size_t i = size / 2; i > 0; i--)
+        lm_siftDown(heap, size, i - 1, cmp);
+}
+
+/**
+ * ll_mergeK:
+ *      Merge `k` lists, each sorted by `cmp`, by relinking their nodes
+ *      into one sorted list.  Equal elements keep the order of the lists
+ *      they came from.  The lists given are left empty.
+ *      Returns the merged list.
+ */
+linkedList *ll_mergeK(linkedList **lists, size_t k, nodeComparator cmp)
+{
+    assert(lists && k && cmp);
+
+    linkedList *m = ll_create(lists[0]->elementSize, lists[0]->freeFn);
+    mergeEntry *heap = malloc(k * sizeof(mergeEntry));
+    size_t size = 0;
+
+    if (!heap)
+        error_abort("Unable to allocate merge heap");
+    m->cached = lists[0]->cached;
+
+    // Take the nodes of every list
+    for (size_t i = 0; i < k; i++) {
+        assert(lists[i]->elementSize == m->elementSize);
+
+        if (lists[i]->head)
+            heap[size++] = (mergeEntry) { lists[i]->head,
+                lists[i]->head->data, lists[i]->tail, i };
+
+        m->logicalLength += lists[i]->logicalLength;
+        lists[i]->head = lists[i]->tail = NULL;
+        lists[i]->logicalLength = 0;
+    }
+
+    lm_heapify(heap, size, cmp);
+
+    linkedListNode *tail = NULL;
+    while (size > 1) {
+        linkedListNode *node = heap[0].node;
+
+        // Append the first head and replace it with its successor
+        if (tail)
+            tail->next = node;
+        else
+            m->head = node;
+        tail = node;
+
+        if (node->next) {
+            heap[0].node = node->next;
+            heap[0].data = node->next->data;
+        } else {
+            heap[0] = heap[--size];
+        }
+        lm_siftDown(heap, size, 0, cmp);
+    }
+
+    // The last list left is appended whole
+    if (size) {
+        if (tail)
+            tail->next = heap[0].node;
+        else
+            m->head = heap[0].node;
+        tail = heap[0].tail;
+    }
+
+    m->tail = tail;
+    free(heap);
+
+    return m;                   // return the merged list
+}
+
+/**
+ * dll_mergeK:
+ *      Merge `k` lists, each sorted by `cmp`, by relinking their nodes
+ *      into one sorted list.  Equal elements keep the order of the lists
+ *      they came from.  The lists given are left empty.
+ *      Returns the merged list.
+ */
+dLinkedList *dll_mergeK(dLinkedList **lists, size_t k, nodeComparator cmp)
+{
+    assert(lists && k && cmp);
+
+    dLinkedList *m = dll_create(lists[0]->elementSize, lists[0]->freeFn);
+    mergeEntry *heap = malloc(k * sizeof(mergeEntry));
+    size_t size = 0;
+
+    if (!heap)
+        error_abort("Unable to allocate merge heap");
+    m->cached = lists[0]->cached;
+
+    // Take the nodes of every list
+    for (size_t i = 0; i < k; i++) {
+        assert(lists[i]->elementSize == m->elementSize);
+
+        if (lists[i]->head)
+            heap[size++] = (mergeEntry) { lists[i]->head,
+                lists[i]->head->data, lists[i]->tail, i };
+
+        m->logicalLength += lists[i]->logicalLength;
+        lists[i]->head = lists[i]->tail = NULL;
+        lists[i]->logicalLength = 0;
+    }
+
+    lm_heapify(heap, size, cmp);
+
+    dLinkedListNode *tail = NULL;
+    while (size > 1) {
+        dLinkedListNode *node = heap[0].node;
+
+        // Append the first head and replace it with its successor
+        node->prev = tail;
+        if (tail)
+            tail->next = node;
+        else
+            m->head = node;
+        tail = node;
+
+        if (node->next) {
+            heap[0].node = node->next;
+            heap[0].data = node->next->data;
+        } else {
+            heap[0] = heap[--size];
+        }
+        lm_siftDown(heap, size, 0, cmp);
+    }
+
+    // The last list left is appended whole
+    if (size) {
+        dLinkedListNode *rest = heap[0].node;
+        rest->prev = tail;
+        if (tail)
+            tail->next = rest;
+        else
+            m->head = rest;
+        tail = heap[0].tail;
+    }
+
+    m->tail = tail;
+    free(heap);
+
+    return m;                   // return the merged list
+}
@@ -0,0 +1,419 @@
+/** listSelect.c - Partition, selection and top-k list operations.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lists.h"
+#include "errors.h"
+
+// Chain of singly linked nodes being relinked
+typedef struct llChain {
+    linkedListNode *head;       // first node, NULL if empty
+    linkedListNode *tail;       // last node
+    size_t length;              // number of nodes
+} llChain;
+
+// Chain of doubly linked nodes being relinked
+typedef struct dllChain {
+    dLinkedListNode *head;      // first node, NULL if empty
+    dLinkedListNode *tail;      // last node
+    size_t length;              // number of nodes
+} dllChain;
+
+/**
+ * ls_add, ls_append:
+ *      Add a node to the end of a chain, or a chain to the end of another.
+ */
+static inline void ls_add(llChain *c, linkedListNode *node)
+{
+    node->next = NULL;
+    if (c->tail)
+        c->tail->next = node;
+    else
+        c->head = node;
+    c->tail = node;
+    c->length++;
+}
+
+static inline void ls_append(llChain *a, llChain *b)
+{
+    if (!b->length)
+        return;
+
+    if (a->tail)
+        a->tail->next = b->head;
+    else
+        a->head = b->head;
+    a->tail = b->tail;
+    a->length += b->length;
+}
+
+/**
+ * dls_add, dls_append:
+ *      Add a node to the end of a chain, or a chain to the end of another.
+ */
+static inline void dls_add(dllChain *c, dLinkedListNode *node)
+{
+    node->prev = c->tail;
+    node->next = NULL;
+    if (c->tail)
+        c->tail->next = node;
+    else
+        c->head = node;
+    c->tail = node;
+    c->length++;
+}
+
+static inline void dls_append(dllChain *a, dllChain *b)
+{
+    if (!b->length)
+        return;
+
+    b->head->prev = a->tail;
+    if (a->tail)
+        a->tail->next = b->head;
+    else
+        a->head = b->head;
+    a->tail = b->tail;
+    a->length += b->length;
+}
+
+/**
+ * ls_random:
+ *      Return the next number of a xorshift sequence, used to pick pivots
+ *      without touching the state of rand.
+ */
+static inline uint64_t ls_random(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return *state = x;
+}
+
+/**
+ * ls_heapDown:
+ *      Sift the element at `i` down a min heap of element pointers.
+ */
+static void ls_heapDown(void **heap, size_t size, size_t i,
+                        nodeComparator cmp)
+{
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= size)
+            break;
+
+        // Pick the smaller child
+        if (child + 1 < size && cmp(heap[child + 1], heap[child]) == LESS)
+            child++;
+        if (cmp(heap[child], heap[i]) != LESS)
+            break;
+
+        void *tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/**
+ * ls_heapOffer:
+ *      Keep `data` in a min heap holding the `k` greatest elements seen.
+ *      Returns the new size of the heap.
+ */
+static size_t ls_heapOffer(void **heap, size_t size, size_t k, void *data,
+                           nodeComparator cmp)
+{
+    if (size < k) {
+        // Sift the new element up
+        size_t i = size++;
+        heap[i] = data;
+        while (i && cmp(heap[i], heap[(i - 1) / 2]) == LESS) {
+            void *tmp = heap[i];
+            heap[i] = heap[(i - 1) / 2];
+            heap[(i - 1) / 2] = tmp;
+            i = (i - 1) / 2;
+        }
+    } else if (cmp(data, heap[0]) == GREATER) {
+        // Replace the least element kept
+        heap[0] = data;
+        ls_heapDown(heap, size, 0, cmp);
+    }
+
+    return size;
+}
+
+/**
+ * ls_heapDrain:
+ *      Copy the elements of a heap to `out`, greatest first.
+ */
+static void ls_heapDrain(void **heap, size_t size, nodeComparator cmp,
+                         void *out, size_t elementSize)
+{
+    // Pop the least element into the last free place
+    while (size) {
+        memcpy((char *)out + (size - 1) * elementSize, heap[0], elementSize);
+        heap[0] = heap[--size];
+        ls_heapDown(heap, size, 0, cmp);
+    }
+}
+
+/**
+ * ll_partition:
+ *      Stably relink a list so the nodes whose data satisfies `pred` come
+ *      before those that do not.
+ *      Returns the number of nodes that satisfy `pred`.
+ */
+size_t ll_partition(linkedList *l, nodePredicate pred, void *ctx)
+{
+    assert(pred);
+
+    llChain yes = { 0 }, no = { 0 };
+
+    for (linkedListNode *node = l->head, *next; node; node = next) {
+        next = node->next;
+        ls_add(pred(node->data, ctx) ? &yes : &no, node);
+    }
+
+    size_t matched = yes.length;
+    ls_append(&yes, &no);
+    l->head = yes.head;
+    l->tail = yes.tail;
+
+    return matched;
+}
+
+/**
+ * ll_nthElement:
+ *      Relink a list so the node at `n`, counting from 1, holds the
+ *      element that would be there if the list were sorted, with no
+ *      greater element before it and no lesser one after it.  Runs in
+ *      expected O(n) by quickselect.
+ *      Returns the node, or NULL if the list is shorter than `n`.
+ */
+linkedListNode *ll_nthElement(linkedList *l, size_t n, nodeComparator cmp)
+{
+    assert(cmp);
+
+    if (n == 0 || n > l->logicalLength)
+        return NULL;
+
+    llChain before = { 0 }, after = { 0 };
+    llChain seg = { l->head, l->tail, l->logicalLength };
+    uint64_t seed = (uintptr_t)l ^ (l->logicalLength * 0x9e3779b97f4a7c15);
+    linkedListNode *found = NULL;
+
+    seed |= 1;                  // xorshift must not start at 0
+    while (!found) {
+        // Pick a random pivot from the segment holding the nth node
+        linkedListNode *pivot = seg.head;
+        for (size_t i = ls_random(&seed) % seg.length; i; i--)
+            pivot = pivot->next;
+
+        // Split the segment around it, keeping the order of each part
+        llChain lt = { 0 }, eq = { 0 }, gt = { 0 };
+        for (linkedListNode *node = seg.head, *next; node; node = next) {
+            next = node->next;
+            result r = cmp(node->data, pivot->data);
+            ls_add(r == LESS ? &lt : r == EQUAL ? &eq : &gt, node);
+        }
+
+        if (n <= lt.length) {
+            ls_append(&eq, &gt);
+            ls_append(&eq, &after);
+            after = eq;
+            seg = lt;
+        } else if (n <= lt.length + eq.length) {
+            found = eq.head;
+            for (size_t i = n - lt.length - 1; i; i--)
+                found = found->next;
+
+            ls_append(&before, &lt);
+            ls_append(&before, &eq);
+            ls_append(&before, &gt);
+            ls_append(&before, &after);
+        } else {
+            n -= lt.length + eq.length;
+            ls_append(&before, &lt);
+            ls_append(&before, &eq);
+            seg = gt;
+        }
+    }
+
+    l->head = before.head;
+    l->tail = before.tail;
+
+    return found;
+}
+
+/**
+ * ll_topK:
+ *      Copy the `k` greatest elements of a list to `out`, greatest first,
+ *      in one pass keeping them in a bounded heap.
+ *      Returns the number of elements copied.
+ */
+size_t ll_topK(linkedList *l, size_t k, nodeComparator cmp, void *out)
+{
+    assert(cmp);
+
+    if (k > l->logicalLength)
+        k = l->logicalLength;
+    if (k == 0)
+        return 0;
+
+    void **heap = malloc(k * sizeof(void *));
+    if (!heap)
+        error_abort("Unable to allocate heap");
+
+    size_t size = 0;
+    for (linkedListNode *node = l->head; node; node = node->next)
+        size = ls_heapOffer(heap, size, k, node->data, cmp);
+
+    ls_heapDrain(heap, size, cmp, out, l->elementSize);
+    free(heap);
+
+    return k;
+}
+
+/**
+ * dll_partition:
+ *      Stably relink a list so the nodes whose data satisfies `pred` come
+ *      before those that do not.
+ *      Returns the number of nodes that satisfy `pred`.
+ */
+size_t dll_partition(dLinkedList *l, nodePredicate pred, void *ctx)
+{
+    assert(pred);
+
+    dllChain yes = { 0 }, no = { 0 };
+
+    for (dLinkedListNode *node = l->head, *next; node; node = next) {
+        next = node->next;
+        dls_add(pred(node->data, ctx) ? &yes : &no, node);
+    }
+
+    size_t matched = yes.length;
+    dls_append(&yes, &no);
+    l->head = yes.head;
+    l->tail = yes.tail;
+
+    return matched;
+}
+
+/**
+ * dll_nthElement:
+ *      Relink a list so the node at `n`, counting from 1, holds the
+ *      element that would be there if the list were sorted, with no
+ *      greater element before it and no lesser one after it.  Runs in
+ *      expected O(n) by quickselect.
+ *      Returns the node, or NULL if the list is shorter than `n`.
+ */
+dLinkedListNode *dll_nthElement(dLinkedList *l, size_t n,
+                                nodeComparator cmp)
+{
+    assert(cmp);
+
+    if (n == 0 || n > l->logicalLength)
+        return NULL;
+
+    dllChain before = { 0 }, after = { 0 };
+    dllChain seg = { l->head, l->tail, l->logicalLength };
+    uint64_t seed = (uintptr_t)l ^ (l->logicalLength * 0x9e3779b97f4a7c15);
+    dLinkedListNode *found = NULL;
+
+    seed |= 1;                  // xorshift must not start at 0
+    while (!found) {
+        // Pick a random pivot from the segment holding the nth node
+        dLinkedListNode *pivot = seg.head;
+        for (size_t i = ls_random(&seed) % seg.length; i; i--)
+            pivot = pivot->next;
+
+        // Split the segment around it, keeping the order of each part
+        dllChain lt = { 0 }, eq = { 0 }, gt = { 0 };
+        for (dLinkedListNode *node = seg.head, *next; node; node = next) {
+            next = node->next;
+            result r = cmp(node->data, pivot->data);
+            dls_add(r == LESS ? &lt : r == EQUAL ? &eq : &gt, node);
+        }
+
+        if (n <= lt.length) {
+            dls_append(&eq, &gt);
+            dls_append(&eq, &after);
+            after = eq;
+            seg = lt;
+        } else if (n <= lt.length + eq.length) {
+            found = eq.head;
+            for (size_t i = n - lt.length - 1; i; i--)
+                found = found->next;
+
+            dls_append(&before, &lt);
+            dls_append(&before, &eq);
+            dls_append(&before, &gt);
+            dls_append(&before, &after);
+        } else {
+            n -= lt.length + eq.length;
+            dls_append(&before, &lt);
+            dls_append(&before, &eq);
+            seg = gt;
+        }
+    }
+
+    l->head = before.head;
+    l->tail = before.tail;
+
+    return found;
+}
+
+/**
+ * dll_topK:
+ *      Copy the `k` greatest elements of a list to `out`, greatest first,
+ *      in one pass keeping them in a bounded heap.
+ *      Returns the number of elements copied.
+ */
+size_t dll_topK(dLinkedList *l, size_t k, nodeComparator cmp, void *out)
+{
+    assert(cmp);
+
+    if (k > l->logicalLength)
+        k = l->logicalLength;
+    if (k == 0)
+        return 0;
+
+    void **heap = malloc(k * sizeof(void *));
+    if (!heap)
+        error_abort("Unable to allocate heap");
+
+    size_t size = 0;
+    for (dLinkedListNode *node = l->head; node; node = node->next)
+        size = ls_heapOffer(heap, size, k, node->data, cmp);
+
+    ls_heapDrain(heap, size, cmp, out, l->elementSize);
+    free(heap);
+
+    return k;
+}
@@ -0,0 +1,457 @@
+/** lruCache.c - LRU cache implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lruCache.h"
+#include "nodeCache.h"
+#include "errors.h"
+
+#define LRU_MIN_SLOTS 16        // initial hash table size
+#define LRU_PROTECTED 80        // percent of entries in the protected segment
+
+// Header of each entry, the key and the value follow it
+typedef struct lruEntry {
+    uint64_t hash;              // hash of the key
+    size_t bytes;               // bytes charged for the entry
+    bool isProtected;           // entry is in the protected segment
+} lruEntry;
+
+// Offsets of the key and value within an entry
+#define LRU_KEY_OFFSET NC_ALIGN(sizeof(lruEntry))
+#define LRU_VALUE_OFFSET(c) (LRU_KEY_OFFSET + NC_ALIGN((c)->keySize))
+
+/**
+ * lru_key, lru_value:
+ *      Return pointers to the key and value of an entry node.
+ */
+static inline void *lru_key(dLinkedListNode *node)
+{
+    return (char *)node->data + LRU_KEY_OFFSET;
+}
+
+static inline void *lru_value(lruCache *c, dLinkedListNode *node)
+{
+    return (char *)node->data + LRU_VALUE_OFFSET(c);
+}
+
+/**
+ * lru_unlink:
+ *      Unlink a node from a list without freeing it.
+ */
+static void lru_unlink(dLinkedList *l, dLinkedListNode *node)
+{
+    // Reset node links, including the list's head/tail
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        l->head = node->next;
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        l->tail = node->prev;
+
+    node->prev = node->next = NULL;
+    l->logicalLength--;
+}
+
+/**
+ * lru_pushFront:
+ *      Link an unlinked node in at the head of a list.
+ */
+static void lru_pushFront(dLinkedList *l, dLinkedListNode *node)
+{
+    node->prev = NULL;
+    node->next = l->head;
+    if (l->head)
+        l->head->prev = node;
+    else
+        l->tail = node;
+
+    l->head = node;
+    l->logicalLength++;
+}
+
+/**
+ * lru_segment:
+ *      Return the list holding an entry node.
+ */
+static inline dLinkedList *lru_segment(lruCache *c, dLinkedListNode *node)
+{
+    return ((lruEntry *)node->data)->isProtected ? c->protectedList
+                                                 : c->probation;
+}
+
+/**
+ * lru_slot:
+ *      Return the slot holding the node for `key`, or the empty slot where
+ *      it would go.
+ */
+static size_t lru_slot(lruCache *c, const void *key, uint64_t hash)
+{
+    size_t mask = c->slotCount - 1;
+    size_t i = hash & mask;
+
+    // Linear probing, compare hashes before keys
+    while (c->slots[i]) {
+        lruEntry *e = c->slots[i]->data;
+        if (e->hash == hash && memcmp(lru_key(c->slots[i]), key,
+                                      c->keySize) == 0)
+            break;
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+/**
+ * lru_grow:
+ *      Double the hash table and reinsert every node.
+ */
+static void lru_grow(lruCache *c)
+{
+    dLinkedListNode **old = c->slots;
+    size_t oldCount = c->slotCount;
+
+    c->slotCount = oldCount * 2;
+    c->slots = calloc(c->slotCount, sizeof(dLinkedListNode *));
+    if (!c->slots)
+        error_abort("Unable to allocate lruCache slots");
+
+    for (size_t i = 0; i < oldCount; i++) {
+        if (!old[i])
+            continue;
+
+        lruEntry *e = old[i]->data;
+        size_t j = e->hash & (c->slotCount - 1);
+        while (c->slots[j])
+            j = (j + 1) & (c->slotCount - 1);
+        c->slots[j] = old[i];
+    }
+
+    free(old);
+}
+
+/**
+ * lru_clearSlot:
+ *      Empty slot `i`, shifting back the nodes that probed past it.
+ */
+static void lru_clearSlot(lruCache *c, size_t i)
+{
+    size_t mask = c->slotCount - 1;
+    size_t j = i;
+
+    for (;;) {
+        j = (j + 1) & mask;
+        if (!c->slots[j])
+            break;
+
+        // Move the node back unless its home lies cyclically in (i, j]
+        size_t home = ((lruEntry *)c->slots[j]->data)->hash & mask;
+        if ((j > i && (home <= i || home > j)) ||
+            (j < i && home <= i && home > j)) {
+            c->slots[i] = c->slots[j];
+            i = j;
+        }
+    }
+
+    c->slots[i] = NULL;
+}
+
+/**
+ * lru_drop:
+ *      Remove the entry in slot `i` from the cache and free it.
+ */
+static void lru_drop(lruCache *c, size_t i)
+{
+    dLinkedListNode *node = c->slots[i];
+    dLinkedList *l = lru_segment(c, node);
+
+    lru_clearSlot(c, i);
+    lru_unlink(l, node);
+    c->bytes -= ((lruEntry *)node->data)->bytes;
+
+    // Use freeFunction if it exists
+    if (c->freeFn)
+        c->freeFn(lru_value(c, node));
+
+    nc_free(node);
+}
+
+/**
+ * lru_length:
+ *      Return the number of entries in the cache.
+ */
+size_t lru_length(lruCache *c)
+{
+    return c->probation->logicalLength +
+        (c->protectedList ? c->protectedList->logicalLength : 0);
+}
+
+/**
+ * lru_bytes:
+ *      Return the bytes charged for the entries in the cache.
+ */
+size_t lru_bytes(lruCache *c)
+{
+    return c->bytes;
+}
+
+/**
+ * lru_evict:
+ *      Evict least recently used entries, probationary ones first, until
+ *      the cache is within its bounds.
+ */
+static void lru_evict(lruCache *c)
+{
+    while ((c->maxEntries && lru_length(c) > c->maxEntries) ||
+           (c->maxBytes && c->bytes > c->maxBytes)) {
+        dLinkedListNode *victim = c->probation->tail;
+        if (!victim && c->protectedList)
+            victim = c->protectedList->tail;
+        if (!victim)
+            return;
+
+        lruEntry *e = victim->data;
+        lru_drop(c, lru_slot(c, lru_key(victim), e->hash));
+        c->evictions++;
+    }
+}
+
+/**
+ * lru_createSegmented:
+ *      Create a segmented LRU cache of `keySize` byte keys and `valueSize`
+ *      byte values holding at most `maxEntries` entries and `maxBytes`
+ *      bytes, 0 for no bound.
+ *      Returns the cache.
+ */
+lruCache *lru_createSegmented(size_t keySize, size_t valueSize,
+                              size_t maxEntries, size_t maxBytes,
+                              freeFunction fn)
+{
+    lruCache *c = lru_create(keySize, valueSize, maxEntries, maxBytes, fn);
+
+    c->protectedList = dll_create(c->probation->elementSize, NULL);
+    c->maxProtected = maxEntries ? maxEntries * LRU_PROTECTED / 100 : 0;
+
+    return c;                   // return new cache
+}
+
+/**
+ * lru_create:
+ *      Create an LRU cache of `keySize` byte keys and `valueSize` byte
+ *      values holding at most `maxEntries` entries and `maxBytes` bytes,
+ *      0 for no bound.
+ *      Returns the cache.
+ */
+lruCache *lru_create(size_t keySize, size_t valueSize, size_t maxEntries,
+                     size_t maxBytes, freeFunction fn)
+{
+    assert(keySize);
+
+    // Allocate cache
+    lruCache *c = calloc(1, sizeof(lruCache));
+    if (!c)
+        error_abort("Unable to allocate lruCache");
+
+    // Initialize cache, entries are freed by the cache not by the list
+    c->keySize = keySize;
+    c->valueSize = valueSize;
+    c->maxEntries = maxEntries;
+    c->maxBytes = maxBytes;
+    c->freeFn = fn;
+    c->probation = dll_create(LRU_VALUE_OFFSET(c) + valueSize, NULL);
+    c->protectedList = NULL;
+
+    c->slotCount = LRU_MIN_SLOTS;
+    c->slots = calloc(c->slotCount, sizeof(dLinkedListNode *));
+    c->scratch = calloc(1, c->probation->elementSize);
+    if (!c->slots || !c->scratch)
+        error_abort("Unable to allocate lruCache");
+
+    return c;                   // return new cache
+}
+
+/**
+ * lru_delete:
+ *      Free every entry and the cache.
+ */
+void lru_delete(lruCache *c)
+{
+    // Hand every value left to the freeFunction
+    dLinkedList *segments[2] = { c->probation, c->protectedList };
+    for (int s = 0; s < 2; s++) {
+        if (!segments[s])
+            continue;
+
+        if (c->freeFn)
+            for (dLinkedListNode *n = segments[s]->head; n; n = n->next)
+                c->freeFn(lru_value(c, n));
+        dll_delete(segments[s]);
+    }
+
+    free(c->slots);
+    free(c->scratch);
+    free(c);
+}
+
+/**
+ * lru_touch:
+ *      Mark an entry node as just used.  In a segmented cache a second use
+ *      promotes it to the protected segment, demoting the protected
+ *      segment's least recently used entry if it is full.
+ */
+static void lru_touch(lruCache *c, dLinkedListNode *node)
+{
+    lruEntry *e = node->data;
+
+    if (!c->protectedList || e->isProtected) {
+        dLinkedList *l = lru_segment(c, node);
+        if (l->head != node) {
+            lru_unlink(l, node);
+            lru_pushFront(l, node);
+        }
+        return;
+    }
+
+    lru_unlink(c->probation, node);
+    e->isProtected = true;
+    lru_pushFront(c->protectedList, node);
+
+    if (c->maxProtected &&
+        c->protectedList->logicalLength > c->maxProtected) {
+        dLinkedListNode *demoted = c->protectedList->tail;
+        lru_unlink(c->protectedList, demoted);
+        ((lruEntry *)demoted->data)->isProtected = false;
+        lru_pushFront(c->probation, demoted);
+    }
+}
+
+/**
+ * lru_get:
+ *      Look up `key` and mark its entry as just used.
+ *      Returns a pointer to its value, or NULL if the key is not cached.
+ */
+void *lru_get(lruCache *c, const void *key)
+{
+    size_t i = lru_slot(c, key, hash_fnv1a(key, c->keySize));
+    dLinkedListNode *node = c->slots[i];
+
+    if (!node) {
+        c->misses++;
+        return NULL;
+    }
+
+    c->hits++;
+    lru_touch(c, node);
+
+    return lru_value(c, node);
+}
+
+/**
+ * lru_peek:
+ *      Look up `key` without marking it used or counting a hit or miss.
+ *      Returns a pointer to its value, or NULL if the key is not cached.
+ */
+void *lru_peek(lruCache *c, const void *key)
+{
+    size_t i = lru_slot(c, key, hash_fnv1a(key, c->keySize));
+
+    return c->slots[i] ? lru_value(c, c->slots[i]) : NULL;
+}
+
+/**
+ * lru_put:
+ *      Cache a copy of `value` under `key`, charged `bytes` bytes,
+ *      replacing any value already cached under it, then evict least
+ *      recently used entries until the cache is within its bounds.
+ */
+void lru_put(lruCache *c, const void *key, const void *value, size_t bytes)
+{
+    uint64_t hash = hash_fnv1a(key, c->keySize);
+    size_t i = lru_slot(c, key, hash);
+    dLinkedListNode *node = c->slots[i];
+
+    // Replace the value of a cached key
+    if (node) {
+        lruEntry *e = node->data;
+
+        if (c->freeFn)
+            c->freeFn(lru_value(c, node));
+        memcpy(lru_value(c, node), value, c->valueSize);
+
+        c->bytes = c->bytes - e->bytes + bytes;
+        e->bytes = bytes;
+        lru_touch(c, node);
+        lru_evict(c);
+        return;
+    }
+
+    // Keep the table at most half full
+    if ((lru_length(c) + 1) * 2 > c->slotCount) {
+        lru_grow(c);
+        i = lru_slot(c, key, hash);
+    }
+
+    // Build the entry and push it as the most recently used
+    lruEntry *e = c->scratch;
+    e->hash = hash;
+    e->bytes = bytes;
+    e->isProtected = false;
+    memcpy((char *)c->scratch + LRU_KEY_OFFSET, key, c->keySize);
+    memcpy((char *)c->scratch + LRU_VALUE_OFFSET(c), value, c->valueSize);
+
+    dll_push(c->probation, c->scratch);
+    c->slots[i] = c->probation->head;
+    c->bytes += bytes;
+
+    lru_evict(c);
+}
+
+/**
+ * lru_remove:
+ *      Remove the entry for `key` and free its value.
+ *      Returns true if the key was cached.
+ */
+bool lru_remove(lruCache *c, const void *key)
+{
+    size_t i = lru_slot(c, key, hash_fnv1a(key, c->keySize));
+
+    if (!c->slots[i])
+        return false;
+
+    lru_drop(c, i);
+
+    return true;
+}
+
+/**
+ * lru_resetStats:
+ *      Zero the hit, miss and eviction counters.
+ */
+void lru_resetStats(lruCache *c)
+{
+    c->hits = c->misses = c->evictions = 0;
+}
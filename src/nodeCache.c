@@ -0,0 +1,496 @@
+/** nodeCache.c - List node allocator with per-thread caches.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef LTYPES_NUMA
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#include "nodeCache.h"
+#include "errors.h"
+
+#define NC_GRANULE 16           // size class granularity in bytes
+#define NC_CLASSES 32           // number of size classes, up to 512 bytes
+#define NC_MAGAZINE 128         // free blocks a thread keeps per class
+#define NC_BATCH 64             // blocks moved to/from the depot or owner
+#define NC_SLAB_SIZE (64 * 1024)// bytes carved into blocks at a time
+
+#ifndef MPOL_LOCAL
+#define MPOL_LOCAL 4            // allocate on the node of the calling thread
+#endif
+
+struct nodeCache;
+
+// Contiguous run of blocks, freed when its last block is freed
+typedef struct nodeRun {
+    atomic_size_t live;         // blocks of the run not yet freed
+} nodeRun;
+
+// Header in front of every block
+typedef struct nodeHeader {
+    struct nodeCache *owner;    // cache of the allocating thread, NULL if
+                                // the block is not cached
+    union {
+        size_t sizeClass;       // size class of cached blocks
+        nodeRun *run;           // run of an uncached block, NULL if the
+                                // block came straight from the heap
+    };
+} nodeHeader;
+
+// Link stored in the data area of a free block
+typedef struct freeBlock {
+    struct freeBlock *next;
+} freeBlock;
+
+// Per-thread node cache
+typedef struct nodeCache {
+    freeBlock *magazine[NC_CLASSES];    // free blocks per size class
+    size_t rounds[NC_CLASSES];          // number of blocks in each magazine
+    char *slab;                         // unused part of the current slab
+    char *slabEnd;                      // end of the current slab
+    _Atomic(freeBlock *) remote;        // blocks returned by other threads
+    struct nodeCache *pendingOwner;     // owner of the pending batch
+    freeBlock *pendingHead;             // blocks freed for another thread
+    freeBlock *pendingTail;
+    size_t pendingCount;
+    struct nodeCache *nextOrphan;       // link in the orphan list
+} nodeCache;
+
+// Shared depot of free blocks per size class
+static struct {
+    pthread_mutex_t lock;
+    freeBlock *blocks[NC_CLASSES];
+    atomic_size_t count[NC_CLASSES];
+    nodeCache *orphans;         // caches of exited threads, for adoption
+} depot = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local nodeCache *threadCache = NULL;
+static pthread_key_t threadCacheKey;
+static pthread_once_t threadCacheOnce = PTHREAD_ONCE_INIT;
+static atomic_bool cacheByDefault = false;
+
+/**
+ * nc_header:
+ *      Return the header of a block given its data pointer.
+ */
+static inline nodeHeader *nc_header(void *p)
+{
+    return (nodeHeader *)((char *)p - NC_ALIGN(sizeof(nodeHeader)));
+}
+
+/**
+ * nc_blockSize:
+ *      Total bytes used by a block of a size class, header included.
+ */
+static inline size_t nc_blockSize(size_t sizeClass)
+{
+    return NC_ALIGN(sizeof(nodeHeader)) + (sizeClass + 1) * NC_GRANULE;
+}
+
+/**
+ * nc_slabAlloc:
+ *      Allocate a fresh slab for the calling thread.
+ */
+static char *nc_slabAlloc(void)
+{
+#ifdef LTYPES_NUMA
+    char *slab = mmap(NULL, NC_SLAB_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab == MAP_FAILED)
+        error_abort("Unable to map node cache slab");
+
+    // Prefer the memory node of this thread, first touch does the rest
+    // when the kernel or machine does not support binding
+    syscall(SYS_mbind, slab, NC_SLAB_SIZE, MPOL_LOCAL, NULL, 0UL, 0U);
+    memset(slab, 0, NC_SLAB_SIZE);
+#else
+    char *slab = malloc(NC_SLAB_SIZE);
+    if (!slab)
+        error_abort("Unable to allocate node cache slab");
+#endif
+
+    return slab;
+}
+
+/**
+ * nc_depotPut:
+ *      Move up to `n` blocks from a magazine to the depot.
+ */
+static void nc_depotPut(nodeCache *c, size_t cls, size_t n)
+{
+    freeBlock *head = c->magazine[cls], *tail = head;
+    size_t moved = 1;
+
+    if (!head)
+        return;
+
+    // Detach a chain of n blocks
+    while (moved < n && tail->next) {
+        tail = tail->next;
+        moved++;
+    }
+    c->magazine[cls] = tail->next;
+    c->rounds[cls] -= moved;
+
+    pthread_mutex_lock(&depot.lock);
+    tail->next = depot.blocks[cls];
+    depot.blocks[cls] = head;
+    depot.count[cls] += moved;
+    pthread_mutex_unlock(&depot.lock);
+}
+
+/**
+ * nc_depotGet:
+ *      Move up to NC_BATCH blocks from the depot to a magazine.
+ *      Returns false if the depot has none.
+ */
+static bool nc_depotGet(nodeCache *c, size_t cls)
+{
+    // Unlocked peek, a stale answer only costs a slab carve
+    if (!atomic_load_explicit(&depot.count[cls], memory_order_relaxed))
+        return false;
+
+    pthread_mutex_lock(&depot.lock);
+    freeBlock *head = depot.blocks[cls], *tail = head;
+    size_t moved = head ? 1 : 0;
+
+    if (head) {
+        while (moved < NC_BATCH && tail->next) {
+            tail = tail->next;
+            moved++;
+        }
+        depot.blocks[cls] = tail->next;
+        depot.count[cls] -= moved;
+    }
+    pthread_mutex_unlock(&depot.lock);
+
+    if (!head)
+        return false;
+
+    tail->next = c->magazine[cls];
+    c->magazine[cls] = head;
+    c->rounds[cls] += moved;
+
+    return true;
+}
+
+/**
+ * nc_push:
+ *      Return a block to a magazine of the calling thread's cache.
+ */
+static inline void nc_push(nodeCache *c, size_t cls, freeBlock *b)
+{
+    b->next = c->magazine[cls];
+    c->magazine[cls] = b;
+
+    // Keep the magazine bounded, excess goes to the depot for other threads
+    if (++c->rounds[cls] > 2 * NC_MAGAZINE)
+        nc_depotPut(c, cls, NC_MAGAZINE);
+}
+
+/**
+ * nc_drainRemote:
+ *      Move blocks returned by other threads into the magazines.
+ */
+static void nc_drainRemote(nodeCache *c)
+{
+    freeBlock *b = atomic_exchange_explicit(&c->remote, NULL,
+                                            memory_order_acquire);
+
+    while (b) {
+        freeBlock *next = b->next;
+        nc_push(c, nc_header(b)->sizeClass, b);
+        b = next;
+    }
+}
+
+/**
+ * nc_flushPending:
+ *      Push the batch of blocks freed for another thread to its cache.
+ */
+static void nc_flushPending(nodeCache *c)
+{
+    if (!c->pendingCount)
+        return;
+
+    nodeCache *owner = c->pendingOwner;
+    freeBlock *head = atomic_load_explicit(&owner->remote,
+                                           memory_order_relaxed);
+
+    // Splice the whole batch onto the owner's remote stack at once
+    do {
+        c->pendingTail->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&owner->remote, &head,
+                                                    c->pendingHead,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+
+    c->pendingOwner = NULL;
+    c->pendingHead = c->pendingTail = NULL;
+    c->pendingCount = 0;
+}
+
+/**
+ * nc_threadExit:
+ *      Retire the cache of an exiting thread.  Its free blocks go to the
+ *      depot and the cache itself is kept for adoption by a later thread,
+ *      since blocks it handed out may still be returned to it.
+ */
+static void nc_threadExit(void *arg)
+{
+    nodeCache *c = arg;
+
+    nc_flushPending(c);
+    nc_drainRemote(c);
+
+    for (size_t cls = 0; cls < NC_CLASSES; cls++)
+        while (c->magazine[cls])
+            nc_depotPut(c, cls, NC_BATCH);
+
+    pthread_mutex_lock(&depot.lock);
+    c->nextOrphan = depot.orphans;
+    depot.orphans = c;
+    pthread_mutex_unlock(&depot.lock);
+
+    threadCache = NULL;
+}
+
+/**
+ * nc_makeKey:
+ *      Create the key whose destructor retires thread caches.
+ */
+static void nc_makeKey(void)
+{
+    if (pthread_key_create(&threadCacheKey, nc_threadExit) != 0)
+        error_abort("Unable to create node cache key");
+}
+
+/**
+ * nc_self:
+ *      Return the calling thread's cache, adopting an orphaned cache
+ *      or creating a new one on first use.
+ */
+static nodeCache *nc_self(void)
+{
+    nodeCache *c = threadCache;
+
+    if (c)
+        return c;
+
+    pthread_once(&threadCacheOnce, nc_makeKey);
+
+    pthread_mutex_lock(&depot.lock);
+    if ((c = depot.orphans))
+        depot.orphans = c->nextOrphan;
+    pthread_mutex_unlock(&depot.lock);
+
+    if (!c && !(c = calloc(1, sizeof(nodeCache))))
+        error_abort("Unable to allocate node cache");
+
+    c->nextOrphan = NULL;
+    threadCache = c;
+    pthread_setspecific(threadCacheKey, c);
+
+    return c;
+}
+
+/**
+ * nc_refill:
+ *      Refill an empty magazine from returned blocks, the depot or a slab.
+ */
+static void nc_refill(nodeCache *c, size_t cls)
+{
+    nc_drainRemote(c);
+    if (c->magazine[cls])
+        return;
+
+    if (nc_depotGet(c, cls))
+        return;
+
+    // Carve a batch of new blocks
+    size_t size = nc_blockSize(cls);
+    for (size_t i = 0; i < NC_BATCH; i++) {
+        if ((size_t)(c->slabEnd - c->slab) < size) {
+            c->slab = nc_slabAlloc();
+            c->slabEnd = c->slab + NC_SLAB_SIZE;
+        }
+
+        nodeHeader *h = (nodeHeader *)c->slab;
+        h->owner = c;
+        h->sizeClass = cls;
+        c->slab += size;
+
+        freeBlock *b = (freeBlock *)((char *)h + NC_ALIGN(sizeof(nodeHeader)));
+        b->next = c->magazine[cls];
+        c->magazine[cls] = b;
+        c->rounds[cls]++;
+    }
+}
+
+/**
+ * nc_alloc:
+ *      Allocate a zeroed block of `size` bytes for a list node, from the
+ *      calling thread's cache if `cached` is set.
+ *      Returns a pointer to the block's data.
+ */
+void *nc_alloc(size_t size, bool cached)
+{
+    size_t cls = size ? (size - 1) / NC_GRANULE : 0;
+
+    // Plain heap block
+    if (!cached || cls >= NC_CLASSES) {
+        nodeHeader *h = calloc(1, NC_ALIGN(sizeof(nodeHeader)) + size);
+        if (!h)
+            error_abort("unable to allocate memory for node");
+
+        h->owner = NULL;
+        h->run = NULL;
+        return (char *)h + NC_ALIGN(sizeof(nodeHeader));
+    }
+
+    nodeCache *c = nc_self();
+    if (!c->magazine[cls])
+        nc_refill(c, cls);
+
+    freeBlock *b = c->magazine[cls];
+    c->magazine[cls] = b->next;
+    c->rounds[cls]--;
+
+    // Blocks move between threads through the depot, claim it
+    nodeHeader *h = nc_header(b);
+    h->owner = c;
+    h->sizeClass = cls;
+    memset(b, 0, (cls + 1) * NC_GRANULE);
+
+    return b;
+}
+
+/**
+ * nc_allocRun:
+ *      Allocate `count` uncached blocks of `size` bytes laid out back to
+ *      back in one allocation, `*stride` is set to the distance between
+ *      their data.  The memory is released when every block has been
+ *      freed with nc_free.  The blocks are not zeroed.
+ *      Returns a pointer to the first block's data.
+ */
+void *nc_allocRun(size_t size, size_t count, size_t *stride)
+{
+    assert(count);
+
+    size_t hdr = NC_ALIGN(sizeof(nodeHeader));
+    size_t step = hdr + NC_ALIGN(size);
+    nodeRun *run = malloc(NC_ALIGN(sizeof(nodeRun)) + count * step);
+    if (!run)
+        error_abort("Unable to allocate node run");
+
+    atomic_init(&run->live, count);
+
+    // Stamp the header of every block
+    char *block = (char *)run + NC_ALIGN(sizeof(nodeRun));
+    for (size_t i = 0; i < count; i++, block += step) {
+        nodeHeader *h = (nodeHeader *)block;
+        h->owner = NULL;
+        h->run = run;
+    }
+
+    *stride = step;
+    return (char *)run + NC_ALIGN(sizeof(nodeRun)) + hdr;
+}
+
+/**
+ * nc_free:
+ *      Free a block allocated by nc_alloc.
+ */
+void nc_free(void *p)
+{
+    if (!p)
+        return;
+
+    nodeHeader *h = nc_header(p);
+
+    if (!h->owner) {
+        if (!h->run)
+            free(h);
+        else if (atomic_fetch_sub(&h->run->live, 1) == 1)
+            free(h->run);       // last block of the run
+        return;
+    }
+
+    nodeCache *c = nc_self();
+    freeBlock *b = p;
+
+    // Freed by the allocating thread
+    if (h->owner == c) {
+        nc_push(c, h->sizeClass, b);
+        return;
+    }
+
+    // Freed by another thread, batch it up for the owner
+    if (c->pendingOwner != h->owner)
+        nc_flushPending(c);
+
+    b->next = c->pendingHead;
+    c->pendingHead = b;
+    if (!c->pendingTail)
+        c->pendingTail = b;
+    c->pendingOwner = h->owner;
+
+    if (++c->pendingCount >= NC_BATCH)
+        nc_flushPending(c);
+}
+
+/**
+ * nc_flush:
+ *      Return blocks the calling thread freed for other threads right away
+ *      instead of waiting for a full batch.
+ */
+void nc_flush(void)
+{
+    if (threadCache)
+        nc_flushPending(threadCache);
+}
+
+/**
+ * nc_setDefault:
+ *      Make ll_create and dll_create use per-thread node caches.
+ */
+void nc_setDefault(bool cached)
+{
+    atomic_store(&cacheByDefault, cached);
+}
+
+/**
+ * nc_getDefault:
+ *      Return true if new lists use per-thread node caches by default.
+ */
+bool nc_getDefault(void)
+{
+    return atomic_load(&cacheByDefault);
+}
@@ -0,0 +1,425 @@
+/** persistentList.c - Persistent list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "persistentList.h"
+#include "nodeCache.h"
+#include "errors.h"
+
+#define PL_DATA_OFFSET NC_ALIGN(sizeof(persistentListNode))
+#define PL_RUN (256 * 1024)   // bytes of nodes built per run by pl_fromList
+
+/**
+ * pl_retain:
+ *      Take a reference to a node, if there is one.
+ *      Returns the node.
+ */
+static inline persistentListNode *pl_retain(persistentListNode *node)
+{
+    // A reference is only ever taken by a holder of another one
+    if (node)
+        atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+
+    return node;
+}
+
+/**
+ * pl_releaseData:
+ *      Drop a reference to the element held by `owner`, freeing the element
+ *      and its block once no node holds it.
+ */
+static void pl_releaseData(persistentList *l, persistentListNode *owner)
+{
+    if (atomic_fetch_sub_explicit(&owner->dataRefs, 1,
+                                  memory_order_acq_rel) != 1)
+        return;
+
+    // Use freeFunction if it exists
+    if (l->freeFn)
+        l->freeFn(owner->data);
+    nc_free(owner);
+}
+
+/**
+ * pl_release:
+ *      Drop a reference to a node, releasing it and then every node it
+ *      pointed to that is no longer referenced.
+ */
+static void pl_release(persistentList *l, persistentListNode *node)
+{
+    // Dropping the last reference must see writes made through others
+    while (node && atomic_fetch_sub_explicit(&node->refs, 1,
+                                             memory_order_acq_rel) == 1) {
+        persistentListNode *next = node->next;
+
+        // A copy's block holds no data, an original's outlives its copies
+        if (node->owner) {
+            pl_releaseData(l, node->owner);
+            nc_free(node);
+        } else {
+            pl_releaseData(l, node);
+        }
+
+        node = next;
+    }
+}
+
+/**
+ * pl_newNode:
+ *      Allocate a node holding a copy of `el` in front of `next`, taking
+ *      the caller's reference to `next`.
+ *      Returns the node.
+ */
+static persistentListNode *pl_newNode(persistentList *l, void *el,
+                                      persistentListNode *next)
+{
+    persistentListNode *node = nc_alloc(PL_DATA_OFFSET + l->elementSize,
+                                        l->cached);
+    if (!node)
+        error_abort("Unable to allocate persistentListNode");
+
+    node->data = (char *)node + PL_DATA_OFFSET;
+    memcpy(node->data, el, l->elementSize);
+    node->next = next;
+    node->owner = NULL;
+    atomic_init(&node->refs, 1);
+    atomic_init(&node->dataRefs, 1);
+
+    return node;                // return new node
+}
+
+/**
+ * pl_copyNode:
+ *      Allocate a node sharing the element of `node`.
+ *      Returns the copy, its next pointer is left for the caller to set.
+ */
+static persistentListNode *pl_copyNode(persistentList *l,
+                                       persistentListNode *node)
+{
+    persistentListNode *copy = nc_alloc(sizeof(persistentListNode),
+                                        l->cached);
+    if (!copy)
+        error_abort("Unable to allocate persistentListNode");
+
+    // Share the data of the node holding it, never of another copy
+    copy->owner = node->owner ? node->owner : node;
+    atomic_fetch_add_explicit(&copy->owner->dataRefs, 1,
+                              memory_order_relaxed);
+    copy->data = node->data;
+    copy->next = NULL;
+    atomic_init(&copy->refs, 1);
+    atomic_init(&copy->dataRefs, 0);
+
+    return copy;
+}
+
+/**
+ * pl_version:
+ *      Create a version of a list with `head`, taking the caller's
+ *      reference to it.
+ *      Returns the version.
+ */
+static persistentList *pl_version(persistentList *l,
+                                  persistentListNode *head, size_t length)
+{
+    persistentList *v = malloc(sizeof(persistentList));
+    if (!v)
+        error_abort("Unable to allocate persistentList");
+
+    v->logicalLength = length;
+    v->elementSize = l->elementSize;
+    v->head = head;
+    v->freeFn = l->freeFn;
+    v->cached = l->cached;
+
+    return v;                   // return new version
+}
+
+/**
+ * pl_rebuild:
+ *      Create a version of a list whose first `count` nodes are copied and
+ *      followed by `rest`, taking the caller's reference to `rest`.
+ *      Returns the version.
+ */
+static persistentList *pl_rebuild(persistentList *l, size_t count,
+                                  persistentListNode *rest, size_t length)
+{
+    persistentListNode *head = rest, **link = &head;
+    persistentListNode *node = l->head;
+
+    // Copy the nodes in front of the change, in order
+    for (size_t i = 0; i < count; i++) {
+        persistentListNode *copy = pl_copyNode(l, node);
+        *link = copy;
+        link = &copy->next;
+        node = node->next;
+    }
+    *link = rest;
+
+    return pl_version(l, head, length);
+}
+
+/**
+ * pl_create:
+ *      Create a new empty persistent list.
+ *      Returns the new list.
+ */
+persistentList *pl_create(size_t elementSize, freeFunction fn)
+{
+    // Assert that the element size is at least 1 byte
+    assert(elementSize > 0);
+
+    persistentList l = {
+        .elementSize = elementSize,
+        .freeFn = fn,
+        .cached = nc_getDefault()
+    };
+
+    return pl_version(&l, NULL, 0);
+}
+
+/**
+ * pl_delete:
+ *      Delete a version of a list, freeing the nodes no other version
+ *      shares.
+ */
+void pl_delete(persistentList *l)
+{
+    pl_release(l, l->head);
+    free(l);
+}
+
+/**
+ * pl_fromList:
+ *      Build a persistent list holding the elements of a linkedList, in
+ *      one pass into nodes carved from runs of blocks.  Elements are
+ *      copied with `copy` and then owned by the new list, or without a
+ *      copyFunction copied byte by byte and left owned by the linkedList,
+ *      in which case the new list has no freeFunction.
+ *      Returns the new list.
+ */
+persistentList *pl_fromList(linkedList *l, copyFunction copy)
+{
+    persistentList *p = pl_create(l->elementSize, copy ? l->freeFn : NULL);
+    persistentListNode **link = &p->head;
+    size_t size = PL_DATA_OFFSET + l->elementSize;
+    size_t runNodes = PL_RUN / size ? PL_RUN / size : 1;
+    size_t left = l->logicalLength, stride = 0, avail = 0;
+    char *block = NULL;
+
+    for (linkedListNode *old = l->head; old; old = old->next, left--) {
+        // Start a new run sized for the nodes left
+        if (!avail) {
+            avail = left < runNodes ? left : runNodes;
+            block = nc_allocRun(size, avail, &stride);
+        }
+
+        persistentListNode *node = (persistentListNode *)block;
+        node->data = block + PL_DATA_OFFSET;
+        if (copy)
+            copy(node->data, old->data);
+        else
+            memcpy(node->data, old->data, l->elementSize);
+
+        node->next = NULL;
+        node->owner = NULL;
+        atomic_init(&node->refs, 1);
+        atomic_init(&node->dataRefs, 1);
+        *link = node;
+        link = &node->next;
+
+        block += stride;
+        avail--;
+    }
+
+    p->logicalLength = l->logicalLength;
+
+    return p;                   // return new list
+}
+
+/**
+ * pl_snapshot:
+ *      Take a snapshot of a list in O(1).
+ *      Returns a new version sharing every node.
+ */
+persistentList *pl_snapshot(persistentList *l)
+{
+    return pl_version(l, pl_retain(l->head), l->logicalLength);
+}
+
+/**
+ * pl_push:
+ *      Returns a new version of a list with a copy of `el` at the head.
+ */
+persistentList *pl_push(persistentList *l, void *el)
+{
+    persistentListNode *node = pl_newNode(l, el, pl_retain(l->head));
+
+    return pl_version(l, node, l->logicalLength + 1);
+}
+
+/**
+ * pl_pop:
+ *      Copy the element at the head of a list to `el`, unless it is NULL.
+ *      The copy shares any memory the element points to with the list.
+ *      Returns a new version of the list without its head.
+ */
+persistentList *pl_pop(persistentList *l, void *el)
+{
+    // Assert that the list is not empty
+    assert(l->head);
+
+    if (el)
+        memcpy(el, l->head->data, l->elementSize);
+
+    return pl_version(l, pl_retain(l->head->next), l->logicalLength - 1);
+}
+
+/**
+ * pl_set:
+ *      Returns a new version of a list with a copy of `el` at `index`,
+ *      copying the nodes before it and sharing those after it.
+ */
+persistentList *pl_set(persistentList *l, size_t index, void *el)
+{
+    // Assert that the index is in the list
+    assert(index > 0 && index <= l->logicalLength);
+
+    persistentListNode *old = pl_getNodeAt(l, index);
+    persistentListNode *node = pl_newNode(l, el, pl_retain(old->next));
+
+    return pl_rebuild(l, index - 1, node, l->logicalLength);
+}
+
+/**
+ * pl_deleteNode:
+ *      Returns a new version of a list without its first node matching
+ *      `data`, copying the nodes before it and sharing those after it.
+ *      A list without a matching node is returned as a snapshot.
+ */
+persistentList *pl_deleteNode(persistentList *l, void *data,
+                              nodeComparator cmp)
+{
+    assert(cmp);
+
+    persistentListNode *curr = l->head;
+    size_t i = 0;
+
+    // Traverse the list looking for a node matching `data`
+    while (curr && cmp(curr->data, data) != EQUAL) {
+        curr = curr->next;
+        i++;
+    }
+
+    if (!curr)
+        return pl_snapshot(l);
+
+    return pl_rebuild(l, i, pl_retain(curr->next), l->logicalLength - 1);
+}
+
+/**
+ * pl_first:
+ *      Return a pointer to the head node of the list.
+ */
+persistentListNode *pl_first(persistentList *l)
+{
+    return l->head;
+}
+
+/**
+ * pl_getNodeAt:
+ *      Return a pointer to the node at `index`, counting from 1, or NULL
+ *      if the list is shorter.
+ */
+persistentListNode *pl_getNodeAt(persistentList *l, size_t index)
+{
+    // Return NULL if index given exceeds the list's length
+    if (index == 0 || index > l->logicalLength)
+        return NULL;
+
+    persistentListNode *curr = l->head;
+
+    // Iterate over list looking for node at index
+    for (size_t i = 1; i < index; i++)
+        curr = curr->next;
+
+    return curr;
+}
+
+/**
+ * pl_search:
+ *      Search a list for a node matching `data`.
+ *      Returns true if one is found.
+ */
+bool pl_search(persistentList *l, void *data, nodeComparator cmp)
+{
+    assert(cmp);
+
+    // Traverse the list looking for a node matching `data`
+    for (persistentListNode *curr = l->head; curr; curr = curr->next)
+        if (cmp(curr->data, data) == EQUAL)
+            return true;
+
+    return false;
+}
+
+/**
+ * pl_foreach:
+ *      Iterate over a persistent list and perform the tasks
+ *      in the listIterator function on each node.
+ */
+void pl_foreach(persistentList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    persistentListNode *node = l->head;
+    bool result = true;
+
+    // Iterate over the list
+    while (node && result) {
+        result = it(node->data, display);
+        node = node->next;
+    }
+}
+
+/**
+ * pl_length:
+ *      Return the number of nodes in a list.
+ */
+size_t pl_length(persistentList *l)
+{
+    return l->logicalLength;
+}
+
+/**
+ * pl_isEmpty:
+ *      Return true if a list has no nodes.
+ */
+bool pl_isEmpty(persistentList *l)
+{
+    return l->head == NULL;
+}
@@ -0,0 +1,605 @@
+/** rcuList.c - Read-copy-update linked list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include <sched.h>
+#include "rcu.h"
+#include "errors.h"
+
+/**
+ * rcu_createDomain:
+ *      Create and initialize a quiescent state domain with no readers.
+ *      Returns the domain.
+ */
+rcuDomain *rcu_createDomain(void)
+{
+    rcuDomain *d = calloc(1, sizeof(rcuDomain));
+    if (!d)
+        error_abort("Unable to allocate rcuDomain");
+
+    // Grace period 0 is reserved to mark offline readers
+    atomic_init(&d->gp, 1);
+    d->readers = NULL;
+    pthread_mutex_init(&d->lock, NULL);
+
+    return d;                   // return new domain
+}
+
+/**
+ * rcu_deleteDomain:
+ *      Free a domain.  All readers must have been unregistered.
+ */
+void rcu_deleteDomain(rcuDomain *d)
+{
+    assert(!d->readers);
+
+    pthread_mutex_destroy(&d->lock);
+    free(d);
+}
+
+/**
+ * rcu_registerReader:
+ *      Register the calling thread as an online reader of a domain.
+ *      Returns the reader state to pass to rcu_quiescent.
+ */
+rcuReader *rcu_registerReader(rcuDomain *d)
+{
+    rcuReader *r = calloc(1, sizeof(rcuReader));
+    if (!r)
+        error_abort("Unable to allocate rcuReader");
+
+    r->domain = d;
+    atomic_init(&r->ctr, 0);
+
+    pthread_mutex_lock(&d->lock);
+    r->next = d->readers;
+    d->readers = r;
+    pthread_mutex_unlock(&d->lock);
+
+    rcu_online(r);
+
+    return r;
+}
+
+/**
+ * rcu_unregisterReader:
+ *      Remove a reader from its domain and free it.
+ */
+void rcu_unregisterReader(rcuReader *r)
+{
+    rcuDomain *d = r->domain;
+    rcuReader **pp;
+
+    rcu_offline(r);
+
+    pthread_mutex_lock(&d->lock);
+    for (pp = &d->readers; *pp; pp = &(*pp)->next) {
+        if (*pp == r) {
+            *pp = r->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    free(r);
+}
+
+/**
+ * rcu_quiescent:
+ *      Announce that the calling reader holds no pointers to RCU
+ *      protected nodes.
+ */
+void rcu_quiescent(rcuReader *r)
+{
+    unsigned long gp = atomic_load_explicit(&r->domain->gp,
+                                            memory_order_acquire);
+
+    // Release orders every read of list nodes before the announcement
+    atomic_store_explicit(&r->ctr, gp, memory_order_release);
+}
+
+/**
+ * rcu_offline:
+ *      Take a reader offline, e.g. before blocking, so it no longer
+ *      holds back grace periods.
+ */
+void rcu_offline(rcuReader *r)
+{
+    atomic_store_explicit(&r->ctr, 0, memory_order_release);
+}
+
+/**
+ * rcu_online:
+ *      Bring an offline reader back online before it reads any list.
+ */
+void rcu_online(rcuReader *r)
+{
+    unsigned long gp = atomic_load_explicit(&r->domain->gp,
+                                            memory_order_acquire);
+    atomic_store_explicit(&r->ctr, gp, memory_order_relaxed);
+
+    // Pairs with the fence in rcu_retireEpoch, either the writer sees this
+    // reader online or the reader sees the writer's unlink
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * rcu_retireEpoch:
+ *      Start a new grace period, called by writers after unlinking nodes.
+ *      Returns the epoch the unlinked nodes must wait for.
+ */
+unsigned long rcu_retireEpoch(rcuDomain *d)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+
+    return atomic_fetch_add(&d->gp, 1) + 1;
+}
+
+/**
+ * rcu_minEpoch:
+ *      Return the oldest grace period observed by any online reader,
+ *      ULONG_MAX if there are no online readers.
+ */
+static unsigned long rcu_minEpoch(rcuDomain *d)
+{
+    unsigned long min = ULONG_MAX;
+
+    pthread_mutex_lock(&d->lock);
+    for (rcuReader *r = d->readers; r; r = r->next) {
+        unsigned long ctr = atomic_load_explicit(&r->ctr,
+                                                 memory_order_acquire);
+        if (ctr != 0 && ctr < min)
+            min = ctr;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    return min;
+}
+
+/**
+ * rcu_epochElapsed:
+ *      Return true if every online reader has passed through a quiescent
+ *      state since `epoch` started.
+ */
+bool rcu_epochElapsed(rcuDomain *d, unsigned long epoch)
+{
+    return rcu_minEpoch(d) >= epoch;
+}
+
+/**
+ * rcu_synchronize:
+ *      Wait for a full grace period.  Must not be called by an online
+ *      reader of the same domain, it would wait for itself.
+ */
+void rcu_synchronize(rcuDomain *d)
+{
+    unsigned long epoch = rcu_retireEpoch(d);
+
+    while (!rcu_epochElapsed(d, epoch))
+        sched_yield();
+}
+
+/**
+ * rl_create:
+ *      Create and initialize an RCU list whose readers belong to `domain`.
+ *      Returns the list.
+ */
+rcuList *rl_create(size_t size, freeFunction fn, rcuDomain *domain)
+{
+    assert(domain);
+
+    // Allocate list
+    rcuList *l = calloc(1, sizeof(rcuList));
+    if (!l)
+        error_abort("Unable to allocate rcuList");
+
+    // Initialize list
+    atomic_init(&l->logicalLength, 0);
+    l->elementSize = size;
+    atomic_init(&l->head, NULL);
+    l->tail = NULL;
+    l->freeFn = fn;
+    l->domain = domain;
+    pthread_mutex_init(&l->writeLock, NULL);
+    l->retired = l->retiredTail = NULL;
+    l->retiredCount = 0;
+
+    return l;                   // return new list
+}
+
+/**
+ * rl_freeNode:
+ *      Free a node and its data.
+ */
+static void rl_freeNode(rcuList *l, rcuListNode *node)
+{
+    if (l->freeFn)
+        l->freeFn(node->data);
+
+    free(node->data);
+    free(node);
+}
+
+/**
+ * rl_delete:
+ *      Free every node of a list, including nodes awaiting reclaim,
+ *      and the list itself.  No reader may access the list any more.
+ */
+void rl_delete(rcuList *l)
+{
+    rcuListNode *curr = atomic_load_explicit(&l->head, memory_order_relaxed);
+    rcuListNode *next;
+
+    // Free live nodes
+    while (curr) {
+        next = atomic_load_explicit(&curr->next, memory_order_relaxed);
+        rl_freeNode(l, curr);
+        curr = next;
+    }
+
+    // Free nodes still waiting for a grace period
+    while ((curr = l->retired)) {
+        l->retired = curr->prev;
+        rl_freeNode(l, curr);
+    }
+
+    pthread_mutex_destroy(&l->writeLock);
+    free(l);
+}
+
+/**
+ * rl_newNode:
+ *      Allocate a node holding a copy of `el`, not yet linked.
+ */
+static rcuListNode *rl_newNode(rcuList *l, void *el)
+{
+    // Allocate memory for a new list node
+    rcuListNode *node = calloc(1, sizeof(rcuListNode));
+    if (!node)
+        error_abort("unable to allocate memory for node");
+
+    // Allocate memory for node's new data
+    if ((node->data = calloc(1, l->elementSize)) == NULL)
+        error_abort("unable to allocate memory for node");
+
+    // Copy new data to node, it must be complete before publication
+    memcpy(node->data, el, l->elementSize);
+    atomic_init(&node->next, NULL);
+    node->prev = NULL;
+
+    return node;
+}
+
+/**
+ * rl_retire:
+ *      Queue an unlinked node for reclaim after a grace period.
+ *      Write lock must be held.
+ */
+static void rl_retire(rcuList *l, rcuListNode *node)
+{
+    // The node's next link is left intact for readers still standing on it
+    node->retireEpoch = rcu_retireEpoch(l->domain);
+    node->prev = NULL;
+
+    if (l->retiredTail)
+        l->retiredTail->prev = node;
+    else
+        l->retired = node;
+
+    l->retiredTail = node;
+    l->retiredCount++;
+}
+
+/**
+ * rl_reclaimLocked:
+ *      Free retired nodes whose grace period has elapsed.
+ *      Write lock must be held.  Returns the number of nodes freed.
+ */
+static size_t rl_reclaimLocked(rcuList *l)
+{
+    if (!l->retired)
+        return 0;
+
+    unsigned long min = rcu_minEpoch(l->domain);
+    size_t freed = 0;
+    rcuListNode *node;
+
+    // Retire epochs increase along the queue
+    while ((node = l->retired) && node->retireEpoch <= min) {
+        l->retired = node->prev;
+        rl_freeNode(l, node);
+        l->retiredCount--;
+        freed++;
+    }
+
+    if (!l->retired)
+        l->retiredTail = NULL;
+
+    return freed;
+}
+
+/**
+ * rl_reclaim:
+ *      Free retired nodes whose grace period has elapsed without waiting.
+ *      Returns the number of nodes freed.
+ */
+size_t rl_reclaim(rcuList *l)
+{
+    pthread_mutex_lock(&l->writeLock);
+    size_t freed = rl_reclaimLocked(l);
+    pthread_mutex_unlock(&l->writeLock);
+
+    return freed;
+}
+
+/**
+ * rl_barrier:
+ *      Wait for a grace period and free every retired node.
+ *      Must not be called by an online reader.
+ */
+void rl_barrier(rcuList *l)
+{
+    rcu_synchronize(l->domain);
+    rl_reclaim(l);
+}
+
+/**
+ * rl_push:
+ *      Publish a new node at the front of a list.
+ */
+void rl_push(rcuList *l, void *el)
+{
+    rcuListNode *node = rl_newNode(l, el);
+    rcuListNode *head;
+
+    pthread_mutex_lock(&l->writeLock);
+    head = atomic_load_explicit(&l->head, memory_order_relaxed);
+    atomic_store_explicit(&node->next, head, memory_order_relaxed);
+
+    if (head)
+        head->prev = node;
+    else
+        l->tail = node;
+
+    // Publish
+    atomic_store_explicit(&l->head, node, memory_order_release);
+    atomic_fetch_add_explicit(&l->logicalLength, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&l->writeLock);
+}
+
+/**
+ * rl_append:
+ *      Publish a new node at the end of a list.
+ */
+void rl_append(rcuList *l, void *el)
+{
+    rcuListNode *node = rl_newNode(l, el);
+
+    pthread_mutex_lock(&l->writeLock);
+    node->prev = l->tail;
+
+    // Publish
+    if (l->tail)
+        atomic_store_explicit(&l->tail->next, node, memory_order_release);
+    else
+        atomic_store_explicit(&l->head, node, memory_order_release);
+
+    l->tail = node;
+    atomic_fetch_add_explicit(&l->logicalLength, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&l->writeLock);
+}
+
+/**
+ * rl_findLocked:
+ *      Find the node matching `data`.  Write lock must be held.
+ */
+static rcuListNode *rl_findLocked(rcuList *l, void *data, nodeComparator cmp)
+{
+    rcuListNode *curr = atomic_load_explicit(&l->head, memory_order_relaxed);
+
+    while (curr) {
+        if (cmp(curr->data, data) == EQUAL)
+            return curr;
+
+        curr = atomic_load_explicit(&curr->next, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+/**
+ * rl_deleteNode:
+ *      Unlink the node containing value `data` and retire it.
+ *      Returns true if a node was found.
+ */
+bool rl_deleteNode(rcuList *l, void *data, nodeComparator cmp)
+{
+    // Assert that a node compare function was provided
+    assert(cmp);
+
+    pthread_mutex_lock(&l->writeLock);
+
+    rcuListNode *entry = rl_findLocked(l, data, cmp);
+    if (!entry) {
+        pthread_mutex_unlock(&l->writeLock);
+        return false;
+    }
+
+    rcuListNode *next = atomic_load_explicit(&entry->next,
+                                             memory_order_relaxed);
+
+    // Unlink, readers either see the old or the new link
+    if (entry->prev)
+        atomic_store_explicit(&entry->prev->next, next, memory_order_release);
+    else
+        atomic_store_explicit(&l->head, next, memory_order_release);
+
+    if (next)
+        next->prev = entry->prev;
+    else
+        l->tail = entry->prev;
+
+    atomic_fetch_sub_explicit(&l->logicalLength, 1, memory_order_relaxed);
+    rl_retire(l, entry);
+    rl_reclaimLocked(l);
+    pthread_mutex_unlock(&l->writeLock);
+
+    return true;
+}
+
+/**
+ * rl_replace:
+ *      Replace the node containing value `old` with a new node holding
+ *      a copy of `el` and retire the old node.
+ *      Returns true if a node was found.
+ */
+bool rl_replace(rcuList *l, void *old, void *el, nodeComparator cmp)
+{
+    assert(cmp);
+
+    rcuListNode *node = rl_newNode(l, el);
+
+    pthread_mutex_lock(&l->writeLock);
+
+    rcuListNode *entry = rl_findLocked(l, old, cmp);
+    if (!entry) {
+        pthread_mutex_unlock(&l->writeLock);
+        free(node->data);
+        free(node);
+        return false;
+    }
+
+    rcuListNode *next = atomic_load_explicit(&entry->next,
+                                             memory_order_relaxed);
+
+    // Link the copy in place of the old node
+    atomic_store_explicit(&node->next, next, memory_order_relaxed);
+    node->prev = entry->prev;
+
+    if (entry->prev)
+        atomic_store_explicit(&entry->prev->next, node, memory_order_release);
+    else
+        atomic_store_explicit(&l->head, node, memory_order_release);
+
+    if (next)
+        next->prev = node;
+    else
+        l->tail = node;
+
+    rl_retire(l, entry);
+    rl_reclaimLocked(l);
+    pthread_mutex_unlock(&l->writeLock);
+
+    return true;
+}
+
+/**
+ * rl_first:
+ *      Return a pointer to the first node of a list.  Reader side.
+ */
+rcuListNode *rl_first(rcuList *l)
+{
+    return atomic_load_explicit(&l->head, memory_order_acquire);
+}
+
+/**
+ * rl_next:
+ *      Return a pointer to the node following `node`.  Reader side.
+ */
+rcuListNode *rl_next(rcuListNode *node)
+{
+    return atomic_load_explicit(&node->next, memory_order_acquire);
+}
+
+/**
+ * rl_find:
+ *      Search a list for a node containing `data`.  Reader side.
+ *      Returns a pointer to the node's data, or NULL if not found.
+ */
+const void *rl_find(rcuList *l, void *data, nodeComparator cmp)
+{
+    assert(cmp);
+
+    rcuListNode *curr = atomic_load_explicit(&l->head, memory_order_acquire);
+
+    // Traverse the list looking for a node matching `data`
+    while (curr) {
+        if (cmp(curr->data, data) == EQUAL)
+            return curr->data;
+
+        curr = atomic_load_explicit(&curr->next, memory_order_acquire);
+    }
+
+    return NULL;
+}
+
+/**
+ * rl_search:
+ *      Search a list for a node containing `data`.  Reader side.
+ */
+bool rl_search(rcuList *l, void *data, nodeComparator cmp)
+{
+    return rl_find(l, data, cmp) != NULL;
+}
+
+/**
+ * rl_foreach:
+ *      Iterate over a list and perform the tasks in the listIterator
+ *      function on each node.  Reader side.
+ */
+void rl_foreach(rcuList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    rcuListNode *node = atomic_load_explicit(&l->head, memory_order_acquire);
+    bool result = true;
+
+    // Iterate over the list
+    while (node && result) {
+        result = it(node->data, display);
+        node = atomic_load_explicit(&node->next, memory_order_acquire);
+    }
+}
+
+/**
+ * rl_isEmpty:
+ *      Return true if the list is empty, return false otherwise.
+ */
+bool rl_isEmpty(rcuList *l)
+{
+    return rl_first(l) == NULL;
+}
+
+/**
+ * rl_length:
+ *      Return the number of nodes in a list.
+ */
+size_t rl_length(rcuList *l)
+{
+    return atomic_load_explicit(&l->logicalLength, memory_order_relaxed);
+}
@@ -0,0 +1,331 @@
+/** reclaimer.c - Background reclamation of deleted lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include "lists.h"
+#include "nodeCache.h"
+#include "errors.h"
+
+#define RECLAIM_CHUNK 4096      // nodes freed before the rest is requeued
+#define RECLAIM_MAX_THREADS 64  // upper bound on reclaimer threads
+#define RECLAIM_DEFAULT_LIMIT ((size_t)256 * 1024 * 1024)
+
+// A detached chain of nodes waiting to be freed
+typedef struct reclaimJob {
+    void *head;                 // first node of the chain
+    size_t nextOffset;          // offset of the next link within a node
+    size_t length;              // number of nodes in the chain
+    size_t nodeBytes;           // approximate bytes per node and element
+    freeFunction freeFn;        // optional function used to free elements
+} reclaimJob;
+
+// Reclaimer state
+static struct {
+    pthread_mutex_t lock;       // guards everything below
+    pthread_cond_t work;        // signalled when jobs are queued
+    pthread_cond_t idle;        // signalled when all jobs are done
+    linkedList *jobs;           // queued reclaimJobs
+    size_t busy;                // jobs being freed right now
+    size_t pendingBytes;        // bytes queued or being freed
+    size_t limit;               // bound on pendingBytes, 0 for none
+    size_t target;              // number of reclaimer threads wanted
+    size_t running;             // number of reclaimer threads started
+    bool stop;                  // set by reclaim_shutdown
+    pthread_t threads[RECLAIM_MAX_THREADS];
+} reclaimer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+    .limit = RECLAIM_DEFAULT_LIMIT,
+    .target = 1,
+};
+
+/**
+ * reclaim_next:
+ *      Return the node following `node` in a chain.
+ */
+static inline void *reclaim_next(reclaimJob *job, void *node)
+{
+    return *(void **)((char *)node + job->nextOffset);
+}
+
+/**
+ * reclaim_freeChain:
+ *      Free up to `n` nodes from the head of a job's chain.
+ */
+static void reclaim_freeChain(reclaimJob *job, size_t n)
+{
+    void *node = job->head;
+
+    for (size_t i = 0; i < n && node; i++) {
+        void *next = reclaim_next(job, node);
+
+        // Both node types start with their data pointer
+        if (job->freeFn)
+            job->freeFn(((linkedListNode *)node)->data);
+
+        nc_free(node);
+        node = next;
+    }
+}
+
+/**
+ * reclaim_main:
+ *      Reclaimer thread entry point.
+ */
+static void *reclaim_main(void *arg)
+{
+    reclaimJob job, rest;
+
+    pthread_mutex_lock(&reclaimer.lock);
+
+    for (;;) {
+        while (!reclaimer.stop && ll_isEmpty(reclaimer.jobs))
+            pthread_cond_wait(&reclaimer.work, &reclaimer.lock);
+
+        if (ll_isEmpty(reclaimer.jobs))
+            break;              // stopping and nothing left to do
+
+        ll_head(reclaimer.jobs, &job, true);
+        reclaimer.busy++;
+        pthread_mutex_unlock(&reclaimer.lock);
+
+        // Cut a chunk off the chain and requeue the rest for other threads
+        void *last = job.head;
+        size_t n = 1;
+        while (n < RECLAIM_CHUNK && reclaim_next(&job, last)) {
+            last = reclaim_next(&job, last);
+            n++;
+        }
+
+        if ((rest.head = reclaim_next(&job, last))) {
+            rest.nextOffset = job.nextOffset;
+            rest.length = job.length - n;
+            rest.nodeBytes = job.nodeBytes;
+            rest.freeFn = job.freeFn;
+
+            pthread_mutex_lock(&reclaimer.lock);
+            ll_push(reclaimer.jobs, &rest);
+            pthread_cond_signal(&reclaimer.work);
+            pthread_mutex_unlock(&reclaimer.lock);
+        }
+
+        reclaim_freeChain(&job, n);
+        nc_flush();             // hand cached nodes back to their owners
+
+        pthread_mutex_lock(&reclaimer.lock);
+        reclaimer.pendingBytes -= n * job.nodeBytes;
+        if (--reclaimer.busy == 0 && ll_isEmpty(reclaimer.jobs))
+            pthread_cond_broadcast(&reclaimer.idle);
+    }
+
+    pthread_mutex_unlock(&reclaimer.lock);
+
+    return arg;
+}
+
+/**
+ * reclaim_submit:
+ *      Queue a detached chain for reclamation, starting reclaimer threads
+ *      if necessary.  Returns false, and queues nothing, if the chain
+ *      would take the pending memory over the limit or the reclaimer is
+ *      shutting down.
+ */
+static bool reclaim_submit(reclaimJob *job)
+{
+    size_t bytes = job->length * job->nodeBytes;
+
+    pthread_mutex_lock(&reclaimer.lock);
+
+    // Threads that are stopping may already have drained the queue
+    if (reclaimer.stop ||
+        (reclaimer.limit && reclaimer.pendingBytes + bytes > reclaimer.limit)) {
+        pthread_mutex_unlock(&reclaimer.lock);
+        return false;
+    }
+
+    if (!reclaimer.jobs)
+        reclaimer.jobs = ll_create(sizeof(reclaimJob), NULL);
+
+    while (reclaimer.running < reclaimer.target) {
+        if (pthread_create(&reclaimer.threads[reclaimer.running], NULL,
+                           reclaim_main, NULL) != 0)
+            error_syscall("Unable to create reclaimer thread");
+        reclaimer.running++;
+    }
+
+    reclaimer.pendingBytes += bytes;
+    ll_append(reclaimer.jobs, job);
+    pthread_cond_signal(&reclaimer.work);
+    pthread_mutex_unlock(&reclaimer.lock);
+
+    return true;
+}
+
+/**
+ * ll_deleteAsync:
+ *      Detach every node from a list, free the list, and free the nodes
+ *      on a reclaimer thread.
+ */
+void ll_deleteAsync(linkedList *l)
+{
+    reclaimJob job = {
+        .head = l->head,
+        .nextOffset = offsetof(linkedListNode, next),
+        .length = l->logicalLength,
+        .nodeBytes = NC_ALIGN(sizeof(linkedListNode)) + l->elementSize,
+        .freeFn = l->freeFn,
+    };
+
+    free(l);
+
+    if (job.head && !reclaim_submit(&job))
+        reclaim_freeChain(&job, job.length);    // over the limit
+}
+
+/**
+ * dll_deleteAsync:
+ *      Detach every node from a list, free the list, and free the nodes
+ *      on a reclaimer thread.
+ */
+void dll_deleteAsync(dLinkedList *l)
+{
+    reclaimJob job = {
+        .head = l->head,
+        .nextOffset = offsetof(dLinkedListNode, next),
+        .length = l->logicalLength,
+        .nodeBytes = NC_ALIGN(sizeof(dLinkedListNode)) + l->elementSize,
+        .freeFn = l->freeFn,
+    };
+
+    free(l);
+
+    if (job.head && !reclaim_submit(&job))
+        reclaim_freeChain(&job, job.length);    // over the limit
+}
+
+/**
+ * reclaim_setThreads:
+ *      Set the number of reclaimer threads.  Extra threads are started
+ *      with the next deletion, fewer threads take effect after
+ *      reclaim_shutdown.
+ */
+void reclaim_setThreads(size_t n)
+{
+    if (n < 1)
+        n = 1;
+    if (n > RECLAIM_MAX_THREADS)
+        n = RECLAIM_MAX_THREADS;
+
+    pthread_mutex_lock(&reclaimer.lock);
+    reclaimer.target = n;
+    pthread_mutex_unlock(&reclaimer.lock);
+}
+
+/**
+ * reclaim_setLimit:
+ *      Set the bound, in bytes, on memory waiting to be reclaimed.
+ *      A limit of 0 removes the bound.
+ */
+void reclaim_setLimit(size_t bytes)
+{
+    pthread_mutex_lock(&reclaimer.lock);
+    reclaimer.limit = bytes;
+    pthread_mutex_unlock(&reclaimer.lock);
+}
+
+/**
+ * reclaim_pending:
+ *      Return the approximate number of bytes waiting to be reclaimed.
+ */
+size_t reclaim_pending(void)
+{
+    pthread_mutex_lock(&reclaimer.lock);
+    size_t bytes = reclaimer.pendingBytes;
+    pthread_mutex_unlock(&reclaimer.lock);
+
+    return bytes;
+}
+
+/**
+ * reclaim_flush:
+ *      Wait until every list queued so far has been freed.
+ */
+void reclaim_flush(void)
+{
+    pthread_mutex_lock(&reclaimer.lock);
+    while (reclaimer.busy || (reclaimer.jobs && !ll_isEmpty(reclaimer.jobs)))
+        pthread_cond_wait(&reclaimer.idle, &reclaimer.lock);
+    pthread_mutex_unlock(&reclaimer.lock);
+}
+
+/**
+ * reclaim_shutdown:
+ *      Free everything still queued and stop the reclaimer threads.
+ *      Deleting another list asynchronously starts them again.
+ */
+void reclaim_shutdown(void)
+{
+    pthread_mutex_lock(&reclaimer.lock);
+    reclaimer.stop = true;
+    pthread_cond_broadcast(&reclaimer.work);
+    size_t running = reclaimer.running;
+    pthread_mutex_unlock(&reclaimer.lock);
+
+    // Threads drain the queue before they exit
+    for (size_t i = 0; i < running; i++)
+        pthread_join(reclaimer.threads[i], NULL);
+
+    pthread_mutex_lock(&reclaimer.lock);
+    linkedList *left = reclaimer.jobs;
+    reclaimer.jobs = NULL;
+    reclaimer.running = 0;
+    reclaimer.stop = false;
+    pthread_mutex_unlock(&reclaimer.lock);
+
+    if (!left)
+        return;
+
+    // Free any chain the threads did not get to, outside the lock as a
+    // freeFunction may delete lists asynchronously itself
+    reclaimJob job;
+    while (!ll_isEmpty(left)) {
+        ll_head(left, &job, true);
+        reclaim_freeChain(&job, job.length);
+
+        pthread_mutex_lock(&reclaimer.lock);
+        reclaimer.pendingBytes -= job.length * job.nodeBytes;
+        pthread_mutex_unlock(&reclaimer.lock);
+    }
+    nc_flush();
+
+    pthread_mutex_lock(&reclaimer.lock);
+    pthread_cond_broadcast(&reclaimer.idle);
+    pthread_mutex_unlock(&reclaimer.lock);
+
+    ll_delete(left);
+}
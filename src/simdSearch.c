@@ -0,0 +1,435 @@
+/** simdSearch.c - Vectorized search kernel implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Elements counted into 32 bit vector lanes before they are summed
+#define SIMD_COUNT_BLOCK ((size_t)1 << 30)
+
+// Kernels for one instruction set, minMax needs at least one element
+typedef struct simdKernels {
+    const char *name;
+    size_t (*find)(const int32_t *, size_t, int32_t);
+    size_t (*count)(const int32_t *, size_t, int32_t);
+    size_t (*countRange)(const int32_t *, size_t, int32_t, uint32_t);
+    void (*minMax)(const int32_t *, size_t, int32_t *, int32_t *);
+} simdKernels;
+
+/**
+ * scalar_find, scalar_count, scalar_countRange, scalar_minMax:
+ *      Portable kernels, also used for the tails of the vector kernels.
+ *      countRange counts elements x with 0 <= x - lo <= span, unsigned.
+ */
+static size_t scalar_find(const int32_t *a, size_t n, int32_t key)
+{
+    for (size_t i = 0; i < n; i++)
+        if (a[i] == key)
+            return i;
+
+    return n;
+}
+
+static size_t scalar_count(const int32_t *a, size_t n, int32_t key)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++)
+        count += a[i] == key;
+
+    return count;
+}
+
+static size_t scalar_countRange(const int32_t *a, size_t n, int32_t lo,
+                                uint32_t span)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++)
+        count += (uint32_t)a[i] - (uint32_t)lo <= span;
+
+    return count;
+}
+
+static void scalar_minMax(const int32_t *a, size_t n, int32_t *min,
+                          int32_t *max)
+{
+    int32_t mn = a[0], mx = a[0];
+
+    for (size_t i = 1; i < n; i++) {
+        if (a[i] < mn)
+            mn = a[i];
+        if (a[i] > mx)
+            mx = a[i];
+    }
+
+    *min = mn;
+    *max = mx;
+}
+
+static const simdKernels scalarKernels = {
+    "scalar", scalar_find, scalar_count, scalar_countRange, scalar_minMax
+};
+
+#ifdef SIMD_X86
+
+/**
+ * sse2_find, sse2_count, sse2_countRange, sse2_minMax:
+ *      SSE2 kernels working on 4 elements per vector.
+ */
+__attribute__((target("sse2")))
+static size_t sse2_find(const int32_t *a, size_t n, int32_t key)
+{
+    __m128i k = _mm_set1_epi32(key);
+    size_t i = 0;
+
+    // Test 16 elements per iteration, locate a hit with the scalar loop
+    for (; i + 16 <= n; i += 16) {
+        const __m128i *p = (const __m128i *)(a + i);
+        __m128i e0 = _mm_cmpeq_epi32(_mm_loadu_si128(p), k);
+        __m128i e1 = _mm_cmpeq_epi32(_mm_loadu_si128(p + 1), k);
+        __m128i e2 = _mm_cmpeq_epi32(_mm_loadu_si128(p + 2), k);
+        __m128i e3 = _mm_cmpeq_epi32(_mm_loadu_si128(p + 3), k);
+        __m128i any = _mm_or_si128(_mm_or_si128(e0, e1),
+                                   _mm_or_si128(e2, e3));
+        if (_mm_movemask_epi8(any))
+            break;
+    }
+
+    return i + scalar_find(a + i, n - i, key);
+}
+
+__attribute__((target("sse2")))
+static size_t sse2_count(const int32_t *a, size_t n, int32_t key)
+{
+    __m128i k = _mm_set1_epi32(key);
+    size_t count = 0, i = 0;
+
+    while (i + 4 <= n) {
+        size_t end = n - i > SIMD_COUNT_BLOCK ? i + SIMD_COUNT_BLOCK : n;
+        __m128i acc = _mm_setzero_si128();
+
+        // Matching lanes are -1, subtracting them counts matches
+        for (; i + 4 <= end; i += 4) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(x, k));
+        }
+
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, acc);
+        count += (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return count + scalar_count(a + i, n - i, key);
+}
+
+__attribute__((target("sse2")))
+static size_t sse2_countRange(const int32_t *a, size_t n, int32_t lo,
+                              uint32_t span)
+{
+    // Unsigned compare as signed compare with the sign bits flipped
+    __m128i sign = _mm_set1_epi32(INT32_MIN);
+    __m128i low = _mm_set1_epi32(lo);
+    __m128i top = _mm_set1_epi32((int32_t)(span ^ 0x80000000u));
+    size_t count = 0, i = 0;
+
+    while (i + 4 <= n) {
+        size_t start = i;
+        size_t end = n - i > SIMD_COUNT_BLOCK ? i + SIMD_COUNT_BLOCK : n;
+        __m128i acc = _mm_setzero_si128();
+
+        // Lanes above the range are -1, count those and subtract
+        for (; i + 4 <= end; i += 4) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            __m128i d = _mm_xor_si128(_mm_sub_epi32(x, low), sign);
+            acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(d, top));
+        }
+
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, acc);
+        count += i - start;
+        count -= (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return count + scalar_countRange(a + i, n - i, lo, span);
+}
+
+__attribute__((target("sse2")))
+static void sse2_minMax(const int32_t *a, size_t n, int32_t *min,
+                        int32_t *max)
+{
+    if (n < 4) {
+        scalar_minMax(a, n, min, max);
+        return;
+    }
+
+    __m128i mn = _mm_loadu_si128((const __m128i *)a), mx = mn;
+    size_t i = 4;
+
+    // SSE2 has no 32 bit min/max, select with a compare mask
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i lt = _mm_cmpgt_epi32(mn, x);
+        __m128i gt = _mm_cmpgt_epi32(x, mx);
+        mn = _mm_or_si128(_mm_and_si128(lt, x), _mm_andnot_si128(lt, mn));
+        mx = _mm_or_si128(_mm_and_si128(gt, x), _mm_andnot_si128(gt, mx));
+    }
+
+    int32_t lanes[8], unused;
+    _mm_storeu_si128((__m128i *)lanes, mn);
+    _mm_storeu_si128((__m128i *)(lanes + 4), mx);
+
+    // Reduce the lanes and fold in the tail
+    scalar_minMax(lanes, 4, min, &unused);
+    scalar_minMax(lanes + 4, 4, &unused, max);
+    for (; i < n; i++) {
+        if (a[i] < *min)
+            *min = a[i];
+        if (a[i] > *max)
+            *max = a[i];
+    }
+}
+
+static const simdKernels sse2Kernels = {
+    "sse2", sse2_find, sse2_count, sse2_countRange, sse2_minMax
+};
+
+/**
+ * avx2_find, avx2_count, avx2_countRange, avx2_minMax:
+ *      AVX2 kernels working on 8 elements per vector.
+ */
+__attribute__((target("avx2")))
+static size_t avx2_find(const int32_t *a, size_t n, int32_t key)
+{
+    __m256i k = _mm256_set1_epi32(key);
+    size_t i = 0;
+
+    // Test 32 elements per iteration, locate a hit with the scalar loop
+    for (; i + 32 <= n; i += 32) {
+        const __m256i *p = (const __m256i *)(a + i);
+        __m256i e0 = _mm256_cmpeq_epi32(_mm256_loadu_si256(p), k);
+        __m256i e1 = _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 1), k);
+        __m256i e2 = _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 2), k);
+        __m256i e3 = _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 3), k);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1),
+                                      _mm256_or_si256(e2, e3));
+        if (!_mm256_testz_si256(any, any))
+            break;
+    }
+
+    return i + scalar_find(a + i, n - i, key);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_count(const int32_t *a, size_t n, int32_t key)
+{
+    __m256i k = _mm256_set1_epi32(key);
+    size_t count = 0, i = 0;
+
+    while (i + 8 <= n) {
+        size_t end = n - i > SIMD_COUNT_BLOCK ? i + SIMD_COUNT_BLOCK : n;
+        __m256i acc = _mm256_setzero_si256();
+
+        // Matching lanes are -1, subtracting them counts matches
+        for (; i + 8 <= end; i += 8) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            acc = _mm256_sub_epi32(acc, _mm256_cmpeq_epi32(x, k));
+        }
+
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        for (int j = 0; j < 8; j++)
+            count += lanes[j];
+    }
+
+    return count + scalar_count(a + i, n - i, key);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_countRange(const int32_t *a, size_t n, int32_t lo,
+                              uint32_t span)
+{
+    __m256i low = _mm256_set1_epi32(lo);
+    __m256i top = _mm256_set1_epi32((int32_t)span);
+    size_t count = 0, i = 0;
+
+    while (i + 8 <= n) {
+        size_t end = n - i > SIMD_COUNT_BLOCK ? i + SIMD_COUNT_BLOCK : n;
+        __m256i acc = _mm256_setzero_si256();
+
+        // x - lo <= span unsigned exactly when min(x - lo, span) == x - lo
+        for (; i + 8 <= end; i += 8) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i d = _mm256_sub_epi32(x, low);
+            __m256i in = _mm256_cmpeq_epi32(_mm256_min_epu32(d, top), d);
+            acc = _mm256_sub_epi32(acc, in);
+        }
+
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        for (int j = 0; j < 8; j++)
+            count += lanes[j];
+    }
+
+    return count + scalar_countRange(a + i, n - i, lo, span);
+}
+
+__attribute__((target("avx2")))
+static void avx2_minMax(const int32_t *a, size_t n, int32_t *min,
+                        int32_t *max)
+{
+    if (n < 8) {
+        scalar_minMax(a, n, min, max);
+        return;
+    }
+
+    __m256i mn = _mm256_loadu_si256((const __m256i *)a), mx = mn;
+    size_t i = 8;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        mn = _mm256_min_epi32(mn, x);
+        mx = _mm256_max_epi32(mx, x);
+    }
+
+    int32_t lanes[16];
+    _mm256_storeu_si256((__m256i *)lanes, mn);
+    _mm256_storeu_si256((__m256i *)(lanes + 8), mx);
+
+    // Reduce the lanes and fold in the tail
+    int32_t unused;
+    scalar_minMax(lanes, 8, min, &unused);
+    scalar_minMax(lanes + 8, 8, &unused, max);
+    for (; i < n; i++) {
+        if (a[i] < *min)
+            *min = a[i];
+        if (a[i] > *max)
+            *max = a[i];
+    }
+}
+
+static const simdKernels avx2Kernels = {
+    "avx2", avx2_find, avx2_count, avx2_countRange, avx2_minMax
+};
+
+#endif
+
+static simdKernels kernels;     // kernels picked for this processor
+static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * simd_init:
+ *      Pick the fastest kernels the processor supports, capped by the
+ *      LTYPES_SIMD environment variable.
+ */
+static void simd_init(void)
+{
+    kernels = scalarKernels;
+
+#ifdef SIMD_X86
+    const char *cap = getenv("LTYPES_SIMD");
+    bool scalarOnly = cap && strcmp(cap, "scalar") == 0;
+    bool noAvx2 = scalarOnly || (cap && strcmp(cap, "sse2") == 0);
+
+    __builtin_cpu_init();
+    if (!scalarOnly && __builtin_cpu_supports("sse2"))
+        kernels = sse2Kernels;
+    if (!noAvx2 && __builtin_cpu_supports("avx2"))
+        kernels = avx2Kernels;
+#endif
+}
+
+/**
+ * simd_kernels:
+ *      Return the kernels picked for this processor.
+ */
+static inline const simdKernels *simd_kernels(void)
+{
+    pthread_once(&kernelsOnce, simd_init);
+
+    return &kernels;
+}
+
+/**
+ * simd_findInt32:
+ *      Return the index of the first element equal to `key`, or `n` if
+ *      there is none.
+ */
+size_t simd_findInt32(const int32_t *a, size_t n, int32_t key)
+{
+    return simd_kernels()->find(a, n, key);
+}
+
+/**
+ * simd_countInt32:
+ *      Return the number of elements equal to `key`.
+ */
+size_t simd_countInt32(const int32_t *a, size_t n, int32_t key)
+{
+    return simd_kernels()->count(a, n, key);
+}
+
+/**
+ * simd_countRangeInt32:
+ *      Return the number of elements x with lo <= x <= hi.
+ */
+size_t simd_countRangeInt32(const int32_t *a, size_t n, int32_t lo,
+                            int32_t hi)
+{
+    if (lo > hi)
+        return 0;
+
+    return simd_kernels()->countRange(a, n, lo, (uint32_t)hi - (uint32_t)lo);
+}
+
+/**
+ * simd_minMaxInt32:
+ *      Find the smallest and largest elements.
+ *      Returns false, leaving min and max untouched, if `n` is 0.
+ */
+bool simd_minMaxInt32(const int32_t *a, size_t n, int32_t *min, int32_t *max)
+{
+    if (n == 0)
+        return false;
+
+    simd_kernels()->minMax(a, n, min, max);
+
+    return true;
+}
+
+/**
+ * simd_level:
+ *      Return the name of the kernels in use, "avx2", "sse2" or "scalar".
+ */
+const char *simd_level(void)
+{
+    return simd_kernels()->name;
+}
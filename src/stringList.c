@@ -0,0 +1,384 @@
+/** stringList.c - String list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "stringList.h"
+#include "lists.h"
+#include "nodeCache.h"
+#include "errors.h"
+
+/**
+ * sl_hash:
+ *      Return the hash stored in a node for a string.
+ */
+static inline uint32_t sl_hash(const char *s, size_t len)
+{
+    return (uint32_t)hash_fnv1a(s, len);
+}
+
+/**
+ * sl_matches:
+ *      Return true if a node holds the string `s` of `len` bytes with hash
+ *      `hash`, comparing bytes only when the length and hash agree.
+ */
+static inline bool sl_matches(const stringListNode *node, const char *s,
+                              size_t len, uint32_t hash)
+{
+    return node->length == len && node->hash == hash &&
+        memcmp(node->str, s, len) == 0;
+}
+
+/**
+ * sl_create:
+ *      Create and initialize a string list.
+ *      Returns the list.
+ */
+stringList *sl_create(void)
+{
+    // Allocate list
+    stringList *l = calloc(1, sizeof(stringList));
+    if (!l)
+        error_abort("Unable to allocate stringList");
+
+    // Initialize list
+    l->logicalLength = 0;
+    l->head = l->tail = NULL;
+    l->cached = nc_getDefault();
+
+    return l;                   // return new list
+}
+
+/**
+ * sl_createCached:
+ *      Create and initialize a string list whose nodes are allocated
+ *      from per-thread node caches.
+ *      Returns the list.
+ */
+stringList *sl_createCached(void)
+{
+    stringList *l = sl_create();
+    l->cached = true;
+
+    return l;                   // return new list
+}
+
+/**
+ * sl_newNode:
+ *      Allocate a node holding a copy of the string `s` of `len` bytes,
+ *      the node and its string share a single block.
+ */
+static stringListNode *sl_newNode(stringList *l, const char *s, size_t len)
+{
+    // Lengths are stored in 32 bits to keep nodes small
+    if (len > UINT32_MAX)
+        error_quit("String of %zu bytes is too long for a stringList", len);
+
+    stringListNode *node = nc_alloc(sizeof(stringListNode) + len + 1,
+                                    l->cached);
+
+    // Copy new string into node, nc_alloc zeroed the terminator
+    memcpy(node->str, s, len);
+    node->length = (uint32_t)len;
+    node->hash = sl_hash(s, len);
+    node->next = NULL;
+
+    return node;
+}
+
+/**
+ * sl_delete:
+ *      Remove each node from a list.
+ */
+void sl_delete(stringList *l)
+{
+    stringListNode *curr;
+    while (l->head) {
+        curr = l->head;
+        l->head = curr->next;
+
+        nc_free(curr);          // free node and its string
+        l->logicalLength--;     // decrease list's logical length
+    }
+
+    l->head = l->tail = NULL;   // reset list's head/tail
+    free(l);
+}
+
+/**
+ * sl_push:
+ *      Push a new node holding the string `s` of `len` bytes to the front
+ *      of a list.
+ *      Returns the new node.
+ */
+stringListNode *sl_push(stringList *l, const char *s, size_t len)
+{
+    stringListNode *node = sl_newNode(l, s, len);
+
+    node->next = l->head;
+    l->head = node;
+
+    // First node?
+    if (!l->tail)
+        l->tail = l->head;
+
+    l->logicalLength++;         // increase list's logical length
+
+    return node;
+}
+
+/**
+ * sl_append:
+ *      Append a new node holding the string `s` of `len` bytes to the end
+ *      of a list.
+ *      Returns the new node.
+ */
+stringListNode *sl_append(stringList *l, const char *s, size_t len)
+{
+    stringListNode *node = sl_newNode(l, s, len);
+
+    // Check if list is empty
+    if (l->logicalLength == 0) {
+        l->head = l->tail = node;
+    } else {
+        l->tail->next = node;
+        l->tail = node;
+    }
+
+    l->logicalLength++;         // increase list's logical length
+
+    return node;
+}
+
+/**
+ * sl_insertAfter:
+ *      Insert a new node holding the string `s` of `len` bytes after `prev`.
+ *      Returns the new node.
+ */
+stringListNode *sl_insertAfter(stringList *l, stringListNode *prev,
+                               const char *s, size_t len)
+{
+    // Assert prev node exists
+    assert(prev);
+
+    stringListNode *node = sl_newNode(l, s, len);
+
+    node->next = prev->next;
+    prev->next = node;
+
+    // Inserted after the tail?
+    if (l->tail == prev)
+        l->tail = node;
+
+    l->logicalLength++;         // increase list's logical length
+
+    return node;
+}
+
+/**
+ * sl_deleteNode:
+ *      Remove the first node holding the string `s` of `len` bytes.
+ *      Returns true if a node was removed.
+ */
+bool sl_deleteNode(stringList *l, const char *s, size_t len)
+{
+    uint32_t hash = sl_hash(s, len);
+    stringListNode **pp = &l->head, *prev = NULL;
+
+    // Find the link pointing at the matching node
+    while (*pp) {
+        stringListNode *entry = *pp;
+
+        if (sl_matches(entry, s, len, hash)) {
+            *pp = entry->next;
+            if (l->tail == entry)
+                l->tail = prev;
+
+            nc_free(entry);
+            l->logicalLength--; // decrease list's logical length
+            return true;
+        }
+
+        prev = entry;
+        pp = &entry->next;
+    }
+
+    return false;
+}
+
+/**
+ * sl_find:
+ *      Return the first node holding the string `s` of `len` bytes, or
+ *      NULL if there is none.
+ */
+stringListNode *sl_find(stringList *l, const char *s, size_t len)
+{
+    uint32_t hash = sl_hash(s, len);
+
+    // Traverse the list looking for a node matching the string
+    for (stringListNode *curr = l->head; curr; curr = curr->next)
+        if (sl_matches(curr, s, len, hash))
+            return curr;
+
+    return NULL;
+}
+
+/**
+ * sl_search:
+ *      Search a list for a node holding the string `s` of `len` bytes.
+ */
+bool sl_search(stringList *l, const char *s, size_t len)
+{
+    return sl_find(l, s, len) != NULL;
+}
+
+/**
+ * sl_equals:
+ *      Return true if two nodes hold equal strings.
+ */
+bool sl_equals(const stringListNode *a, const stringListNode *b)
+{
+    return sl_matches(a, b->str, b->length, b->hash);
+}
+
+/**
+ * sl_compare:
+ *      Compare the strings of two nodes byte by byte, a string that is a
+ *      prefix of the other is less.
+ *      Result is LESS for a < b, EQUAL for a == b, GREATER for a > b
+ */
+result sl_compare(const stringListNode *a, const stringListNode *b)
+{
+    size_t len = a->length < b->length ? a->length : b->length;
+    int c = memcmp(a->str, b->str, len);
+
+    if (c == 0)
+        c = (a->length > b->length) - (a->length < b->length);
+
+    return (c > 0) - (c < 0);
+}
+
+/**
+ * sl_foreach:
+ *      Iterate over a string list and perform the tasks in the listIterator
+ *      function on each string.
+ */
+void sl_foreach(stringList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    stringListNode *node = l->head;
+    bool result = true;
+
+    // Iterate over the list
+    while (node && result) {
+        result = it(node->str, display);
+        node = node->next;
+    }
+}
+
+/**
+ * sl_removeHead:
+ *      Remove the head node of a string list.
+ *      Returns false if the list was empty.
+ */
+bool sl_removeHead(stringList *l)
+{
+    stringListNode *node = l->head;
+
+    if (!node)
+        return false;
+
+    l->head = node->next;
+    if (!l->head)
+        l->tail = NULL;
+
+    nc_free(node);
+    l->logicalLength--;         // decrease list's logical length
+
+    return true;
+}
+
+/**
+ * sl_first:
+ *      Return a pointer to the first node of a string list.
+ */
+stringListNode *sl_first(stringList *l)
+{
+    return l->head;
+}
+
+/**
+ * sl_last:
+ *      Return a pointer to the tail node of a string list.
+ */
+stringListNode *sl_last(stringList *l)
+{
+    return l->tail;
+}
+
+/**
+ * sl_isEmpty:
+ *      Return true if the string list is empty, return false otherwise.
+ */
+bool sl_isEmpty(stringList *l)
+{
+    return l->logicalLength == 0;
+}
+
+/**
+ * sl_length:
+ *      Return the number of nodes in a string list.
+ */
+size_t sl_length(stringList *l)
+{
+    return l->logicalLength;
+}
+
+/**
+ * sl_reverse:
+ *      Reverse the node order of a string list.
+ */
+void sl_reverse(stringList *l)
+{
+    stringListNode *next = NULL;
+    stringListNode *prev = NULL;
+    stringListNode *curr = l->head;
+
+    // Old head becomes the new tail
+    l->tail = l->head;
+
+    // Swap nodes
+    while (curr) {
+        next = curr->next;
+        curr->next = prev;
+        prev = curr;
+        curr = next;
+    }
+
+    // Reset list head
+    l->head = prev;
+}
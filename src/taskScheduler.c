@@ -0,0 +1,617 @@
+/** taskScheduler.c - Work-stealing task scheduler implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sched.h>
+#include <unistd.h>
+#include "tasks.h"
+#include "errors.h"
+
+#define TD_INITIAL_CAPACITY 64  // initial slots in a task deque
+#define TS_SPINS 64             // failed work scans before a worker parks
+
+// Worker running on the calling thread, NULL outside of a scheduler
+static _Thread_local taskWorker *currentWorker = NULL;
+
+/**
+ * td_arrayCreate:
+ *      Allocate a circular task array with `capacity` slots.
+ */
+static taskDequeArray *td_arrayCreate(int64_t capacity)
+{
+    taskDequeArray *a = calloc(1, sizeof(taskDequeArray) +
+                               (size_t)capacity * sizeof(_Atomic(task *)));
+    if (!a)
+        error_abort("Unable to allocate task deque array");
+
+    a->capacity = capacity;
+
+    return a;
+}
+
+/**
+ * td_freeArray:
+ *      Free function for the retired array list.
+ */
+static void td_freeArray(void *data)
+{
+    free(*(taskDequeArray **)data);
+}
+
+/**
+ * td_create:
+ *      Create and initialize an empty task deque.
+ *      Returns the deque.
+ */
+taskDeque *td_create(void)
+{
+    taskDeque *d = aligned_alloc(_Alignof(taskDeque), sizeof(taskDeque));
+    if (!d)
+        error_abort("Unable to allocate taskDeque");
+
+    memset(d, 0, sizeof(taskDeque));
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, td_arrayCreate(TD_INITIAL_CAPACITY));
+    d->retired = ll_create(sizeof(taskDequeArray *), td_freeArray);
+
+    return d;                   // return new deque
+}
+
+/**
+ * td_delete:
+ *      Free a task deque and every array it has used.  Tasks still
+ *      in the deque are not run or freed.
+ */
+void td_delete(taskDeque *d)
+{
+    free(atomic_load_explicit(&d->array, memory_order_relaxed));
+    ll_delete(d->retired);
+    free(d);
+}
+
+/**
+ * td_grow:
+ *      Double the capacity of a deque's array, copying live tasks across.
+ *      Only called by the owner.  Returns the new array.
+ */
+static taskDequeArray *td_grow(taskDeque *d, taskDequeArray *a,
+                               int64_t top, int64_t bottom)
+{
+    taskDequeArray *b = td_arrayCreate(a->capacity * 2);
+
+    for (int64_t i = top; i < bottom; i++) {
+        task *t = atomic_load_explicit(&a->slots[i & (a->capacity - 1)],
+                                       memory_order_relaxed);
+        atomic_store_explicit(&b->slots[i & (b->capacity - 1)], t,
+                              memory_order_relaxed);
+    }
+
+    // Thieves may still be reading the old array, retire it
+    ll_append(d->retired, &a);
+    atomic_store_explicit(&d->array, b, memory_order_release);
+
+    return b;
+}
+
+/**
+ * td_push:
+ *      Push a task onto the bottom of a deque.  Owner only.
+ */
+void td_push(taskDeque *d, task *t)
+{
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&d->top, memory_order_acquire);
+    taskDequeArray *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+
+    // Grow the array if it is full
+    if (b - top > a->capacity - 1)
+        a = td_grow(d, a, top, b);
+
+    // Publish the task before making its slot visible to thieves
+    atomic_store_explicit(&a->slots[b & (a->capacity - 1)], t,
+                          memory_order_release);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+/**
+ * td_pop:
+ *      Pop a task from the bottom of a deque.  Owner only.
+ *      Returns NULL if the deque is empty.
+ */
+task *td_pop(taskDeque *d)
+{
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    taskDequeArray *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    task *x = NULL;
+
+    if (t <= b) {
+        x = atomic_load_explicit(&a->slots[b & (a->capacity - 1)],
+                                 memory_order_relaxed);
+
+        // Last task, race thieves for it
+        if (t == b) {
+            if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                         memory_order_seq_cst,
+                                                         memory_order_relaxed))
+                x = NULL;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+
+    return x;
+}
+
+/**
+ * td_steal:
+ *      Steal a task from the top of a deque.  Any thread.
+ *      Returns NULL if the deque is empty or another thread won the race.
+ */
+task *td_steal(taskDeque *d)
+{
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b)
+        return NULL;
+
+    taskDequeArray *a = atomic_load_explicit(&d->array, memory_order_acquire);
+    task *x = atomic_load_explicit(&a->slots[t & (a->capacity - 1)],
+                                   memory_order_acquire);
+
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return NULL;            // lost the race
+
+    return x;
+}
+
+/**
+ * td_length:
+ *      Return an estimate of the number of tasks in a deque.
+ */
+size_t td_length(taskDeque *d)
+{
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    return b > t ? (size_t)(b - t) : 0;
+}
+
+/**
+ * ts_takeInjectedLocked:
+ *      Remove the oldest task from the injection queue, lock must be held.
+ */
+static task *ts_takeInjectedLocked(taskScheduler *s)
+{
+    task *t = NULL;
+
+    if (dll_isEmpty(s->injection))
+        return NULL;
+
+    dll_head(s->injection, &t, true);
+    atomic_fetch_sub_explicit(&s->injected, 1, memory_order_relaxed);
+
+    return t;
+}
+
+/**
+ * ts_takeInjected:
+ *      Remove the oldest task from the injection queue.
+ */
+static task *ts_takeInjected(taskScheduler *s)
+{
+    // Avoid taking the lock when there is obviously nothing to take
+    if (atomic_load_explicit(&s->injected, memory_order_relaxed) == 0)
+        return NULL;
+
+    pthread_mutex_lock(&s->lock);
+    task *t = ts_takeInjectedLocked(s);
+    pthread_mutex_unlock(&s->lock);
+
+    return t;
+}
+
+/**
+ * ts_stealAny:
+ *      Try to steal a task from every other worker, starting at a random one.
+ */
+static task *ts_stealAny(taskWorker *w)
+{
+    taskScheduler *s = w->sched;
+    size_t start = (size_t)rand_r(&w->seed) % s->nworkers;
+    task *t;
+
+    for (size_t i = 0; i < s->nworkers; i++) {
+        taskWorker *victim = &s->workers[(start + i) % s->nworkers];
+        if (victim != w && (t = td_steal(victim->deque)))
+            return t;
+    }
+
+    return NULL;
+}
+
+/**
+ * ts_findWork:
+ *      Look for a task in the worker's own deque, the injection queue and
+ *      finally the other workers' deques.
+ */
+static task *ts_findWork(taskWorker *w, bool locked)
+{
+    task *t;
+
+    if ((t = td_pop(w->deque)))
+        return t;
+
+    if ((t = locked ? ts_takeInjectedLocked(w->sched)
+                    : ts_takeInjected(w->sched)))
+        return t;
+
+    return ts_stealAny(w);
+}
+
+/**
+ * ts_notify:
+ *      Wake a parked worker after publishing work to a deque.
+ */
+static void ts_notify(taskScheduler *s)
+{
+    // Pairs with the increment of sleepers in ts_park
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&s->sleepers, memory_order_relaxed) == 0)
+        return;
+
+    pthread_mutex_lock(&s->lock);
+    s->epoch++;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * ts_inject:
+ *      Append a task to the injection queue and wake a worker.
+ */
+static void ts_inject(taskScheduler *s, task *t)
+{
+    t->injected = true;
+
+    pthread_mutex_lock(&s->lock);
+    dll_append(s->injection, &t);
+    atomic_fetch_add_explicit(&s->injected, 1, memory_order_relaxed);
+    s->epoch++;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * ts_execute:
+ *      Run a task and mark it finished.
+ */
+static void ts_execute(taskScheduler *s, task *t)
+{
+    t->fn(t->arg);
+
+    // Detached tasks are owned by the scheduler
+    if (t->detached) {
+        free(t);
+        if (atomic_fetch_sub(&s->outstanding, 1) == 1) {
+            pthread_mutex_lock(&s->lock);
+            pthread_cond_broadcast(&s->finished);
+            pthread_mutex_unlock(&s->lock);
+        }
+        return;
+    }
+
+    // The task may be freed by its waiter as soon as done is set
+    bool injected = t->injected;
+    atomic_store_explicit(&t->done, true, memory_order_release);
+
+    if (injected) {
+        pthread_mutex_lock(&s->lock);
+        pthread_cond_broadcast(&s->finished);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/**
+ * ts_park:
+ *      Park an idle worker until new work is published.  Returns a task
+ *      found by the final scan, or NULL.  Sets *stop on shutdown.
+ */
+static task *ts_park(taskWorker *w, bool *stop)
+{
+    taskScheduler *s = w->sched;
+    task *t;
+
+    pthread_mutex_lock(&s->lock);
+    unsigned int epoch = s->epoch;
+
+    // Announce the intent to sleep, then scan once more so that a task
+    // published before the announcement can not be missed
+    atomic_fetch_add(&s->sleepers, 1);
+    t = ts_findWork(w, true);
+
+    while (!t && !s->shutdown && s->epoch == epoch)
+        pthread_cond_wait(&s->wake, &s->lock);
+
+    atomic_fetch_sub(&s->sleepers, 1);
+    *stop = !t && s->shutdown;
+    pthread_mutex_unlock(&s->lock);
+
+    return t;
+}
+
+/**
+ * ts_workerMain:
+ *      Worker thread entry point.
+ */
+static void *ts_workerMain(void *arg)
+{
+    taskWorker *w = arg;
+    bool stop = false;
+
+    currentWorker = w;
+
+    while (!stop) {
+        task *t = NULL;
+
+        // Look for work for a while before parking
+        for (int spin = 0; spin < TS_SPINS; spin++) {
+            if ((t = ts_findWork(w, false)))
+                break;
+            sched_yield();
+        }
+
+        if (!t)
+            t = ts_park(w, &stop);
+
+        if (t)
+            ts_execute(w->sched, t);
+    }
+
+    currentWorker = NULL;
+
+    return NULL;
+}
+
+/**
+ * ts_create:
+ *      Create a task scheduler with `nworkers` worker threads, or one
+ *      worker per online processor if `nworkers` is 0.
+ *      Returns the scheduler.
+ */
+taskScheduler *ts_create(size_t nworkers)
+{
+    if (nworkers == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        nworkers = n > 0 ? (size_t)n : 1;
+    }
+
+    // Allocate scheduler
+    taskScheduler *s = calloc(1, sizeof(taskScheduler));
+    if (!s)
+        error_abort("Unable to allocate taskScheduler");
+
+    if (!(s->workers = calloc(nworkers, sizeof(taskWorker))))
+        error_abort("Unable to allocate task workers");
+
+    // Initialize scheduler
+    s->nworkers = nworkers;
+    s->injection = dll_create(sizeof(task *), NULL);
+    atomic_init(&s->injected, 0);
+    atomic_init(&s->outstanding, 0);
+    atomic_init(&s->sleepers, 0);
+    s->epoch = 0;
+    s->shutdown = false;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    pthread_cond_init(&s->finished, NULL);
+
+    for (size_t i = 0; i < nworkers; i++) {
+        s->workers[i].sched = s;
+        s->workers[i].deque = td_create();
+        s->workers[i].id = i;
+        s->workers[i].seed = (unsigned int)(i * 2654435761u + 1);
+    }
+
+    // Deques must all exist before any worker starts stealing
+    for (size_t i = 0; i < nworkers; i++)
+        if (pthread_create(&s->workers[i].thread, NULL,
+                           ts_workerMain, &s->workers[i]) != 0)
+            error_syscall("Unable to create worker thread");
+
+    return s;                   // return new scheduler
+}
+
+/**
+ * ts_delete:
+ *      Wait for submitted tasks to finish, stop the worker threads
+ *      and free the scheduler.
+ */
+void ts_delete(taskScheduler *s)
+{
+    ts_wait(s);
+
+    // Tell the workers to exit once they run out of work
+    pthread_mutex_lock(&s->lock);
+    s->shutdown = true;
+    s->epoch++;
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+
+    for (size_t i = 0; i < s->nworkers; i++)
+        pthread_join(s->workers[i].thread, NULL);
+
+    for (size_t i = 0; i < s->nworkers; i++)
+        td_delete(s->workers[i].deque);
+
+    dll_delete(s->injection);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    pthread_cond_destroy(&s->finished);
+    free(s->workers);
+    free(s);
+}
+
+/**
+ * ts_schedule:
+ *      Queue a task on the calling worker's deque, or on the injection
+ *      queue when called from outside the scheduler.
+ */
+static void ts_schedule(taskScheduler *s, task *t)
+{
+    taskWorker *w = currentWorker;
+
+    if (w && w->sched == s) {
+        td_push(w->deque, t);
+        ts_notify(s);
+    } else {
+        ts_inject(s, t);
+    }
+}
+
+/**
+ * ts_spawn:
+ *      Fork: schedule `fn(arg)` to run in parallel with the caller.
+ *      The task storage is provided by the caller and must stay valid
+ *      until ts_sync has returned for it.
+ */
+void ts_spawn(taskScheduler *s, task *t, taskFunction fn, void *arg)
+{
+    assert(fn);
+
+    t->fn = fn;
+    t->arg = arg;
+    t->detached = false;
+    t->injected = false;
+    atomic_store_explicit(&t->done, false, memory_order_relaxed);
+
+    ts_schedule(s, t);
+}
+
+/**
+ * ts_sync:
+ *      Join: wait for a spawned task to finish.  Worker threads run other
+ *      tasks while they wait, other threads block.
+ */
+void ts_sync(taskScheduler *s, task *t)
+{
+    taskWorker *w = currentWorker;
+
+    if (w && w->sched == s) {
+        // Help out until the task has been run, most likely by ourselves
+        while (!atomic_load_explicit(&t->done, memory_order_acquire)) {
+            task *other = ts_findWork(w, false);
+            if (other)
+                ts_execute(s, other);
+            else
+                sched_yield();
+        }
+        return;
+    }
+
+    // Not a worker, block until the task's worker signals completion
+    pthread_mutex_lock(&s->lock);
+    while (!atomic_load_explicit(&t->done, memory_order_acquire))
+        pthread_cond_wait(&s->finished, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * ts_run:
+ *      Run `fn(arg)` on the scheduler and wait for it, along with
+ *      everything it spawns and syncs, to finish.
+ */
+void ts_run(taskScheduler *s, taskFunction fn, void *arg)
+{
+    task t;
+
+    ts_spawn(s, &t, fn, arg);
+    ts_sync(s, &t);
+}
+
+/**
+ * ts_submit:
+ *      Schedule a detached task, fire and forget.
+ *      Use ts_wait to wait for all detached tasks to finish.
+ */
+void ts_submit(taskScheduler *s, taskFunction fn, void *arg)
+{
+    assert(fn);
+
+    task *t = calloc(1, sizeof(task));
+    if (!t)
+        error_abort("Unable to allocate task");
+
+    t->fn = fn;
+    t->arg = arg;
+    t->detached = true;
+    atomic_init(&t->done, false);
+    atomic_fetch_add(&s->outstanding, 1);
+
+    ts_schedule(s, t);
+}
+
+/**
+ * ts_wait:
+ *      Wait for every detached task to finish.
+ *      Must not be called from a worker thread.
+ */
+void ts_wait(taskScheduler *s)
+{
+    assert(!currentWorker || currentWorker->sched != s);
+
+    pthread_mutex_lock(&s->lock);
+    while (atomic_load(&s->outstanding) > 0)
+        pthread_cond_wait(&s->finished, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * ts_workers:
+ *      Return the number of worker threads of a scheduler.
+ */
+size_t ts_workers(taskScheduler *s)
+{
+    return s->nworkers;
+}
+
+/**
+ * ts_currentWorker:
+ *      Return the worker running on the calling thread, or NULL.
+ */
+taskWorker *ts_currentWorker(void)
+{
+    return currentWorker;
+}
@@ -24,7 +24,9 @@ SOFTWARE.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "lists.h"
+#include "errors.h"
 
 /**
  * iterFunc_exists:
@@ -50,6 +52,21 @@ void freeString(void *data)
     free(*(char **)data);
 }
 
+/**
+ * copyString:
+ *      Copy string data, duplicating the string.
+ */
+void copyString(void *dst, const void *src)
+{
+    const char *str = *(char *const *)src;
+    char *copy = NULL;
+
+    if (str && !(copy = strdup(str)))
+        error_abort("Unable to allocate string");
+
+    *(char **)dst = copy;
+}
+
 /**
  * compareInt:
  *      Compare two integers for equality.
@@ -71,11 +88,9 @@ result compareStr(const void *a, const void *b)
 {
     const char *ca = *(const char **)a;
     const char *cb = *(const char **)b;
+    int c = strcmp(ca, cb);
 
-    if (strcmp(ca, cb) < 0) return LESS;
-    else if (strcmp(ca, cb) > 0) return GREATER;
-
-    return EQUAL;
+    return (c > 0) - (c < 0);
 }
 
 /**
@@ -107,3 +122,121 @@ void printReverseIntLinkedList(linkedListNode *head)
     printReverseIntLinkedList(head->next);
     printf(" %d ", *(int *)head->data);
 }
+
+/**
+ * hash_fnv1a:
+ *      Hash `len` bytes with the 64 bit FNV-1a hash.
+ */
+uint64_t hash_fnv1a(const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint64_t h = 0xcbf29ce484222325ULL;     // FNV offset basis
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;              // FNV prime
+    }
+
+    return h;
+}
+
+/**
+ * hashInt:
+ *      Hash function for integer data.
+ */
+uint64_t hashInt(const void *data)
+{
+    return hash_fnv1a(data, sizeof(int));
+}
+
+/**
+ * hashStr:
+ *      Hash function for string data.
+ */
+uint64_t hashStr(const void *data)
+{
+    const char *s = *(const char **)data;
+
+    return hash_fnv1a(s, strlen(s));
+}
+
+/**
+ * strKey_view:
+ *      Return a key for the string `s` of `len` bytes that refers to `s`
+ *      instead of copying it.  The key must not be freed with freeStrKey.
+ */
+strKey strKey_view(const char *s, size_t len)
+{
+    strKey k = { (char *)s, len, hash_fnv1a(s, len), 0 };
+
+    // Pack the first 8 bytes so that integer order is byte order
+    for (size_t i = 0; i < 8; i++)
+        k.prefix = k.prefix << 8 | (i < len ? (unsigned char)s[i] : 0);
+
+    return k;
+}
+
+/**
+ * strKey_make:
+ *      Return a key holding a copy of the string `s` of `len` bytes.
+ */
+strKey strKey_make(const char *s, size_t len)
+{
+    char *copy = malloc(len + 1);
+    if (!copy)
+        error_abort("Unable to allocate strKey");
+
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+
+    return strKey_view(copy, len);
+}
+
+/**
+ * compareStrKey:
+ *      Compare two strKeys, deciding on the prefixes unless they are equal.
+ *      Result is LESS for a < b, EQUAL for a == b, GREATER for a > b
+ */
+result compareStrKey(const void *a, const void *b)
+{
+    const strKey *ka = a;
+    const strKey *kb = b;
+
+    if (ka->prefix != kb->prefix)
+        return ka->prefix < kb->prefix ? LESS : GREATER;
+
+    // Same first 8 bytes, compare the rest then the lengths
+    size_t len = ka->length < kb->length ? ka->length : kb->length;
+    int c = len > 8 ? memcmp(ka->str + 8, kb->str + 8, len - 8) : 0;
+    if (c == 0)
+        c = (ka->length > kb->length) - (ka->length < kb->length);
+
+    return (c > 0) - (c < 0);
+}
+
+/**
+ * equalStrKey:
+ *      Equality comparator for strKeys, EQUAL if the strings are equal and
+ *      otherwise LESS or GREATER in no meaningful order.
+ */
+result equalStrKey(const void *a, const void *b)
+{
+    const strKey *ka = a;
+    const strKey *kb = b;
+
+    if (ka->hash != kb->hash || ka->length != kb->length)
+        return ka->hash < kb->hash ? LESS : GREATER;
+
+    int c = memcmp(ka->str, kb->str, ka->length);
+
+    return (c > 0) - (c < 0);
+}
+
+/**
+ * freeStrKey:
+ *      Free the string copied into a strKey by strKey_make.
+ */
+void freeStrKey(void *data)
+{
+    free(((strKey *)data)->str);
+}
@@ -0,0 +1,493 @@
+/** xorList.c - XOR linked list implementation.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "xorList.h"
+#include "nodeCache.h"
+#include "errors.h"
+
+// Offset of a node's data within its block, pointer aligned to save space
+#define XL_DATA_OFFSET sizeof(xLinkedListNode)
+
+/**
+ * xl_nodeData:
+ *      Return a pointer to a node's data.
+ */
+static inline void *xl_nodeData(xLinkedListNode *node)
+{
+    return (char *)node + XL_DATA_OFFSET;
+}
+
+/**
+ * xl_other:
+ *      Return the neighbour of `node` that is not `from`.
+ */
+static inline xLinkedListNode *xl_other(xLinkedListNode *node,
+                                        xLinkedListNode *from)
+{
+    return (xLinkedListNode *)(node->link ^ (uintptr_t)from);
+}
+
+/**
+ * xl_relink:
+ *      Replace neighbour `from` of `node` with `to`.
+ */
+static inline void xl_relink(xLinkedListNode *node, xLinkedListNode *from,
+                             xLinkedListNode *to)
+{
+    node->link ^= (uintptr_t)from ^ (uintptr_t)to;
+}
+
+/**
+ * xl_create:
+ *      Create and initialize an XOR linked list.
+ *      Returns the list.
+ */
+xLinkedList *xl_create(size_t size, freeFunction fn)
+{
+    // Allocate list
+    xLinkedList *l = calloc(1, sizeof(xLinkedList));
+    if (!l)
+        error_abort("Unable to allocate xLinkedList");
+
+    // Initialize list
+    l->logicalLength = 0;
+    l->elementSize = size;
+    l->head = l->tail = NULL;
+    l->freeFn = fn;
+    l->cached = nc_getDefault();
+
+    return l;                   // return new list
+}
+
+/**
+ * xl_createCached:
+ *      Create and initialize an XOR linked list whose nodes are allocated
+ *      from per-thread node caches.
+ *      Returns the list.
+ */
+xLinkedList *xl_createCached(size_t size, freeFunction fn)
+{
+    xLinkedList *l = xl_create(size, fn);
+    l->cached = true;
+
+    return l;                   // return new list
+}
+
+/**
+ * xl_newNode:
+ *      Allocate a node holding a copy of `el`, the node and its data
+ *      share a single block.
+ */
+static xLinkedListNode *xl_newNode(xLinkedList *l, void *el)
+{
+    xLinkedListNode *node = nc_alloc(XL_DATA_OFFSET + l->elementSize,
+                                     l->cached);
+
+    // Copy new data into node
+    memcpy(xl_nodeData(node), el, l->elementSize);
+    node->link = 0;
+
+    return node;
+}
+
+/**
+ * xl_freeNode:
+ *      Free a node and its data.
+ */
+static void xl_freeNode(xLinkedList *l, xLinkedListNode *node)
+{
+    // Use freeFunction if it exists
+    if (l->freeFn)
+        l->freeFn(xl_nodeData(node));
+
+    nc_free(node);
+}
+
+/**
+ * xl_unlink:
+ *      Unlink node `curr`, whose previous node is `prev`, from a list.
+ *      Returns the node that followed it.
+ */
+static xLinkedListNode *xl_unlink(xLinkedList *l, xLinkedListNode *prev,
+                                  xLinkedListNode *curr)
+{
+    xLinkedListNode *next = xl_other(curr, prev);
+
+    // Join the neighbours, including the list's head/tail
+    if (prev)
+        xl_relink(prev, curr, next);
+    else
+        l->head = next;
+
+    if (next)
+        xl_relink(next, curr, prev);
+    else
+        l->tail = prev;
+
+    l->logicalLength--;         // decrease list's logical length
+
+    return next;
+}
+
+/**
+ * xl_delete:
+ *      Remove each node from a list.
+ */
+void xl_delete(xLinkedList *l)
+{
+    xLinkedListNode *curr = l->head;
+    uintptr_t prev = 0;         // address of the node just freed
+
+    // Traverse list and delete each node
+    while (curr) {
+        xLinkedListNode *next = (xLinkedListNode *)(curr->link ^ prev);
+
+        prev = (uintptr_t)curr;
+        xl_freeNode(l, curr);   // free node
+        curr = next;
+    }
+
+    // Free list
+    free(l);
+}
+
+/**
+ * xl_push:
+ *      Push a new node to the front of a list.
+ */
+void xl_push(xLinkedList *l, void *el)
+{
+    // Allocate a new list node holding a copy of el
+    xLinkedListNode *node = xl_newNode(l, el);
+
+    // Set new node links
+    node->link = (uintptr_t)l->head;
+    if (l->head)
+        xl_relink(l->head, NULL, node);
+    else
+        l->tail = node;
+
+    l->head = node;
+    l->logicalLength++;         // increase list's logical length
+}
+
+/**
+ * xl_append:
+ *      Append a new node to the end of a list.
+ */
+void xl_append(xLinkedList *l, void *el)
+{
+    // Allocate a new list node holding a copy of el
+    xLinkedListNode *node = xl_newNode(l, el);
+
+    // Set new node links
+    node->link = (uintptr_t)l->tail;
+    if (l->tail)
+        xl_relink(l->tail, NULL, node);
+    else
+        l->head = node;
+
+    l->tail = node;
+    l->logicalLength++;         // increase list's logical length
+}
+
+/**
+ * xl_insertAfter:
+ *      Insert a new node after the cursor's node, the cursor stays on
+ *      its node.
+ */
+void xl_insertAfter(xLinkedList *l, xlCursor *c, void *el)
+{
+    assert(c->curr);
+
+    xLinkedListNode *next = xl_other(c->curr, c->prev);
+
+    // Use append method if the cursor is on the list tail
+    if (!next) {
+        xl_append(l, el);
+        return;
+    }
+
+    // Allocate a new node holding a copy of el
+    xLinkedListNode *node = xl_newNode(l, el);
+
+    // Set new node links
+    node->link = (uintptr_t)c->curr ^ (uintptr_t)next;
+    xl_relink(c->curr, next, node);
+    xl_relink(next, c->curr, node);
+    l->logicalLength++;         // increase list's logical length
+}
+
+/**
+ * xl_insertBefore:
+ *      Insert a new node before the cursor's node, the cursor stays on
+ *      its node.
+ */
+void xl_insertBefore(xLinkedList *l, xlCursor *c, void *el)
+{
+    assert(c->curr);
+
+    // Use push method if the cursor is on the list head
+    if (!c->prev) {
+        xl_push(l, el);
+        c->prev = l->head;
+        return;
+    }
+
+    // Allocate a new node holding a copy of el
+    xLinkedListNode *node = xl_newNode(l, el);
+
+    // Set new node links
+    node->link = (uintptr_t)c->prev ^ (uintptr_t)c->curr;
+    xl_relink(c->prev, c->curr, node);
+    xl_relink(c->curr, c->prev, node);
+    c->prev = node;
+    l->logicalLength++;         // increase list's logical length
+}
+
+/**
+ * xl_deleteNode:
+ *      Delete a node from a list containing value `data`.
+ */
+void xl_deleteNode(xLinkedList *l, void *data, nodeComparator cmp)
+{
+    // Assert that a node compare function was provided
+    assert(cmp);
+
+    // Traverse the list looking for the node to delete
+    for (xlCursor c = xl_first(l); c.curr; xl_next(&c)) {
+        if (cmp(xl_nodeData(c.curr), data) == EQUAL) {
+            xl_removeAt(l, &c);
+            return;
+        }
+    }
+}
+
+/**
+ * xl_removeAt:
+ *      Delete the cursor's node from a list, the cursor moves on to the
+ *      following node.
+ */
+void xl_removeAt(xLinkedList *l, xlCursor *c)
+{
+    assert(c->curr);
+
+    xLinkedListNode *node = c->curr;
+    c->curr = xl_unlink(l, c->prev, node);
+    xl_freeNode(l, node);
+}
+
+/**
+ * xl_search:
+ *      Search a list for a node containing `data`.
+ */
+bool xl_search(xLinkedList *l, void *data, nodeComparator cmp)
+{
+    // Assert that a node compare function was provided
+    assert(cmp);
+
+    xLinkedListNode *prev = NULL, *curr = l->head;
+
+    // Traverse the list looking for a node matching `data`
+    while (curr) {
+        if (cmp(xl_nodeData(curr), data) == EQUAL)
+            return true;
+
+        xLinkedListNode *next = xl_other(curr, prev);
+        prev = curr;
+        curr = next;
+    }
+
+    return false;
+}
+
+/**
+ * xl_foreach:
+ *      Iterate over an XOR linked list and perform the tasks in the
+ *      listIterator function on each node.
+ */
+void xl_foreach(xLinkedList *l, listIterator it, displayFunction display)
+{
+    // Assert that a list iterating function was passed
+    assert(it);
+
+    xLinkedListNode *prev = NULL, *curr = l->head;
+    bool result = true;
+
+    // Iterate over the list
+    while (curr && result) {
+        result = it(xl_nodeData(curr), display);
+
+        xLinkedListNode *next = xl_other(curr, prev);
+        prev = curr;
+        curr = next;
+    }
+}
+
+/**
+ * xl_head:
+ *      Return a copy of the head node's data of an XOR linked list and
+ *      optionally remove/pop it from the list.
+ */
+void xl_head(xLinkedList *l, void *el, bool remove)
+{
+    // Assert that the list is not empty
+    assert(l->head);
+
+    // Copy the list's head to a new element
+    xLinkedListNode *node = l->head;
+    memcpy(el, xl_nodeData(node), l->elementSize);
+
+    // Remove/pop head node from list
+    if (remove) {
+        xl_unlink(l, NULL, node);
+        xl_freeNode(l, node);
+    }
+}
+
+/**
+ * xl_tail:
+ *      Return a copy of the tail node's data of an XOR linked list and
+ *      optionally remove/pop it from the list.
+ */
+void xl_tail(xLinkedList *l, void *el, bool remove)
+{
+    // Assert that the list is not empty
+    assert(l->tail);
+
+    // Copy the list's tail to a new element
+    xLinkedListNode *node = l->tail;
+    memcpy(el, xl_nodeData(node), l->elementSize);
+
+    // Remove/pop tail node from list
+    if (remove) {
+        xl_unlink(l, xl_other(node, NULL), node);
+        xl_freeNode(l, node);
+    }
+}
+
+/**
+ * xl_isEmpty:
+ *      Return true if the XOR linked list is empty, return false otherwise.
+ */
+bool xl_isEmpty(xLinkedList *l)
+{
+    return l->logicalLength == 0;
+}
+
+/**
+ * xl_length:
+ *      Return the number of nodes in an XOR linked list.
+ */
+size_t xl_length(xLinkedList *l)
+{
+    return l->logicalLength;
+}
+
+/**
+ * xl_reverse:
+ *      Reverse the node order of an XOR linked list, a node's link reads
+ *      the same in both directions so only the head and tail are swapped.
+ *      Cursors into the list are invalidated.
+ */
+void xl_reverse(xLinkedList *l)
+{
+    xLinkedListNode *head = l->head;
+    l->head = l->tail;
+    l->tail = head;
+}
+
+/**
+ * xl_first:
+ *      Return a cursor on the head node of a list.
+ */
+xlCursor xl_first(xLinkedList *l)
+{
+    xlCursor c = { NULL, l->head };
+
+    return c;
+}
+
+/**
+ * xl_last:
+ *      Return a cursor on the tail node of a list.
+ */
+xlCursor xl_last(xLinkedList *l)
+{
+    xlCursor c = { l->tail ? xl_other(l->tail, NULL) : NULL, l->tail };
+
+    return c;
+}
+
+/**
+ * xl_valid:
+ *      Return true if the cursor is on a node.
+ */
+bool xl_valid(xlCursor *c)
+{
+    return c->curr != NULL;
+}
+
+/**
+ * xl_next:
+ *      Move a cursor to the following node, past the tail it is no longer
+ *      valid.
+ */
+void xl_next(xlCursor *c)
+{
+    if (!c->curr)
+        return;
+
+    xLinkedListNode *next = xl_other(c->curr, c->prev);
+    c->prev = c->curr;
+    c->curr = next;
+}
+
+/**
+ * xl_prev:
+ *      Move a cursor to the preceding node, past the head it is no longer
+ *      valid.
+ */
+void xl_prev(xlCursor *c)
+{
+    xLinkedListNode *prev = c->prev;
+
+    // Step back from one past the tail or from any node but the head
+    c->prev = prev ? xl_other(prev, c->curr) : NULL;
+    c->curr = prev;
+}
+
+/**
+ * xl_data:
+ *      Return a pointer to the data of the cursor's node.
+ */
+void *xl_data(xlCursor *c)
+{
+    assert(c->curr);
+
+    return xl_nodeData(c->curr);
+}
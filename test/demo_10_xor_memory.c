@@ -0,0 +1,149 @@
+/** demo_10_xor_memory.c - Demo of XOR linked list memory savings.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <malloc.h>
+#include "lists.h"
+#include "xorList.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 100000    // nodes in each list measured
+
+// Element types measured
+typedef struct point {
+    double x, y;
+} point;
+
+size_t heapInUse(void);
+size_t measureDll(size_t, size_t);
+size_t measureXl(size_t, size_t);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    size_t sizes[] = { sizeof(int), sizeof(point), 64 };
+
+    printf("==== HEAP BYTES PER NODE, %zu NODES ====\n\n", nodes);
+    printf("element   dLinkedList   xLinkedList   saved\n");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t dll = measureDll(sizes[i], nodes);
+        size_t xl = measureXl(sizes[i], nodes);
+
+        printf("%5zu B   %11.1f   %11.1f   %4.1f%%\n", sizes[i],
+               (double)dll / nodes, (double)xl / nodes,
+               100.0 * (double)(dll - xl) / dll);
+
+        if (xl >= dll) {
+            fprintf(stderr, "xLinkedList used no less memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * heapInUse:
+ *      Return the number of bytes allocated from the heap.
+ */
+size_t heapInUse(void)
+{
+    struct mallinfo2 mi = mallinfo2();
+
+    return mi.uordblks + mi.hblkhd;
+}
+
+/**
+ * measureDll:
+ *      Return the heap bytes used by a dLinkedList of `nodes` elements,
+ *      after checking it traverses both ways.
+ */
+size_t measureDll(size_t size, size_t nodes)
+{
+    unsigned char *el = calloc(1, size);
+    size_t before = heapInUse();
+    dLinkedList *l = dll_create(size, NULL);
+
+    for (size_t i = 0; i < nodes; i++) {
+        *el = (unsigned char)i;
+        dll_append(l, el);
+    }
+    size_t used = heapInUse() - before;
+
+    // Check the list forwards and backwards
+    size_t i = 0;
+    for (dLinkedListNode *n = l->head; n; n = n->next, i++)
+        if (*(unsigned char *)n->data != (unsigned char)i)
+            error_quit("dLinkedList element %zu is wrong", i);
+    for (dLinkedListNode *n = l->tail; n; n = n->prev)
+        if (*(unsigned char *)n->data != (unsigned char)--i)
+            error_quit("dLinkedList element %zu is wrong", i);
+
+    dll_delete(l);
+    free(el);
+
+    return used;
+}
+
+/**
+ * measureXl:
+ *      Return the heap bytes used by an xLinkedList of `nodes` elements,
+ *      after checking it traverses both ways.
+ */
+size_t measureXl(size_t size, size_t nodes)
+{
+    unsigned char *el = calloc(1, size);
+    size_t before = heapInUse();
+    xLinkedList *l = xl_create(size, NULL);
+
+    for (size_t i = 0; i < nodes; i++) {
+        *el = (unsigned char)i;
+        xl_append(l, el);
+    }
+    size_t used = heapInUse() - before;
+
+    // Check the list forwards and backwards
+    size_t i = 0;
+    for (xlCursor c = xl_first(l); xl_valid(&c); xl_next(&c), i++)
+        if (*(unsigned char *)xl_data(&c) != (unsigned char)i)
+            error_quit("xLinkedList element %zu is wrong", i);
+    for (xlCursor c = xl_last(l); xl_valid(&c); xl_prev(&c))
+        if (*(unsigned char *)xl_data(&c) != (unsigned char)--i)
+            error_quit("xLinkedList element %zu is wrong", i);
+
+    xl_delete(l);
+    free(el);
+
+    return used;
+}
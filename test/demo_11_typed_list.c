@@ -0,0 +1,307 @@
+/** demo_11_typed_list.c - Benchmark of type specialized lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include "lists.h"
+#include "typedList.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 20000     // nodes searched and iterated
+#define SORT_NODES 3000         // nodes sorted, selection sort is quadratic
+#define SEARCHES 200            // searches for a missing element
+
+LTYPES_DEFINE_LIST(intList, int, LTYPES_COMPARE(a, b))
+LTYPES_DEFINE_LIST(strList, char *, strcmp(a, b))
+
+static long long total;         // accumulated by the generic iterators
+
+double now(void);
+char *makeString(unsigned);
+void freeStr(char **);
+bool sumInt(void *, displayFunction);
+bool sumStr(void *, displayFunction);
+bool sumIntTyped(int *, void *);
+bool sumStrTyped(char **, void *);
+void report(const char *, double, double);
+void benchInts(size_t);
+void benchStrings(size_t);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+
+    printf("==== linkedList VS LTYPES_DEFINE_LIST, %zu NODES ====\n\n", nodes);
+    printf("operation          linkedList      typed  speedup\n");
+
+    benchInts(nodes);
+    benchStrings(nodes);
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * makeString:
+ *      Return a newly allocated string for key `n`, keys share a prefix so
+ *      comparisons are not decided by the first character.
+ */
+char *makeString(unsigned n)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key-%010u", n);
+
+    char *s = strdup(buf);
+    if (!s)
+        error_abort("Unable to allocate string");
+
+    return s;
+}
+
+/**
+ * freeStr:
+ *      Free function for the typed string list.
+ */
+void freeStr(char **s)
+{
+    free(*s);
+}
+
+/**
+ * sumInt, sumStr, sumIntTyped, sumStrTyped:
+ *      Iterators that accumulate something from every element.
+ */
+bool sumInt(void *data, displayFunction display)
+{
+    total += *(int *)data;
+    return true;
+}
+
+bool sumStr(void *data, displayFunction display)
+{
+    total += (unsigned char)(*(char **)data)[13];
+    return true;
+}
+
+bool sumIntTyped(int *data, void *ctx)
+{
+    *(long long *)ctx += *data;
+    return true;
+}
+
+bool sumStrTyped(char **data, void *ctx)
+{
+    *(long long *)ctx += (unsigned char)(*data)[13];
+    return true;
+}
+
+/**
+ * report:
+ *      Print the timings of one operation.
+ */
+void report(const char *op, double generic, double typed)
+{
+    printf("%-16s %10.2fms %8.2fms %7.2fx\n", op, generic * 1e3, typed * 1e3,
+           generic / typed);
+}
+
+/**
+ * benchInts:
+ *      Time search, foreach and sort on lists of ints.
+ */
+void benchInts(size_t nodes)
+{
+    linkedList *l = ll_create(sizeof(int), NULL);
+    intList *t = intList_create(NULL);
+    double start, generic, typed;
+    long long sum = 0;
+    int missing = -1;
+
+    srand(1);
+    for (size_t i = 0; i < nodes; i++) {
+        int v = rand();
+        ll_append(l, &v);
+        intList_append(t, v);
+    }
+
+    // Search for an element that is not there
+    start = now();
+    for (int i = 0; i < SEARCHES; i++)
+        if (ll_search(l, &missing, compareInt))
+            error_quit("Found a missing int");
+    generic = now() - start;
+
+    start = now();
+    for (int i = 0; i < SEARCHES; i++)
+        if (intList_search(t, missing))
+            error_quit("Found a missing int");
+    typed = now() - start;
+    report("int search", generic, typed);
+
+    // Sum every element
+    total = 0;
+    start = now();
+    ll_foreach(l, sumInt, NULL);
+    generic = now() - start;
+
+    start = now();
+    intList_foreach(t, sumIntTyped, &sum);
+    typed = now() - start;
+    report("int foreach", generic, typed);
+
+    if (sum != total)
+        error_quit("int sums differ, %lld and %lld", total, sum);
+
+    ll_delete(l);
+    intList_delete(t);
+
+    // Sort a shorter list
+    l = ll_create(sizeof(int), NULL);
+    t = intList_create(NULL);
+    for (size_t i = 0; i < SORT_NODES; i++) {
+        int v = rand();
+        ll_append(l, &v);
+        intList_append(t, v);
+    }
+
+    start = now();
+    ll_selectionSort(l, compareInt);
+    generic = now() - start;
+
+    start = now();
+    intList_selectionSort(t);
+    typed = now() - start;
+    report("int sort", generic, typed);
+
+    // Both sorts must give the same order
+    intList_node *tn = t->head;
+    for (linkedListNode *n = l->head; n; n = n->next, tn = tn->next)
+        if (*(int *)n->data != tn->data)
+            error_quit("int sorts differ");
+
+    ll_delete(l);
+    intList_delete(t);
+}
+
+/**
+ * benchStrings:
+ *      Time search, foreach and sort on lists of strings.
+ */
+void benchStrings(size_t nodes)
+{
+    linkedList *l = ll_create(sizeof(char *), freeString);
+    strList *t = strList_create(freeStr);
+    double start, generic, typed;
+    long long sum = 0;
+    char *missing = makeString(~0u);
+
+    srand(2);
+    for (size_t i = 0; i < nodes; i++) {
+        unsigned v = (unsigned)rand();
+        char *a = makeString(v), *b = makeString(v);
+        ll_append(l, &a);
+        strList_append(t, b);
+    }
+
+    // Search for an element that is not there
+    start = now();
+    for (int i = 0; i < SEARCHES; i++)
+        if (ll_search(l, &missing, compareStr))
+            error_quit("Found a missing string");
+    generic = now() - start;
+
+    start = now();
+    for (int i = 0; i < SEARCHES; i++)
+        if (strList_search(t, missing))
+            error_quit("Found a missing string");
+    typed = now() - start;
+    report("string search", generic, typed);
+
+    // Sum a character of every element
+    total = 0;
+    start = now();
+    ll_foreach(l, sumStr, NULL);
+    generic = now() - start;
+
+    start = now();
+    strList_foreach(t, sumStrTyped, &sum);
+    typed = now() - start;
+    report("string foreach", generic, typed);
+
+    if (sum != total)
+        error_quit("string sums differ, %lld and %lld", total, sum);
+
+    ll_delete(l);
+    strList_delete(t);
+
+    // Sort a shorter list
+    l = ll_create(sizeof(char *), freeString);
+    t = strList_create(freeStr);
+    for (size_t i = 0; i < SORT_NODES; i++) {
+        unsigned v = (unsigned)rand();
+        char *a = makeString(v), *b = makeString(v);
+        ll_append(l, &a);
+        strList_append(t, b);
+    }
+
+    start = now();
+    ll_selectionSort(l, compareStr);
+    generic = now() - start;
+
+    start = now();
+    strList_selectionSort(t);
+    typed = now() - start;
+    report("string sort", generic, typed);
+
+    // Both sorts must give the same order
+    strList_node *tn = t->head;
+    for (linkedListNode *n = l->head; n; n = n->next, tn = tn->next)
+        if (strcmp(*(char **)n->data, tn->data) != 0)
+            error_quit("string sorts differ");
+
+    ll_delete(l);
+    strList_delete(t);
+    free(missing);
+}
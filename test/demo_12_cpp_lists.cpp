@@ -0,0 +1,267 @@
+/** demo_12_cpp_lists.cpp - Demo/benchmark of the C++ typed lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "ltypes.hpp"
+
+extern "C" {
+#include "lists.h"
+#include "errors.h"
+}
+
+#define DEFAULT_NODES 500000    // nodes in each list benchmarked
+
+// Timings of one container
+struct timings {
+    double build;               // push_back of every element
+    double iterate;             // std::accumulate over the list
+    double sort;                // sort member function
+};
+
+static long long total;         // accumulated by the C iterator
+
+/**
+ * seconds:
+ *      Return the seconds elapsed since `start`.
+ */
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start).count();
+}
+
+/**
+ * report:
+ *      Print the timings of one container, a negative time is not measured.
+ */
+static void report(const char *name, const timings &t)
+{
+    std::printf("%-30s %9.2fms %9.2fms ", name, t.build * 1e3,
+                t.iterate * 1e3);
+    if (t.sort < 0)
+        std::printf("%10s\n", "-");
+    else
+        std::printf("%9.2fms\n", t.sort * 1e3);
+}
+
+/**
+ * check:
+ *      Exit with a message if a condition does not hold.
+ */
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        std::fprintf(stderr, "Check failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * runner:
+ *      Builds, iterates and sorts one C++ list of ints.  Every list is
+ *      built before any is sorted, sorting scatters the free nodes and
+ *      would slow down whichever list is built next.
+ */
+template <typename List>
+struct runner {
+    List l;                     // list benchmarked
+    timings t;                  // its timings
+
+    void build(const std::vector<int> &values, long long expected)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int v : values)
+            l.push_back(v);
+        t.build = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        long long sum = std::accumulate(l.begin(), l.end(), 0LL);
+        t.iterate = seconds(start);
+        check(sum == expected, "sum of list");
+    }
+
+    void sort()
+    {
+        auto start = std::chrono::steady_clock::now();
+        l.sort([](int a, int b) { return a < b; });
+        t.sort = seconds(start);
+        check(std::is_sorted(l.begin(), l.end()), "list is sorted");
+    }
+};
+
+/**
+ * sumInt:
+ *      Iterator accumulating every int of a C list.
+ */
+static bool sumInt(void *data, displayFunction display)
+{
+    total += *(int *)data;
+    return true;
+}
+
+/**
+ * benchC:
+ *      Time building and iterating a dLinkedList of ints, its only sort
+ *      is a quadratic selection sort so sorting is not timed.
+ */
+static timings benchC(const std::vector<int> &values, long long expected)
+{
+    timings t;
+    dLinkedList *l = dll_create(sizeof(int), NULL);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int v : values)
+        dll_append(l, (void *)&v);
+    t.build = seconds(start);
+
+    total = 0;
+    start = std::chrono::steady_clock::now();
+    dll_foreach(l, sumInt, NULL);
+    t.iterate = seconds(start);
+    check(total == expected, "sum of dLinkedList");
+
+    t.sort = -1;
+    dll_delete(l);
+
+    return t;
+}
+
+/**
+ * strings:
+ *      Exercise non trivially copyable elements, splicing and algorithms.
+ */
+static void strings()
+{
+    ltypes::dlist<std::string> a = { "pear", "apple", "fig" };
+    ltypes::dlist<std::string> b;
+
+    b.emplace_back(3, 'z');
+    b.push_front(std::string("banana"));
+    a.splice(a.end(), b);
+    check(b.empty() && a.size() == 5, "splice moves every node");
+
+    a.sort();
+    check(std::is_sorted(a.begin(), a.end()), "strings are sorted");
+    check(a.front() == "apple" && a.back() == "zzz", "sorted ends");
+    check(std::find(a.begin(), a.end(), "fig") != a.end(), "find a string");
+    check(*a.rbegin() == "zzz", "reverse iteration");
+
+    a.remove_if([](const std::string &s) { return s.size() == 3; });
+    check(a.size() == 3, "remove_if drops short strings");
+
+    ltypes::list<std::string> s = { "c", "b", "a" };
+    s.reverse();
+    ltypes::list<std::string> copy = s;
+    check(std::equal(copy.begin(), copy.end(), s.begin()), "copy a list");
+    check(s.front() == "a" && s.back() == "c", "reverse a list");
+}
+
+/**
+ * eraseAfter:
+ *      Erase after the front position end(), the head, a middle element
+ *      and the element before the tail.
+ */
+static void eraseAfter()
+{
+    ltypes::list<int> l;
+
+    l.insert_after(l.end(), 1);
+    check(l.erase_after(l.end()) == l.end() && l.empty(),
+          "erase_after(end()) empties a list of one");
+
+    l = { 1, 2, 3, 4 };
+    auto it = l.erase_after(l.end());
+    check(*it == 2 && l.front() == 2 && l.size() == 3,
+          "erase_after(end()) removes the front");
+
+    it = l.erase_after(l.begin());
+    check(*it == 4 && l.size() == 2, "erase_after removes a middle element");
+
+    it = l.erase_after(l.begin());
+    check(it == l.end() && l.back() == 2 && l.size() == 1,
+          "erase_after removes the tail");
+
+    l.push_back(5);
+    check(l.back() == 5 && *std::next(l.begin()) == 5,
+          "append after erasing the tail");
+}
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    std::signal(SIGINT, sig_int);
+    std::signal(SIGSEGV, sig_seg);
+
+    std::size_t nodes = argc > 1 ? std::strtoul(argv[1], NULL, 10)
+                                 : DEFAULT_NODES;
+
+    std::vector<int> values(nodes);
+    std::mt19937 rng(1);
+    for (int &v : values)
+        v = static_cast<int>(rng() % 1000000);
+    long long expected = std::accumulate(values.begin(), values.end(), 0LL);
+
+    strings();
+    eraseAfter();
+
+    std::printf("==== C++ LISTS OF %zu INTS ====\n\n", nodes);
+    std::printf("%-30s %11s %11s %11s\n", "container", "push_back",
+                "iterate", "sort");
+
+    runner<std::list<int>> stdList;
+    runner<ltypes::list<int>> list;
+    runner<ltypes::dlist<int>> dlist;
+    runner<ltypes::dlist<int, ltypes::cache_allocator<int>>> cached;
+
+    timings c = benchC(values, expected);
+    stdList.build(values, expected);
+    list.build(values, expected);
+    dlist.build(values, expected);
+    cached.build(values, expected);
+
+    stdList.sort();
+    list.sort();
+    dlist.sort();
+    cached.sort();
+
+    report("std::list", stdList.t);
+    report("ltypes::list", list.t);
+    report("ltypes::dlist", dlist.t);
+    report("ltypes::dlist, cache_allocator", cached.t);
+    report("dLinkedList (C API)", c);
+
+    return 0;
+}
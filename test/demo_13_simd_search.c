@@ -0,0 +1,186 @@
+/** demo_13_simd_search.c - Benchmark of the vectorized search kernels.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "lists.h"
+#include "simd.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 1000000   // elements in the list searched
+#define PASSES 20               // passes of each search over the elements
+
+double now(void);
+void report(const char *, double, double, double);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    linkedList *l = ll_create(sizeof(int32_t), NULL);
+    double start, list, scalar, simd;
+    int32_t missing = -1, key = 42, lo = 1000, hi = 50000;
+
+    srand(1);
+    for (size_t i = 0; i < nodes; i++) {
+        int32_t v = rand() % 100000;
+        ll_append(l, &v);
+    }
+
+    // Export the list to a contiguous array
+    int32_t *a = malloc(nodes * sizeof(int32_t) + 1);
+    if (!a)
+        error_abort("Unable to allocate array");
+
+    start = now();
+    if (ll_toArray(l, a) != nodes)
+        error_quit("ll_toArray copied the wrong number of elements");
+    double export = now() - start;
+
+    printf("==== SEARCHING %zu INT32 ELEMENTS, KERNELS: %s ====\n\n", nodes,
+           simd_level());
+    printf("ll_toArray export %.2fms\n\n", export * 1e3);
+    printf("operation      ll_search     scalar       simd  speedup\n");
+
+    // Search for an element that is not there
+    start = now();
+    for (int p = 0; p < PASSES; p++)
+        if (ll_search(l, &missing, compareInt))
+            error_quit("ll_search found a missing element");
+    list = now() - start;
+
+    size_t found = 0;
+    start = now();
+    for (int p = 0; p < PASSES; p++)
+        for (found = 0; found < nodes && a[found] != missing; found++)
+            ;
+    scalar = now() - start;
+    if (found != nodes)
+        error_quit("scalar loop found a missing element");
+
+    start = now();
+    for (int p = 0; p < PASSES; p++)
+        if (simd_findInt32(a, nodes, missing) != nodes)
+            error_quit("simd_findInt32 found a missing element");
+    simd = now() - start;
+    report("find", list, scalar, simd);
+
+    // Count the elements equal to a key
+    size_t expected = 0, count = 0;
+    start = now();
+    for (int p = 0; p < PASSES; p++) {
+        expected = 0;
+        for (size_t i = 0; i < nodes; i++)
+            expected += a[i] == key;
+    }
+    scalar = now() - start;
+
+    start = now();
+    for (int p = 0; p < PASSES; p++)
+        count = simd_countInt32(a, nodes, key);
+    simd = now() - start;
+    report("count", -1, scalar, simd);
+    if (count != expected)
+        error_quit("counts differ, %zu and %zu", expected, count);
+
+    // Count the elements in a range
+    start = now();
+    for (int p = 0; p < PASSES; p++) {
+        expected = 0;
+        for (size_t i = 0; i < nodes; i++)
+            expected += a[i] >= lo && a[i] <= hi;
+    }
+    scalar = now() - start;
+
+    start = now();
+    for (int p = 0; p < PASSES; p++)
+        count = simd_countRangeInt32(a, nodes, lo, hi);
+    simd = now() - start;
+    report("count range", -1, scalar, simd);
+    if (count != expected)
+        error_quit("range counts differ, %zu and %zu", expected, count);
+
+    // Find the smallest and largest elements
+    int32_t min = 0, max = 0, smin = 0, smax = 0;
+    start = now();
+    for (int p = 0; p < PASSES && nodes; p++) {
+        smin = smax = a[0];
+        for (size_t i = 1; i < nodes; i++) {
+            if (a[i] < smin)
+                smin = a[i];
+            if (a[i] > smax)
+                smax = a[i];
+        }
+    }
+    scalar = now() - start;
+
+    start = now();
+    for (int p = 0; p < PASSES; p++)
+        simd_minMaxInt32(a, nodes, &min, &max);
+    simd = now() - start;
+    report("min/max", -1, scalar, simd);
+    if (min != smin || max != smax)
+        error_quit("min/max differ");
+
+    free(a);
+    ll_delete(l);
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * report:
+ *      Print the timings of one operation, a negative time is not measured.
+ */
+void report(const char *op, double list, double scalar, double simd)
+{
+    if (list < 0)
+        printf("%-12s %10s ", op, "-");
+    else
+        printf("%-12s %8.2fms ", op, list * 1e3);
+
+    printf("%8.2fms %8.2fms %7.2fx\n", scalar * 1e3, simd * 1e3,
+           scalar / simd);
+}
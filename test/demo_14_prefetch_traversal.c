@@ -0,0 +1,200 @@
+/** demo_14_prefetch_traversal.c - Benchmark of jump index traversal.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "lists.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 1000000   // nodes in the shuffled list
+#define LOOKUPS 10              // getNodeAt calls at random positions
+
+static unsigned long long total; // accumulated by the iterator
+
+double now(void);
+size_t randomIndex(size_t);
+void shuffle(linkedList *);
+bool sumInt(void *, displayFunction);
+void report(const char *, double, double);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    linkedList *l = ll_create(sizeof(int), NULL);
+    double start, plain, indexed;
+    int missing = -1;
+
+    if (nodes == 0)
+        error_quit("Need at least one node");
+
+    for (size_t i = 0; i < nodes; i++) {
+        int v = (int)i;
+        ll_append(l, &v);
+    }
+    shuffle(l);
+
+    printf("==== TRAVERSING A SHUFFLED LIST OF %zu NODES ====\n\n", nodes);
+
+    start = now();
+    jumpIndex *ji = ll_jumpIndex(l, 0, 0);
+    printf("jump index built in %.2fms, stride %zu, lanes %zu\n\n",
+           (now() - start) * 1e3, ji->stride, ji->lanes);
+    printf("operation            plain     indexed  speedup\n");
+
+    // Search for an element that is not there
+    start = now();
+    if (ll_search(l, &missing, compareInt))
+        error_quit("ll_search found a missing element");
+    plain = now() - start;
+
+    start = now();
+    if (ll_searchIndexed(l, ji, &missing, compareInt))
+        error_quit("ll_searchIndexed found a missing element");
+    indexed = now() - start;
+    report("search", plain, indexed);
+
+    // Sum every element, both must see the same order
+    unsigned long long sum;
+    total = 0;
+    start = now();
+    ll_foreach(l, sumInt, NULL);
+    plain = now() - start;
+    sum = total;
+
+    total = 0;
+    start = now();
+    ll_foreachIndexed(l, ji, sumInt, NULL);
+    indexed = now() - start;
+    report("foreach", plain, indexed);
+    if (sum != total)
+        error_quit("foreach sums differ, %llu and %llu", sum, total);
+
+    // Look up nodes at random positions
+    size_t positions[LOOKUPS];
+    linkedListNode *found[LOOKUPS];
+    srand(2);
+    for (int i = 0; i < LOOKUPS; i++)
+        positions[i] = randomIndex(nodes) + 1;
+
+    start = now();
+    for (int i = 0; i < LOOKUPS; i++)
+        found[i] = ll_getNodeAt(l, positions[i]);
+    plain = now() - start;
+
+    start = now();
+    for (int i = 0; i < LOOKUPS; i++)
+        if (ll_getNodeAtIndexed(l, ji, positions[i]) != found[i])
+            error_quit("getNodeAt results differ at %zu", positions[i]);
+    indexed = now() - start;
+    report("getNodeAt", plain, indexed);
+
+    ji_delete(ji);
+    ll_delete(l);
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * randomIndex:
+ *      Return a random index below `n`.
+ */
+size_t randomIndex(size_t n)
+{
+    return ((size_t)rand() * ((size_t)RAND_MAX + 1) + (size_t)rand()) % n;
+}
+
+/**
+ * shuffle:
+ *      Relink the nodes of a list in a random order, so that consecutive
+ *      nodes are scattered over the heap like those of a long lived list.
+ */
+void shuffle(linkedList *l)
+{
+    size_t n = l->logicalLength, i = 0;
+    linkedListNode **nodes = malloc(n * sizeof(linkedListNode *));
+    if (!nodes)
+        error_abort("Unable to allocate node array");
+
+    for (linkedListNode *node = l->head; node; node = node->next)
+        nodes[i++] = node;
+
+    srand(1);
+    for (i = n - 1; i > 0; i--) {
+        size_t j = randomIndex(i + 1);
+        linkedListNode *tmp = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = tmp;
+    }
+
+    for (i = 0; i + 1 < n; i++)
+        nodes[i]->next = nodes[i + 1];
+    nodes[n - 1]->next = NULL;
+    l->head = nodes[0];
+    l->tail = nodes[n - 1];
+
+    free(nodes);
+}
+
+/**
+ * sumInt:
+ *      Iterator accumulating a position weighted sum, so that visiting the
+ *      elements in a different order gives a different total.
+ */
+bool sumInt(void *data, displayFunction display)
+{
+    total = total * 31 + *(int *)data;
+    return true;
+}
+
+/**
+ * report:
+ *      Print the timings of one operation.
+ */
+void report(const char *op, double plain, double indexed)
+{
+    printf("%-12s %9.2fms %9.2fms %7.2fx\n", op, plain * 1e3, indexed * 1e3,
+           plain / indexed);
+}
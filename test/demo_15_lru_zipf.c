@@ -0,0 +1,469 @@
+/** demo_15_lru_zipf.c - Exercise the LRU cache on Zipf distributed traces.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <math.h>
+#include <time.h>
+#include "lruCache.h"
+#include "errors.h"
+
+#define DEFAULT_KEYS 1000000    // distinct keys in the traces
+#define DEFAULT_REQUESTS 2000000 // requests in each trace
+#define ZIPF_SKEW 0.99          // skew of the key popularity
+#define CAPACITY_PERCENT 1      // cache capacity as a percent of the keys
+#define SCAN_EVERY 20000        // requests between scans in the mixed trace
+#define SCAN_LENGTH 5000        // keys read once by each scan
+#define NAIVE_REQUESTS 20000    // requests replayed by the naive cache
+#define NAIVE_CAPACITY 1000     // capacity of the naive cache
+#define MAX_BYTES 100           // byte bound of the byte bounded cache
+#define CLUSTERED 40            // keys sharing a few neighbouring slots
+#define CLUSTER_SLOTS 128       // slot count the clustered keys fill
+
+static unsigned long long rng = 88172645463325252ULL; // xorshift state
+static size_t freed[CLUSTERED]; // values passed to countFree, in order
+static size_t nfreed = 0;       // number of values passed to countFree
+
+double now(void);
+double uniform(void);
+double *zipfTable(size_t, double);
+size_t zipfKey(const double *, size_t);
+void replay(const char *, lruCache *, const size_t *, size_t);
+size_t replayNaive(const size_t *, size_t, size_t);
+void countFree(void *);
+void expectFreed(const size_t *, size_t, const char *);
+void checkBytes(void);
+void checkPeek(void);
+void checkRemove(void);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_KEYS;
+    size_t requests = argc > 2 ? strtoul(argv[2], NULL, 10)
+                               : DEFAULT_REQUESTS;
+    size_t capacity = keys * CAPACITY_PERCENT / 100;
+
+    if (capacity == 0 || requests == 0)
+        error_quit("Need at least 100 keys and one request");
+
+    // Check eviction, replacement, peeking and removal before timing
+    printf("==== LRU CACHE ====\n\n");
+    checkBytes();
+    checkPeek();
+    checkRemove();
+
+    // Build a Zipf trace and the same trace with scans mixed in
+    double *cdf = zipfTable(keys, ZIPF_SKEW);
+    size_t *zipf = malloc(requests * sizeof(size_t));
+    size_t *mixed = malloc(requests * sizeof(size_t));
+    if (!zipf || !mixed)
+        error_abort("Unable to allocate traces");
+
+    size_t scanKey = keys;
+    for (size_t i = 0; i < requests; i++) {
+        zipf[i] = zipfKey(cdf, keys);
+        if (i % SCAN_EVERY < SCAN_LENGTH)
+            mixed[i] = scanKey++;  // keys outside the Zipf range
+        else
+            mixed[i] = zipf[i];
+    }
+
+    printf("\n==== LRU CACHE, %zu KEYS, %zu REQUESTS, CAPACITY %zu ====\n\n",
+           keys, requests, capacity);
+    printf("trace    cache        hit ratio  evictions     Mops/s\n");
+
+    lruCache *c = lru_create(sizeof(size_t), sizeof(size_t), capacity, 0,
+                             NULL);
+    replay("zipf", c, zipf, requests);
+    lru_delete(c);
+
+    c = lru_createSegmented(sizeof(size_t), sizeof(size_t), capacity, 0,
+                            NULL);
+    replay("zipf", c, zipf, requests);
+    lru_delete(c);
+
+    c = lru_create(sizeof(size_t), sizeof(size_t), capacity, 0, NULL);
+    replay("scan", c, mixed, requests);
+    lru_delete(c);
+
+    c = lru_createSegmented(sizeof(size_t), sizeof(size_t), capacity, 0,
+                            NULL);
+    replay("scan", c, mixed, requests);
+    lru_delete(c);
+
+    // Compare with a cache that searches and relinks a plain list
+    size_t n = requests < NAIVE_REQUESTS ? requests : NAIVE_REQUESTS;
+    double start = now();
+    size_t naiveHits = replayNaive(zipf, n, NAIVE_CAPACITY);
+    double naive = now() - start;
+
+    c = lru_create(sizeof(size_t), sizeof(size_t), NAIVE_CAPACITY, 0, NULL);
+    start = now();
+    for (size_t i = 0; i < n; i++)
+        if (!lru_get(c, &zipf[i]))
+            lru_put(c, &zipf[i], &zipf[i], sizeof(size_t));
+    double cached = now() - start;
+
+    if (c->hits != naiveHits)
+        error_quit("Naive cache hits %zu, lruCache hits %zu", naiveHits,
+                   c->hits);
+    printf("\n%zu requests, capacity %d: dll_search cache %.2fms, "
+           "lruCache %.2fms\n", n, NAIVE_CAPACITY, naive * 1e3,
+           cached * 1e3);
+    lru_delete(c);
+
+    free(mixed);
+    free(zipf);
+    free(cdf);
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * uniform:
+ *      Return a deterministic pseudo random number in [0, 1).
+ */
+double uniform(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+
+    return (rng >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * zipfTable:
+ *      Return the cumulative distribution of `n` keys whose popularity
+ *      falls off as 1 / rank^skew.
+ */
+double *zipfTable(size_t n, double skew)
+{
+    double *cdf = malloc(n * sizeof(double));
+    if (!cdf)
+        error_abort("Unable to allocate Zipf table");
+
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+        cdf[i] = sum += 1.0 / pow((double)(i + 1), skew);
+    for (size_t i = 0; i < n; i++)
+        cdf[i] /= sum;
+
+    return cdf;
+}
+
+/**
+ * zipfKey:
+ *      Return a key drawn from a Zipf cumulative distribution.
+ */
+size_t zipfKey(const double *cdf, size_t n)
+{
+    double u = uniform();
+    size_t lo = 0, hi = n - 1;
+
+    // Find the first key whose cumulative probability reaches u
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cdf[mid] < u)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * replay:
+ *      Read every key of a trace through a cache, putting the keys it
+ *      misses, then check the counters and print the results.
+ */
+void replay(const char *name, lruCache *c, const size_t *trace, size_t n)
+{
+    double start = now();
+    for (size_t i = 0; i < n; i++) {
+        size_t *v = lru_get(c, &trace[i]);
+        if (!v)
+            lru_put(c, &trace[i], &trace[i], sizeof(size_t));
+        else if (*v != trace[i])
+            error_quit("Key %zu cached with value %zu", trace[i], *v);
+    }
+    double elapsed = now() - start;
+
+    if (c->hits + c->misses != n)
+        error_quit("%zu hits and %zu misses for %zu requests", c->hits,
+                   c->misses, n);
+    if (lru_length(c) > c->maxEntries)
+        error_quit("Cache holds %zu entries, more than %zu",
+                   lru_length(c), c->maxEntries);
+
+    printf("%-8s %-12s %9.2f%% %10zu %10.2f\n", name,
+           c->protectedList ? "segmented" : "lru",
+           100.0 * c->hits / n, c->evictions, n / elapsed / 1e6);
+}
+
+/**
+ * replayNaive:
+ *      Replay a trace through an LRU cache that keeps its keys in a plain
+ *      dLinkedList, searching it on every request.
+ *      Returns the number of hits.
+ */
+size_t replayNaive(const size_t *trace, size_t n, size_t capacity)
+{
+    dLinkedList *l = dll_create(sizeof(int), NULL);
+    size_t hits = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        int key = (int)trace[i];
+
+        if (dll_search(l, &key, compareInt)) {
+            hits++;
+            dll_deleteNode(l, &key, compareInt);
+        } else if (l->logicalLength == capacity) {
+            int last;
+            dll_tail(l, &last);
+            dll_deleteNode(l, &last, compareInt);
+        }
+
+        dll_push(l, &key);
+    }
+
+    dll_delete(l);
+
+    return hits;
+}
+
+/**
+ * countFree:
+ *      Free function recording the size_t values passed to it.
+ */
+void countFree(void *value)
+{
+    if (nfreed == CLUSTERED)
+        error_quit("More than %d values freed", CLUSTERED);
+
+    freed[nfreed++] = *(size_t *)value;
+}
+
+/**
+ * expectFreed:
+ *      Quit unless exactly the given values were freed, in order, since
+ *      the last call.
+ */
+void expectFreed(const size_t *values, size_t n, const char *what)
+{
+    if (nfreed != n)
+        error_quit("%s freed %zu values instead of %zu", what, nfreed, n);
+
+    for (size_t i = 0; i < n; i++)
+        if (freed[i] != values[i])
+            error_quit("%s freed value %zu instead of %zu", what, freed[i],
+                       values[i]);
+
+    nfreed = 0;
+}
+
+/**
+ * checkBytes:
+ *      Check that a byte bounded cache evicts least recently used entries
+ *      until it is within its bound, and frees evicted and replaced values.
+ */
+void checkBytes(void)
+{
+    lruCache *c = lru_create(sizeof(size_t), sizeof(size_t), 0, MAX_BYTES,
+                             countFree);
+    size_t key, value;
+
+    // Ten entries of 10 bytes fill the cache exactly
+    for (key = 0; key < 10; key++)
+        lru_put(c, &key, &key, 10);
+    if (c->evictions || lru_bytes(c) != MAX_BYTES || lru_length(c) != 10)
+        error_quit("Cache evicted before reaching %d bytes", MAX_BYTES);
+    expectFreed(NULL, 0, "Filling the cache");
+
+    // Using key 0 saves it, 25 more bytes evict the next three
+    key = 0;
+    lru_get(c, &key);
+    key = 10;
+    lru_put(c, &key, &key, 25);
+    const size_t evicted[] = { 1, 2, 3 };
+    expectFreed(evicted, 3, "Exceeding maxBytes");
+    if (c->evictions != 3 || lru_bytes(c) != 95 || lru_length(c) != 8)
+        error_quit("maxBytes eviction left %zu bytes", lru_bytes(c));
+    for (key = 0; key <= 10; key++)
+        if (!lru_peek(c, &key) != (key >= 1 && key <= 3))
+            error_quit("Key %zu wrongly kept or evicted", key);
+
+    // Replacing frees the old value and recharges the entry
+    key = 0;
+    value = 1000;
+    lru_put(c, &key, &value, 5);
+    expectFreed(&key, 1, "Replacing a value");
+    if (*(size_t *)lru_peek(c, &key) != 1000 || lru_bytes(c) != 90)
+        error_quit("Replacing did not update the value and bytes");
+
+    // A larger charge on replacement evicts from the least recent end
+    key = 4;
+    value = 2000;
+    lru_put(c, &key, &value, 30);
+    const size_t replaced[] = { 4, 5 };
+    expectFreed(replaced, 2, "Replacing with a larger charge");
+    if (lru_bytes(c) != 100 || !lru_peek(c, &key) || c->evictions != 4)
+        error_quit("Replacing with a larger charge left %zu bytes",
+                   lru_bytes(c));
+
+    // Removing frees the value, a missing key frees nothing
+    key = 10;
+    if (!lru_remove(c, &key) || lru_remove(c, &key) || lru_peek(c, &key))
+        error_quit("lru_remove of key 10 failed");
+    expectFreed(&key, 1, "lru_remove");
+    if (lru_bytes(c) != 75 || c->evictions != 4)
+        error_quit("lru_remove left %zu bytes", lru_bytes(c));
+
+    // Deleting frees every value left
+    size_t left = lru_length(c);
+    lru_delete(c);
+    if (nfreed != left)
+        error_quit("lru_delete freed %zu of %zu values", nfreed, left);
+    nfreed = 0;
+
+    printf("maxBytes evicts least recently used entries and frees values\n");
+}
+
+/**
+ * checkPeek:
+ *      Check that lru_peek neither counts a hit or miss nor saves an entry
+ *      from eviction, where lru_get does.
+ */
+void checkPeek(void)
+{
+    lruCache *c = lru_create(sizeof(size_t), sizeof(size_t), 3, 0,
+                             countFree);
+    size_t key;
+
+    for (key = 0; key < 3; key++)
+        lru_put(c, &key, &key, sizeof(size_t));
+
+    // Peeking at the least recent key leaves it to be evicted next
+    key = 0;
+    if (!lru_peek(c, &key) || *(size_t *)lru_peek(c, &key) != 0)
+        error_quit("lru_peek did not find key 0");
+    key = 99;
+    if (lru_peek(c, &key))
+        error_quit("lru_peek found a missing key");
+    if (c->hits || c->misses)
+        error_quit("lru_peek counted %zu hits, %zu misses", c->hits,
+                   c->misses);
+    key = 3;
+    lru_put(c, &key, &key, sizeof(size_t));
+    key = 0;
+    if (lru_peek(c, &key))
+        error_quit("lru_peek saved key 0 from eviction");
+    expectFreed(&key, 1, "Evicting a peeked key");
+
+    // Getting the least recent key saves it
+    key = 1;
+    if (!lru_get(c, &key) || c->hits != 1)
+        error_quit("lru_get did not find key 1");
+    key = 4;
+    lru_put(c, &key, &key, sizeof(size_t));
+    key = 2;
+    expectFreed(&key, 1, "Evicting after lru_get");
+
+    lru_delete(c);
+    nfreed = 0;
+
+    printf("lru_peek leaves stats and recency alone\n");
+}
+
+/**
+ * checkRemove:
+ *      Remove, in a scrambled order, keys whose home slots are a few
+ *      neighbouring slots wrapping around the end of the table, checking
+ *      after each removal that every other key is still found.
+ */
+void checkRemove(void)
+{
+    lruCache *c = lru_create(sizeof(size_t), sizeof(size_t), 0, 0,
+                             countFree);
+    size_t keys[CLUSTERED], n = 0;
+
+    // Pick keys homed in the last two and first two slots
+    for (size_t key = 0; n < CLUSTERED; key++) {
+        size_t home = hash_fnv1a(&key, sizeof(size_t)) % CLUSTER_SLOTS;
+        if (home >= CLUSTER_SLOTS - 2 || home < 2)
+            keys[n++] = key;
+    }
+
+    for (size_t i = 0; i < CLUSTERED; i++)
+        lru_put(c, &keys[i], &keys[i], sizeof(size_t));
+    if (c->slotCount != CLUSTER_SLOTS)
+        error_quit("Clustered keys fill %zu slots, not %d", c->slotCount,
+                   CLUSTER_SLOTS);
+
+    // Remove every seventh key round the array, which visits them all
+    for (size_t removed = 0, i = 0; removed < CLUSTERED; removed++) {
+        i = (i + 7) % CLUSTERED;
+        if (!lru_remove(c, &keys[i]) || lru_remove(c, &keys[i]))
+            error_quit("lru_remove of key %zu failed", keys[i]);
+        expectFreed(&keys[i], 1, "lru_remove");
+        keys[i] = SIZE_MAX;
+
+        for (size_t j = 0; j < CLUSTERED; j++) {
+            size_t *v = keys[j] == SIZE_MAX ? NULL : lru_peek(c, &keys[j]);
+            if (keys[j] != SIZE_MAX && (!v || *v != keys[j]))
+                error_quit("Key %zu lost after removing %zu keys", keys[j],
+                           removed + 1);
+        }
+
+        if (lru_length(c) != CLUSTERED - removed - 1)
+            error_quit("Cache holds %zu entries", lru_length(c));
+    }
+
+    if (c->evictions)
+        error_quit("lru_remove counted evictions");
+    lru_delete(c);
+
+    printf("lru_remove keeps clustered keys reachable\n");
+}
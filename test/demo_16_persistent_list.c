@@ -0,0 +1,260 @@
+/** demo_16_persistent_list.c - Versioned configuration on a persistent list.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "persistentList.h"
+#include "errors.h"
+
+#define DEFAULT_ENTRIES 100000  // settings in the configuration
+#define VERSIONS 1000           // updates, each kept as a version
+#define HOT_ENTRIES 4           // updates only touch the first settings
+#define ROUNDS 100000           // updates dropping superseded versions
+
+static size_t live;             // owned elements not yet freed
+
+// A configuration setting
+typedef struct setting {
+    int key;                    // setting identifier
+    int value;                  // current value
+} setting;
+
+double now(void);
+linkedList *deepCopy(linkedList *);
+long checksum(persistentList *);
+persistentList *ownedPush(persistentList *, int);
+void freeOwned(void *);
+result compareOwned(const void *, const void *);
+void checkReclaimed(void);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t entries = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_ENTRIES;
+    persistentList **versions = malloc(VERSIONS * sizeof(persistentList *));
+    long *sums = malloc(VERSIONS * sizeof(long));
+    double start, persistent, copied;
+
+    if (entries < HOT_ENTRIES)
+        error_quit("Need at least %d entries", HOT_ENTRIES);
+    if (!versions || !sums)
+        error_abort("Unable to allocate versions");
+
+    // Build the first version back to front
+    persistentList *config = pl_create(sizeof(setting), NULL);
+    for (size_t i = entries; i > 0; i--) {
+        setting s = { (int)i, 0 };
+        persistentList *next = pl_push(config, &s);
+        pl_delete(config);
+        config = next;
+    }
+
+    printf("==== %d VERSIONS OF A %zu ENTRY CONFIGURATION ====\n\n",
+           VERSIONS, entries);
+
+    // Update a hot setting and keep every version
+    start = now();
+    for (int v = 0; v < VERSIONS; v++) {
+        size_t index = v % HOT_ENTRIES + 1;
+        setting s = { (int)index, v };
+        persistentList *next = pl_set(config, index, &s);
+        pl_delete(config);
+        config = next;
+        versions[v] = pl_snapshot(config);
+    }
+    persistent = now() - start;
+
+    // Every version must still hold the values it was given
+    for (int v = 0; v < VERSIONS; v++) {
+        setting *s = pl_getNodeAt(versions[v], v % HOT_ENTRIES + 1)->data;
+        if (s->value != v)
+            error_quit("Version %d changed to %d", v, s->value);
+        sums[v] = checksum(versions[v]);
+    }
+    for (int v = HOT_ENTRIES; v < VERSIONS; v++)
+        if (sums[v] - sums[v - 1] != HOT_ENTRIES)
+            error_quit("Version %d does not differ by one update", v);
+
+    // The same with a copy of a linkedList for every version
+    linkedList *l = ll_create(sizeof(setting), NULL);
+    for (size_t i = 1; i <= entries; i++) {
+        setting s = { (int)i, 0 };
+        ll_append(l, &s);
+    }
+
+    int copies = VERSIONS / 10;
+    start = now();
+    for (int v = 0; v < copies; v++) {
+        setting *s = ll_getNodeAt(l, v % HOT_ENTRIES + 1)->data;
+        s->value = v;
+        ll_delete(deepCopy(l));
+    }
+    copied = (now() - start) / copies * VERSIONS;
+
+    printf("pl_set and pl_snapshot   %10.2fms\n", persistent * 1e3);
+    printf("ll_append copies         %10.2fms (from %d copies)\n",
+           copied * 1e3, copies);
+    printf("speedup                  %10.2fx\n", copied / persistent);
+
+    ll_delete(l);
+    for (int v = 0; v < VERSIONS; v++)
+        pl_delete(versions[v]);
+    pl_delete(config);
+    free(versions);
+    free(sums);
+
+    checkReclaimed();
+
+    return 0;
+}
+
+/**
+ * checkReclaimed:
+ *      Update a list of owned elements, deleting each superseded version,
+ *      and check that replaced and removed elements are freed at once.
+ */
+void checkReclaimed(void)
+{
+    persistentList *v = pl_create(sizeof(int *), freeOwned);
+    for (int i = 3; i > 0; i--)
+        v = ownedPush(v, i);
+
+    // Removing the tail must free it as soon as the old version goes
+    int three = 3, *key = &three;
+    persistentList *w = pl_deleteNode(v, &key, compareOwned);
+    pl_delete(v);
+    if (live != 2)
+        error_quit("pl_deleteNode left %zu elements for 2 nodes", live);
+
+    // Each round pushes one element and replaces the third
+    for (int i = 0; i < ROUNDS; i++) {
+        w = ownedPush(w, i);
+
+        int *el = malloc(sizeof(int));
+        if (!el)
+            error_abort("Unable to allocate element");
+        *el = -i;
+        live++;
+
+        persistentList *next = pl_set(w, 3, &el);
+        pl_delete(w);
+        w = next;
+
+        if (live != pl_length(w))
+            error_quit("%zu elements live for %zu nodes after round %d",
+                       live, pl_length(w), i);
+    }
+
+    printf("\n%d updates dropping old versions, %zu elements live\n",
+           ROUNDS, live);
+    pl_delete(w);
+    if (live)
+        error_quit("%zu elements left after deleting the list", live);
+}
+
+/**
+ * ownedPush:
+ *      Push an allocated copy of `value` and delete the old version.
+ *      Returns the new version.
+ */
+persistentList *ownedPush(persistentList *l, int value)
+{
+    int *el = malloc(sizeof(int));
+    if (!el)
+        error_abort("Unable to allocate element");
+    *el = value;
+    live++;
+
+    persistentList *next = pl_push(l, &el);
+    pl_delete(l);
+
+    return next;
+}
+
+/**
+ * freeOwned:
+ *      Free function counting the owned elements freed.
+ */
+void freeOwned(void *data)
+{
+    free(*(int **)data);
+    live--;
+}
+
+/**
+ * compareOwned:
+ *      Compare the integers two owned elements point to.
+ */
+result compareOwned(const void *a, const void *b)
+{
+    return compareInt(*(int *const *)a, *(int *const *)b);
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * deepCopy:
+ *      Return a copy of a list built by appending every element.
+ */
+linkedList *deepCopy(linkedList *l)
+{
+    linkedList *copy = ll_create(l->elementSize, NULL);
+
+    for (linkedListNode *node = l->head; node; node = node->next)
+        ll_append(copy, node->data);
+
+    return copy;
+}
+
+/**
+ * checksum:
+ *      Return the sum of the values of a configuration.
+ */
+long checksum(persistentList *l)
+{
+    long sum = 0;
+
+    for (persistentListNode *node = pl_first(l); node; node = node->next)
+        sum += ((setting *)node->data)->value;
+
+    return sum;
+}
@@ -0,0 +1,148 @@
+/** demo_17_clone.c - Benchmark of list cloning.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include "persistentList.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 1000000   // nodes in the lists cloned
+#define STRINGS 100000          // nodes in the list of strings
+
+double now(void);
+linkedList *appendCopy(linkedList *);
+void report(const char *, double, double);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    linkedList *l = ll_create(sizeof(int), NULL);
+    double start, appended;
+
+    for (size_t i = 0; i < nodes; i++) {
+        int v = (int)i;
+        ll_append(l, &v);
+    }
+
+    printf("==== CLONING A LIST OF %zu NODES ====\n\n", nodes);
+    printf("operation            time     speedup\n");
+
+    start = now();
+    linkedList *a = appendCopy(l);
+    appended = now() - start;
+    report("ll_append", appended, appended);
+
+    start = now();
+    linkedList *c = ll_clone(l, NULL);
+    report("ll_clone", appended, now() - start);
+
+    start = now();
+    persistentList *p = pl_fromList(l, NULL);
+    persistentList *snap = pl_snapshot(p);
+    report("pl_fromList", appended, now() - start);
+
+    // Every copy must hold the same elements
+    linkedListNode *x = a->head, *y = c->head;
+    persistentListNode *z = pl_first(snap);
+    for (; x; x = x->next, y = y->next, z = z->next)
+        if (*(int *)x->data != *(int *)y->data ||
+            *(int *)x->data != *(int *)z->data)
+            error_quit("Copies differ at %d", *(int *)x->data);
+    if (y || z || c->tail->next || c->logicalLength != nodes)
+        error_quit("Clone has the wrong length");
+
+    pl_delete(snap);
+    pl_delete(p);
+    ll_delete(c);
+    ll_delete(a);
+    ll_delete(l);
+
+    // Clone a list of strings, the clone must own its own strings
+    linkedList *strs = ll_create(sizeof(char *), freeString);
+    for (int i = 0; i < STRINGS; i++) {
+        char buf[32], *s;
+        snprintf(buf, sizeof(buf), "string %d", i);
+        if (!(s = strdup(buf)))
+            error_abort("Unable to allocate string");
+        ll_append(strs, &s);
+    }
+
+    linkedList *clone = ll_clone(strs, copyString);
+    for (x = strs->head, y = clone->head; x; x = x->next, y = y->next)
+        if (*(char **)x->data == *(char **)y->data ||
+            strcmp(*(char **)x->data, *(char **)y->data))
+            error_quit("String clone shares or differs from the original");
+
+    ll_delete(strs);
+    printf("\ncloned %d strings with copyString, first is \"%s\"\n",
+           STRINGS, *(char **)clone->head->data);
+    ll_delete(clone);
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * appendCopy:
+ *      Return a copy of a list built by appending every element.
+ */
+linkedList *appendCopy(linkedList *l)
+{
+    linkedList *copy = ll_create(l->elementSize, NULL);
+
+    for (linkedListNode *node = l->head; node; node = node->next)
+        ll_append(copy, node->data);
+
+    return copy;
+}
+
+/**
+ * report:
+ *      Print the time of one way of copying.
+ */
+void report(const char *op, double appended, double elapsed)
+{
+    printf("%-12s %9.2fms %9.2fx\n", op, elapsed * 1e3, appended / elapsed);
+}
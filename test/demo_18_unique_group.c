@@ -0,0 +1,173 @@
+/** demo_18_unique_group.c - Benchmark of hash based unique and groupBy.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "lists.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 1000000   // nodes in the list deduplicated
+#define DISTINCT 10             // nodes per distinct value on average
+#define NAIVE_NODES 20000       // nodes deduplicated by the naive loop
+
+double now(void);
+linkedList *randomList(size_t, int);
+size_t naiveUnique(linkedList *);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    int distinct = (int)(nodes / DISTINCT) + 1;
+    double start, naive, hashed;
+
+    printf("==== DEDUPLICATING %zu NODES ====\n\n", nodes);
+
+    // Compare with a search loop on a list small enough for it
+    size_t small = nodes < NAIVE_NODES ? nodes : NAIVE_NODES;
+    linkedList *a = randomList(small, (int)(small / DISTINCT) + 1);
+    linkedList *b = ll_clone(a, NULL);
+
+    start = now();
+    size_t naiveRemoved = naiveUnique(a);
+    naive = now() - start;
+
+    start = now();
+    size_t removed = ll_unique(b, hashInt, compareInt);
+    hashed = now() - start;
+
+    if (removed != naiveRemoved || a->logicalLength != b->logicalLength)
+        error_quit("ll_unique removed %zu nodes, the search loop %zu",
+                   removed, naiveRemoved);
+    for (linkedListNode *x = a->head, *y = b->head; x; x = x->next,
+         y = y->next)
+        if (*(int *)x->data != *(int *)y->data)
+            error_quit("ll_unique kept a different order");
+
+    printf("%zu nodes: search loop %.2fms, ll_unique %.2fms, %.0fx\n",
+           small, naive * 1e3, hashed * 1e3, naive / hashed);
+    ll_delete(a);
+    ll_delete(b);
+
+    // The full list, then group a copy of it
+    linkedList *l = randomList(nodes, distinct);
+    linkedList *copy = ll_clone(l, NULL);
+
+    start = now();
+    removed = ll_unique(l, hashInt, compareInt);
+    printf("%zu nodes: ll_unique %.2fms, %zu distinct\n", nodes,
+           (now() - start) * 1e3, l->logicalLength);
+
+    start = now();
+    linkedList *groups = ll_groupBy(copy, hashInt, compareInt);
+    printf("%zu nodes: ll_groupBy %.2fms, %zu groups\n", nodes,
+           (now() - start) * 1e3, groups->logicalLength);
+
+    // Groups follow the order of first occurrence
+    size_t grouped = 0;
+    linkedListNode *first = l->head;
+    for (linkedListNode *n = groups->head; n; n = n->next) {
+        linkedList *g = *(linkedList **)n->data;
+        if (compareInt(g->head->data, first->data) != EQUAL)
+            error_quit("Groups are out of order");
+        grouped += g->logicalLength;
+        first = first->next;
+    }
+    if (grouped != nodes || groups->logicalLength != l->logicalLength)
+        error_quit("Groups hold %zu nodes", grouped);
+
+    ll_delete(groups);
+    ll_delete(copy);
+    ll_delete(l);
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * randomList:
+ *      Return a list of `n` random integers below `range`.
+ */
+linkedList *randomList(size_t n, int range)
+{
+    linkedList *l = ll_create(sizeof(int), NULL);
+
+    srand(1);
+    for (size_t i = 0; i < n; i++) {
+        int v = rand() % range;
+        ll_append(l, &v);
+    }
+
+    return l;
+}
+
+/**
+ * naiveUnique:
+ *      Remove duplicates by searching the nodes kept for every node.
+ *      Returns the number of nodes removed.
+ */
+size_t naiveUnique(linkedList *l)
+{
+    linkedList *kept = ll_create(l->elementSize, NULL);
+    size_t removed = 0;
+
+    for (linkedListNode *n = l->head; n; n = n->next) {
+        if (ll_search(kept, n->data, compareInt))
+            removed++;
+        else
+            ll_append(kept, n->data);
+    }
+
+    // Swap the kept nodes into the list
+    linkedListNode *head = l->head, *tail = l->tail;
+    size_t length = l->logicalLength;
+    l->head = kept->head;
+    l->tail = kept->tail;
+    l->logicalLength = kept->logicalLength;
+    kept->head = head;
+    kept->tail = tail;
+    kept->logicalLength = length;
+    ll_delete(kept);
+
+    return removed;
+}
@@ -0,0 +1,170 @@
+/** demo_20_merge_k.c - Benchmark of k-way merging of sorted lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include "lists.h"
+#include "errors.h"
+
+#define DEFAULT_NODES 1000000   // nodes over all the shards
+#define MAX_SHARDS 1024         // largest number of shards merged
+#define MAX_FOLDED 32           // largest number of shards merged in pairs
+
+double now(void);
+dLinkedList **shards(size_t, size_t);
+dLinkedList *fold(dLinkedList **, size_t);
+void check(dLinkedList *, size_t);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t nodes = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    double start;
+
+    printf("==== MERGING %zu NODES FROM K SORTED SHARDS ====\n\n", nodes);
+    printf("   k   dll_mergeK  pairwise fold   speedup\n");
+
+    for (size_t k = 2; k <= MAX_SHARDS; k *= 2) {
+        dLinkedList **lists = shards(nodes, k);
+
+        start = now();
+        dLinkedList *merged = dll_mergeK(lists, k, compareInt);
+        double heap = now() - start;
+        check(merged, nodes);
+        dll_delete(merged);
+
+        for (size_t i = 0; i < k; i++)
+            dll_delete(lists[i]);
+        free(lists);
+
+        if (k > MAX_FOLDED) {
+            printf("%4zu %10.2fms %14s\n", k, heap * 1e3, "-");
+            continue;
+        }
+
+        // Merge the same shards one after another
+        lists = shards(nodes, k);
+        start = now();
+        merged = fold(lists, k);
+        double folded = now() - start;
+        check(merged, nodes);
+        dll_delete(merged);
+        free(lists);
+
+        printf("%4zu %10.2fms %12.2fms %8.2fx\n", k, heap * 1e3,
+               folded * 1e3, folded / heap);
+    }
+
+    return 0;
+}
+
+/**
+ * now:
+ *      Return the monotonic time in seconds.
+ */
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * shards:
+ *      Return `k` sorted lists sharing `n` random integers between them.
+ */
+dLinkedList **shards(size_t n, size_t k)
+{
+    dLinkedList **lists = malloc(k * sizeof(dLinkedList *));
+    int *last = calloc(k, sizeof(int));
+    if (!lists || !last)
+        error_abort("Unable to allocate shards");
+
+    for (size_t i = 0; i < k; i++)
+        lists[i] = dll_create(sizeof(int), NULL);
+
+    // Every shard grows by random steps so it stays sorted
+    srand(1);
+    for (size_t j = 0; j < n; j++) {
+        size_t i = j % k;
+        last[i] += rand() % (int)(2 * k);
+        dll_append(lists[i], &last[i]);
+    }
+
+    free(last);
+
+    return lists;
+}
+
+/**
+ * fold:
+ *      Merge `k` lists by merging each in turn into the result so far,
+ *      deleting the lists.
+ */
+dLinkedList *fold(dLinkedList **lists, size_t k)
+{
+    dLinkedList *acc = lists[0];
+
+    for (size_t i = 1; i < k; i++) {
+        dLinkedList *pair[2] = { acc, lists[i] };
+        dLinkedList *merged = dll_mergeK(pair, 2, compareInt);
+        dll_delete(acc);
+        dll_delete(lists[i]);
+        acc = merged;
+    }
+
+    return acc;
+}
+
+/**
+ * check:
+ *      Quit unless a list holds `n` nodes in sorted order, linked both
+ *      ways.
+ */
+void check(dLinkedList *l, size_t n)
+{
+    dLinkedListNode *prev = NULL;
+    size_t count = 0;
+
+    for (dLinkedListNode *node = l->head; node; node = node->next) {
+        if (node->prev != prev)
+            error_quit("Merged node %zu has a wrong prev link", count);
+        if (prev && compareInt(prev->data, node->data) == GREATER)
+            error_quit("Merged list is out of order at node %zu", count);
+        prev = node;
+        count++;
+    }
+
+    if (count != n || l->logicalLength != n || l->tail != prev)
+        error_quit("Merged list has %zu nodes, expected %zu", count, n);
+}
@@ -0,0 +1,115 @@
+/** demo_21_async_delete.c - Exercise asynchronous list deletion.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include "lists.h"
+#include "errors.h"
+
+#define LISTS 64                // lists deleted asynchronously per round
+#define NODES 10000             // nodes in each list
+#define SMALL_LIMIT 4096        // reclaim limit forcing synchronous frees
+
+static atomic_size_t freed;     // elements freed, on any thread
+
+void freeCounted(void *);
+size_t deleteLists(size_t);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    printf("==== ASYNCHRONOUS DELETION ====\n\n");
+
+    // Every element is freed once reclaim_flush returns
+    reclaim_setThreads(4);
+    size_t expected = deleteLists(LISTS);
+    reclaim_flush();
+    if (atomic_load(&freed) != expected || reclaim_pending())
+        error_quit("Flushed %zu of %zu elements, %zu bytes pending",
+                   atomic_load(&freed), expected, reclaim_pending());
+    printf("ll/dll_deleteAsync freed %zu elements by reclaim_flush\n",
+           expected);
+
+    // Over the limit a deletion frees its nodes before it returns
+    reclaim_setLimit(SMALL_LIMIT);
+    expected += deleteLists(1);
+    if (atomic_load(&freed) != expected || reclaim_pending())
+        error_quit("Deletions over the limit were not synchronous");
+    printf("deletions over a %d byte limit freed synchronously\n",
+           SMALL_LIMIT);
+    reclaim_setLimit(0);
+
+    // Shut down with work queued, then start again
+    for (int round = 0; round < 3; round++) {
+        expected += deleteLists(LISTS);
+        reclaim_shutdown();
+        if (atomic_load(&freed) != expected || reclaim_pending())
+            error_quit("reclaim_shutdown left %zu elements unfreed",
+                       expected - atomic_load(&freed));
+    }
+    printf("reclaim_shutdown freed everything queued, 3 restarts\n");
+
+    return 0;
+}
+
+/**
+ * freeCounted:
+ *      Free function counting the elements freed.
+ */
+void freeCounted(void *data)
+{
+    atomic_fetch_add(&freed, 1);
+}
+
+/**
+ * deleteLists:
+ *      Build and asynchronously delete `n` singly and `n` doubly linked
+ *      lists.
+ *      Returns the number of elements deleted.
+ */
+size_t deleteLists(size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        linkedList *l = ll_create(sizeof(int), freeCounted);
+        dLinkedList *d = dll_create(sizeof(int), freeCounted);
+
+        for (int v = 0; v < NODES; v++) {
+            ll_append(l, &v);
+            dll_append(d, &v);
+        }
+
+        ll_deleteAsync(l);
+        dll_deleteAsync(d);
+    }
+
+    return 2 * n * NODES;
+}
@@ -0,0 +1,215 @@
+/** demo_22_node_cache.c - Exercise the node allocator across threads.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include "nodeCache.h"
+#include "errors.h"
+
+#define THREADS 4               // threads exchanging blocks
+#define BLOCKS 20000            // blocks allocated per thread per round
+#define ROUNDS 5                // rounds of the exchange
+#define RUNS 8                  // runs mixed with cached blocks
+#define RUN_BLOCKS 1000         // blocks in each run
+#define MIXED_SIZE 64           // size of run and cached blocks mixed
+#define MIXED (RUNS * RUN_BLOCKS * 2) // run and cached blocks mixed
+
+// Blocks allocated by one thread for another to free
+typedef struct exchange {
+    void *blocks[BLOCKS];       // blocks allocated
+    size_t sizes[BLOCKS];       // their sizes
+} exchange;
+
+static exchange boxes[THREADS];
+static pthread_barrier_t barrier;
+static void *mixed[MIXED];      // run and cached blocks freed by two threads
+
+void fill(void *, size_t, size_t);
+void checkFree(void *, size_t, size_t);
+size_t blockSize(size_t);
+void *exchanger(void *);
+void *allocator(void *);
+void *runFreer(void *);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    pthread_t threads[THREADS];
+
+    printf("==== NODE ALLOCATOR ====\n\n");
+
+    // Every thread frees the blocks its neighbour allocated
+    pthread_barrier_init(&barrier, NULL, THREADS);
+    for (size_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, exchanger, (void *)i);
+    for (size_t i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+    pthread_barrier_destroy(&barrier);
+    printf("%d threads freed %d of each other's blocks\n", THREADS,
+           THREADS * BLOCKS * ROUNDS);
+
+    // Free blocks after the thread that allocated them has exited, then
+    // let a new thread adopt the orphaned cache
+    for (int round = 0; round < 2; round++) {
+        pthread_create(&threads[0], NULL, allocator, &boxes[0]);
+        pthread_join(threads[0], NULL);
+        for (size_t i = 0; i < BLOCKS; i++)
+            checkFree(boxes[0].blocks[i], boxes[0].sizes[i], i);
+        nc_flush();
+    }
+    printf("freed %d blocks of exited threads twice\n", BLOCKS);
+
+    // Mix blocks of runs with cached blocks and free them on two threads
+    size_t n = 0, stride;
+    for (size_t r = 0; r < RUNS; r++) {
+        char *run = nc_allocRun(MIXED_SIZE, RUN_BLOCKS, &stride);
+        if (stride < MIXED_SIZE)
+            error_quit("Run stride %zu below size %zu", stride, MIXED_SIZE);
+
+        for (size_t i = 0; i < RUN_BLOCKS; i++) {
+            mixed[n] = run + i * stride;
+            fill(mixed[n], MIXED_SIZE, n);
+            n++;
+            mixed[n] = nc_alloc(MIXED_SIZE, true);
+            fill(mixed[n], MIXED_SIZE, n);
+            n++;
+        }
+    }
+
+    pthread_create(&threads[0], NULL, runFreer, (void *)0);
+    pthread_create(&threads[1], NULL, runFreer, (void *)1);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    printf("freed %zu run and cached blocks on two threads\n", n);
+
+    return 0;
+}
+
+/**
+ * blockSize:
+ *      Return the size of the ith block, covering several size classes.
+ */
+size_t blockSize(size_t i)
+{
+    static const size_t sizes[] = { 16, 40, 64, 100, 256, 520 };
+
+    return sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+}
+
+/**
+ * fill:
+ *      Write a pattern identifying block `tag` over a whole block.
+ */
+void fill(void *p, size_t size, size_t tag)
+{
+    memset(p, (int)(tag & 0xff), size);
+    memcpy(p, &tag, sizeof(tag));
+}
+
+/**
+ * checkFree:
+ *      Quit unless a block still holds its pattern, then free it.
+ */
+void checkFree(void *p, size_t size, size_t tag)
+{
+    const unsigned char *c = p;
+    size_t stored;
+
+    memcpy(&stored, p, sizeof(stored));
+    if (stored != tag)
+        error_quit("Block %zu was overwritten by block %zu", tag, stored);
+    for (size_t i = sizeof(tag); i < size; i++)
+        if (c[i] != (tag & 0xff))
+            error_quit("Block %zu was overwritten at byte %zu", tag, i);
+
+    nc_free(p);
+}
+
+/**
+ * exchanger:
+ *      Allocate blocks for the next thread and free those of the previous.
+ */
+void *exchanger(void *arg)
+{
+    size_t self = (size_t)arg, prev = (self + THREADS - 1) % THREADS;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < BLOCKS; i++) {
+            size_t size = blockSize(i + self);
+            boxes[self].blocks[i] = nc_alloc(size, true);
+            boxes[self].sizes[i] = size;
+            fill(boxes[self].blocks[i], size, i);
+        }
+
+        pthread_barrier_wait(&barrier);
+        for (size_t i = 0; i < BLOCKS; i++)
+            checkFree(boxes[prev].blocks[i], boxes[prev].sizes[i], i);
+        nc_flush();
+        pthread_barrier_wait(&barrier);
+    }
+
+    return NULL;
+}
+
+/**
+ * allocator:
+ *      Allocate a box of blocks and exit, leaving them to be freed.
+ */
+void *allocator(void *arg)
+{
+    exchange *box = arg;
+
+    for (size_t i = 0; i < BLOCKS; i++) {
+        box->sizes[i] = blockSize(i);
+        box->blocks[i] = nc_alloc(box->sizes[i], true);
+        fill(box->blocks[i], box->sizes[i], i);
+    }
+
+    return NULL;
+}
+
+/**
+ * runFreer:
+ *      Free the first or second half of the mixed blocks, each half
+ *      holding blocks of both kinds and parts of several runs.
+ */
+void *runFreer(void *arg)
+{
+    size_t half = (size_t)arg;
+
+    for (size_t i = half * MIXED / 2; i < (half + 1) * MIXED / 2; i++)
+        checkFree(mixed[i], MIXED_SIZE, i);
+    nc_flush();
+
+    return NULL;
+}
@@ -0,0 +1,176 @@
+/** demo_23_intrusive.c - Exercise intrusive singly and doubly linked lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "intrusive.h"
+#include "errors.h"
+
+#define TASKS 10                // objects linked onto the lists
+
+// An object on a singly and a doubly linked list at once
+typedef struct task {
+    int id;                     // task identifier
+    iListLink queued;           // link in the queue
+    idListLink scheduled;       // link in the schedule
+} task;
+
+void checkList(iList *, const int *, size_t);
+void checkDList(idList *, const int *, size_t);
+result compareTask(const void *, const void *);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    task tasks[TASKS];
+    iList queue;
+    idList schedule;
+
+    printf("==== INTRUSIVE LISTS ====\n\n");
+
+    il_init(&queue, offsetof(task, queued));
+    idl_init(&schedule, offsetof(task, scheduled));
+    for (int i = 0; i < TASKS; i++) {
+        tasks[i].id = i;
+        il_append(&queue, &tasks[i].queued);
+        idl_push(&schedule, &tasks[i].scheduled);
+    }
+
+    // container_of and il_object both give back the embedding object
+    for (iListLink *link = il_first(&queue); link; link = il_next(link))
+        if (container_of(link, task, queued) != il_object(&queue, link))
+            error_quit("container_of and il_object disagree");
+    idListLink *last = idl_last(&schedule);
+    if (container_of(last, task, scheduled) != &tasks[0])
+        error_quit("container_of gave the wrong task");
+    printf("container_of finds the object embedding a link\n");
+
+    // il_removeAfter at the head, in the middle and at the tail
+    int afterHead[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    iListLink *head = il_removeAfter(&queue, NULL);
+    if (container_of(head, task, queued) != &tasks[0])
+        error_quit("il_removeAfter(NULL) did not remove the head");
+    checkList(&queue, afterHead, 9);
+
+    int afterMiddle[] = { 1, 2, 3, 5, 6, 7, 8, 9 };
+    il_removeAfter(&queue, &tasks[3].queued);
+    checkList(&queue, afterMiddle, 8);
+
+    int afterTail[] = { 1, 2, 3, 5, 6, 7, 8 };
+    il_removeAfter(&queue, &tasks[8].queued);
+    checkList(&queue, afterTail, 7);
+    if (il_removeAfter(&queue, &tasks[8].queued))
+        error_quit("il_removeAfter the tail returned a link");
+
+    // il_remove walks to the predecessor, the tail must follow
+    int removed[] = { 2, 3, 5, 6, 7 };
+    if (!il_remove(&queue, &tasks[1].queued) ||
+        !il_remove(&queue, &tasks[8].queued))
+        error_quit("il_remove missed a link in the list");
+    checkList(&queue, removed, 5);
+    if (il_remove(&queue, &tasks[0].queued))
+        error_quit("il_remove found a link not in the list");
+
+    il_append(&queue, &tasks[0].queued);
+    int appended[] = { 2, 3, 5, 6, 7, 0 };
+    checkList(&queue, appended, 6);
+    printf("il_removeAfter and il_remove keep head, tail and length\n");
+
+    // The doubly linked schedule is untouched by the queue
+    int pushed[] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+    checkDList(&schedule, pushed, TASKS);
+
+    idl_remove(&schedule, &tasks[9].scheduled);      // head
+    idl_remove(&schedule, &tasks[5].scheduled);      // middle
+    idl_remove(&schedule, &tasks[0].scheduled);      // tail
+    int trimmed[] = { 8, 7, 6, 4, 3, 2, 1 };
+    checkDList(&schedule, trimmed, 7);
+
+    idl_insertBefore(&schedule, &tasks[8].scheduled, &tasks[9].scheduled);
+    idl_insertAfter(&schedule, &tasks[1].scheduled, &tasks[0].scheduled);
+    idl_insertAfter(&schedule, &tasks[6].scheduled, &tasks[5].scheduled);
+    checkDList(&schedule, pushed, TASKS);
+
+    idl_sort(&schedule, compareTask);
+    int sorted[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    checkDList(&schedule, sorted, TASKS);
+
+    idl_reverse(&schedule);
+    checkDList(&schedule, pushed, TASKS);
+    printf("idl insert, remove, sort and reverse keep prev links\n");
+
+    return 0;
+}
+
+/**
+ * checkList:
+ *      Quit unless a queue holds the tasks `ids` in order.
+ */
+void checkList(iList *l, const int *ids, size_t n)
+{
+    iListLink *link = il_first(l), *prev = NULL;
+
+    for (size_t i = 0; i < n; i++, prev = link, link = il_next(link))
+        if (!link || container_of(link, task, queued)->id != ids[i])
+            error_quit("Queue differs at position %zu", i);
+
+    if (link || il_last(l) != prev || il_length(l) != n)
+        error_quit("Queue has the wrong tail or length");
+}
+
+/**
+ * checkDList:
+ *      Quit unless a schedule holds the tasks `ids` in order, linked both
+ *      ways.
+ */
+void checkDList(idList *l, const int *ids, size_t n)
+{
+    idListLink *link = idl_first(l), *prev = NULL;
+
+    for (size_t i = 0; i < n; i++, prev = link, link = idl_next(link))
+        if (!link || idl_prev(link) != prev ||
+            container_of(link, task, scheduled)->id != ids[i])
+            error_quit("Schedule differs at position %zu", i);
+
+    if (link || idl_last(l) != prev || l->logicalLength != n)
+        error_quit("Schedule has the wrong tail or length");
+}
+
+/**
+ * compareTask:
+ *      Compare two tasks by identifier.
+ */
+result compareTask(const void *a, const void *b)
+{
+    int ia = ((const task *)a)->id, ib = ((const task *)b)->id;
+
+    return (ia > ib) - (ia < ib);
+}
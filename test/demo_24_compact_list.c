@@ -0,0 +1,168 @@
+/** demo_24_compact_list.c - Exercise the compact index linked list.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "compactList.h"
+#include "lists.h"
+#include "errors.h"
+
+#define GROWN 1000              // nodes appended to grow the slot array
+
+static size_t freed;            // elements passed to the freeFunction
+
+void freeCounted(void *);
+void check(compactList *, const int *, size_t);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    compactList *l = cl_create(sizeof(int), freeCounted);
+    uint32_t idx[8];
+
+    printf("==== COMPACT LIST ====\n\n");
+
+    // Insert at both ends and around nodes in the middle
+    for (int v = 2; v <= 4; v++)
+        idx[v] = cl_append(l, &v);
+    int v = 0;
+    idx[0] = cl_push(l, &v);
+    v = 1;
+    idx[1] = cl_insertAfter(l, idx[0], &v);
+    v = 5;
+    idx[5] = cl_insertAfter(l, idx[4], &v);
+    v = 6;
+    idx[6] = cl_insertBefore(l, idx[0], &v);
+    int inserted[] = { 6, 0, 1, 2, 3, 4, 5 };
+    check(l, inserted, 7);
+
+    // Remove the head, a middle node and the tail
+    cl_removeAt(l, idx[6]);
+    cl_removeAt(l, idx[3]);
+    v = 5;
+    cl_deleteNode(l, &v, compareInt);
+    int removed[] = { 0, 1, 2, 4 };
+    check(l, removed, 4);
+    if (freed != 3)
+        error_quit("freeFunction ran %zu times for 3 removals", freed);
+    printf("insert and delete at the head, middle and tail\n");
+
+    // New nodes take the freed slots, most recently freed first
+    uint32_t used = l->used, capacity = l->capacity;
+    v = 7;
+    if (cl_append(l, &v) != idx[5])
+        error_quit("The last slot freed was not reused first");
+    v = 8;
+    if (cl_push(l, &v) != idx[3] || cl_length(l) != 6)
+        error_quit("A freed slot was not reused");
+    v = 9;
+    if (cl_insertBefore(l, idx[4], &v) != idx[6])
+        error_quit("The first slot freed was not reused last");
+    if (l->used != used || l->capacity != capacity)
+        error_quit("Reusing slots grew the array");
+    int reused[] = { 8, 0, 1, 2, 9, 4, 7 };
+    check(l, reused, 7);
+    printf("freed slots are reused before the array grows\n");
+
+    // Grow well past the first allocation, indices must stay valid
+    uint32_t *grown = malloc(GROWN * sizeof(uint32_t));
+    int *expected = malloc((GROWN + 7) * sizeof(int));
+    if (!grown || !expected)
+        error_abort("Unable to allocate indices");
+    for (int i = 0; i < 7; i++)
+        expected[i] = reused[i];
+    for (int i = 0; i < GROWN; i++) {
+        int g = 100 + i;
+        grown[i] = cl_append(l, &g);
+        expected[7 + i] = g;
+    }
+    if (l->capacity < GROWN + 7)
+        error_quit("Capacity %u after %d nodes", l->capacity, GROWN + 7);
+    for (int i = 0; i < GROWN; i++)
+        if (*(int *)cl_data(l, grown[i]) != 100 + i)
+            error_quit("Index %u lost its element after growth", grown[i]);
+    check(l, expected, GROWN + 7);
+    printf("grew from 16 to %u slots with indices intact\n", l->capacity);
+
+    // Compaction keeps the order and releases the free slots
+    for (int i = 0; i < GROWN; i += 2)
+        cl_removeAt(l, grown[i]);
+    size_t n = 0;
+    for (int i = 0; i < GROWN + 7; i++)
+        if (i < 7 || (i - 7) % 2)
+            expected[n++] = expected[i];
+    cl_compact(l);
+    if (l->capacity != n || l->freeSlots != CL_NIL)
+        error_quit("cl_compact kept %u slots for %zu nodes", l->capacity, n);
+    check(l, expected, n);
+    printf("cl_compact kept %zu nodes in order\n", n);
+
+    freed = 0;
+    cl_delete(l);
+    if (freed != n)
+        error_quit("cl_delete freed %zu of %zu elements", freed, n);
+
+    free(grown);
+    free(expected);
+
+    return 0;
+}
+
+/**
+ * freeCounted:
+ *      Free function counting the elements freed.
+ */
+void freeCounted(void *data)
+{
+    freed++;
+}
+
+/**
+ * check:
+ *      Quit unless a list holds `vals` in order, walking it both ways.
+ */
+void check(compactList *l, const int *vals, size_t n)
+{
+    uint32_t i = cl_first(l), prev = CL_NIL;
+
+    for (size_t pos = 0; pos < n; pos++, prev = i, i = cl_next(l, i))
+        if (i == CL_NIL || cl_prev(l, i) != prev ||
+            *(int *)cl_data(l, i) != vals[pos])
+            error_quit("List differs at position %zu", pos);
+
+    if (i != CL_NIL || cl_last(l) != prev || cl_length(l) != n)
+        error_quit("List has the wrong tail or length");
+
+    i = cl_last(l);
+    for (size_t pos = n; pos > 0; pos--, i = cl_prev(l, i))
+        if (*(int *)cl_data(l, i) != vals[pos - 1])
+            error_quit("Backward walk differs at position %zu", pos);
+}
@@ -0,0 +1,179 @@
+/** demo_25_compaction.c - Check list compaction.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "lists.h"
+#include "errors.h"
+
+#define NODES 20000             // nodes in the lists compacted
+#define STEP 777                // nodes moved per ll_compactFrom call
+
+void **addresses(linkedListNode *, dLinkedListNode *, size_t);
+linkedListNode *nodeAt(linkedList *, size_t);
+void checkList(linkedList *, void **, size_t);
+void checkDList(dLinkedList *, void **, size_t);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    linkedList *l = ll_create(sizeof(char *), freeString);
+    dLinkedList *d = dll_create(sizeof(int), NULL);
+
+    printf("==== COMPACTION ====\n\n");
+
+    // Build lists interleaved with each other so neither is contiguous
+    for (int i = 0; i < NODES; i++) {
+        char buf[16], *s;
+        snprintf(buf, sizeof(buf), "%d", i);
+        if (!(s = strdup(buf)))
+            error_abort("Unable to allocate string");
+        ll_append(l, &s);
+        dll_append(d, &i);
+    }
+
+    // Every node moves, strings owned by the elements stay where they are
+    void **before = addresses(l->head, NULL, NODES);
+    char *first = *(char **)l->head->data;
+    ll_compact(l);
+    checkList(l, before, NODES);
+    if (*(char **)l->head->data != first)
+        error_quit("ll_compact moved memory owned by an element");
+    free(before);
+    printf("ll_compact kept order, length and tail, moved every node\n");
+
+    before = addresses(NULL, d->head, NODES);
+    dll_compact(d);
+    checkDList(d, before, NODES);
+    free(before);
+    printf("dll_compact kept order, length, tail and prev links\n");
+
+    // Compact in steps, the node passed as prev keeps its address
+    before = addresses(l->head, NULL, NODES);
+    linkedListNode *prev = NULL;
+    size_t calls = 0;
+    do {
+        linkedListNode *kept = prev;
+        size_t at = calls * STEP < NODES ? calls * STEP : NODES;
+        prev = ll_compactFrom(l, prev, STEP);
+        if (kept && nodeAt(l, at - 1) != kept)
+            error_quit("ll_compactFrom moved the node passed to it");
+        calls++;
+    } while (prev);
+    checkList(l, before, NODES);
+    free(before);
+    printf("ll_compactFrom in %zu steps of %d nodes\n", calls - 1, STEP);
+
+    ll_delete(l);
+    dll_delete(d);
+
+    return 0;
+}
+
+/**
+ * addresses:
+ *      Return the addresses of the nodes of a list, in order.
+ */
+void **addresses(linkedListNode *node, dLinkedListNode *dnode, size_t n)
+{
+    void **a = malloc(n * sizeof(void *));
+    if (!a)
+        error_abort("Unable to allocate addresses");
+
+    for (size_t i = 0; i < n; i++) {
+        if (node) {
+            a[i] = node;
+            node = node->next;
+        } else {
+            a[i] = dnode;
+            dnode = dnode->next;
+        }
+    }
+
+    return a;
+}
+
+/**
+ * nodeAt:
+ *      Return the node at an index by walking the list.
+ */
+linkedListNode *nodeAt(linkedList *l, size_t index)
+{
+    linkedListNode *node = l->head;
+
+    while (index--)
+        node = node->next;
+
+    return node;
+}
+
+/**
+ * checkList:
+ *      Quit unless a list of strings holds 0 to n - 1 in order, with every
+ *      node at a new address.
+ */
+void checkList(linkedList *l, void **before, size_t n)
+{
+    linkedListNode *node = l->head, *last = NULL;
+    char buf[24];
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next) {
+        snprintf(buf, sizeof(buf), "%zu", i);
+        if (!node || strcmp(*(char **)node->data, buf))
+            error_quit("List differs at node %zu", i);
+        if ((void *)node == before[i])
+            error_quit("Node %zu was not moved", i);
+    }
+
+    if (node || l->tail != last || l->logicalLength != n)
+        error_quit("List has the wrong tail or length");
+}
+
+/**
+ * checkDList:
+ *      Quit unless a list of ints holds 0 to n - 1 in order, linked both
+ *      ways, with every node at a new address.
+ */
+void checkDList(dLinkedList *l, void **before, size_t n)
+{
+    dLinkedListNode *node = l->head, *last = NULL;
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next) {
+        if (!node || node->prev != last || *(int *)node->data != (int)i)
+            error_quit("List differs at node %zu", i);
+        if ((void *)node == before[i])
+            error_quit("Node %zu was not moved", i);
+    }
+
+    if (node || l->tail != last || l->logicalLength != n)
+        error_quit("List has the wrong tail or length");
+}
@@ -0,0 +1,144 @@
+/** demo_26_string_list.c - Exercise string lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "stringList.h"
+#include "errors.h"
+
+#define S(x) { x, sizeof(x) - 1 }   // string literal with its length
+
+// A string and its length, which may count embedded NUL bytes
+typedef struct str {
+    const char *s;
+    size_t len;
+} str;
+
+void check(stringList *, const str *, size_t, const char *);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    stringList *l = sl_create();
+    const str be = S("be"), beta = S("be\0ta"), bet = S("bet");
+
+    printf("==== STRING LIST ====\n\n");
+
+    // Strings that only differ past an embedded NUL are distinct
+    sl_append(l, beta.s, beta.len);
+    sl_append(l, be.s, be.len);
+    sl_append(l, "gamma", 5);
+    sl_push(l, "alpha", 5);
+    const str built[] = { S("alpha"), S("be\0ta"), S("be"), S("gamma") };
+    check(l, built, 4, "building");
+
+    stringListNode *a = sl_find(l, beta.s, beta.len);
+    stringListNode *b = sl_find(l, be.s, be.len);
+    if (!a || !b || a == b || a->length != 5 || b->length != 2)
+        error_quit("sl_find confused strings with embedded NUL bytes");
+    if (sl_search(l, "be\0tb", 5) || sl_search(l, "b", 1))
+        error_quit("sl_search found a string not in the list");
+    if (sl_equals(a, b) || !sl_equals(a, a))
+        error_quit("sl_equals is wrong");
+    printf("Strings with embedded NUL bytes are kept apart\n");
+
+    // A prefix is less, bytes past a NUL still count
+    stringList *c = sl_create();
+    stringListNode *x = sl_append(c, bet.s, bet.len);
+    if (sl_compare(b, a) != LESS || sl_compare(a, b) != GREATER ||
+        sl_compare(a, x) != LESS || sl_compare(x, b) != GREATER ||
+        sl_compare(a, a) != EQUAL)
+        error_quit("sl_compare does not order prefixes first");
+    sl_delete(c);
+    printf("sl_compare orders a prefix before the strings it starts\n");
+
+    // Delete the tail, then append after the new tail
+    if (!sl_deleteNode(l, "gamma", 5) || sl_deleteNode(l, "gamma", 5))
+        error_quit("sl_deleteNode of the tail failed");
+    const str noTail[] = { S("alpha"), S("be\0ta"), S("be") };
+    check(l, noTail, 3, "deleting the tail");
+    sl_append(l, "delta", 5);
+
+    // Delete the head, then the middle, the NUL string must survive
+    if (!sl_deleteNode(l, "alpha", 5) || !sl_deleteNode(l, be.s, be.len))
+        error_quit("sl_deleteNode of the head or middle failed");
+    const str deleted[] = { S("be\0ta"), S("delta") };
+    check(l, deleted, 2, "deleting the head and middle");
+
+    // Insert after the tail and delete down to one node
+    sl_insertAfter(l, sl_last(l), "omega", 5);
+    if (!sl_deleteNode(l, "delta", 5))
+        error_quit("sl_deleteNode of the middle failed");
+    const str inserted[] = { S("be\0ta"), S("omega") };
+    check(l, inserted, 2, "sl_insertAfter the tail");
+    printf("sl_deleteNode keeps the tail at head, middle and tail\n");
+
+    // Reverse, then append to the new tail
+    sl_push(l, "first", 5);
+    sl_reverse(l);
+    sl_append(l, "last", 4);
+    const str reversed[] = { S("omega"), S("be\0ta"), S("first"), S("last") };
+    check(l, reversed, 4, "sl_reverse");
+    printf("sl_reverse reverses the list and its tail\n");
+
+    // Empty the list, the tail must go with the last node
+    while (sl_removeHead(l))
+        ;
+    check(l, NULL, 0, "sl_removeHead");
+    sl_append(l, be.s, be.len);
+    check(l, &be, 1, "appending to an emptied list");
+
+    sl_delete(l);
+
+    return 0;
+}
+
+/**
+ * check:
+ *      Quit unless a string list holds exactly the expected strings, in
+ *      order and NUL terminated, with the right tail and length.
+ */
+void check(stringList *l, const str *expect, size_t n, const char *what)
+{
+    stringListNode *node = sl_first(l), *last = NULL;
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next) {
+        if (!node || node->length != expect[i].len ||
+            memcmp(node->str, expect[i].s, expect[i].len) ||
+            node->str[node->length] != '\0')
+            error_quit("List differs at node %zu after %s", i, what);
+    }
+
+    if (node || sl_last(l) != last || sl_length(l) != n ||
+        sl_isEmpty(l) != (n == 0))
+        error_quit("List has the wrong tail or length after %s", what);
+}
@@ -0,0 +1,135 @@
+/** demo_27_str_keys.c - Check string key comparators.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "lists.h"
+#include "errors.h"
+
+#define RANDOM_KEYS 400         // random keys over a two letter alphabet
+#define MAX_LENGTH 12           // longest random key
+
+void checkPair(const char *, const char *);
+int sign(int);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    // Shorter than, equal to and longer than the 8 byte prefix
+    const char *fixed[] = {
+        "", "a", "ab", "abcdefg", "abcdefgh", "abcdefgha", "abcdefghb",
+        "abcdefghij", "abcdefgi", "abcdefg~", "abcdefgh~", "b", "\xff",
+        "abcdefg\xff", "abcdefgh\xff", "zzzzzzzzzzzzzzzz", "zzzzzzzz",
+    };
+    size_t nfixed = sizeof(fixed) / sizeof(fixed[0]);
+
+    printf("==== STRING KEYS ====\n\n");
+
+    for (size_t i = 0; i < nfixed; i++)
+        for (size_t j = 0; j < nfixed; j++)
+            checkPair(fixed[i], fixed[j]);
+    printf("%zu pairs around the prefix length agree with strcmp\n",
+           nfixed * nfixed);
+
+    // Random keys over "ab" share long prefixes with each other
+    char keys[RANDOM_KEYS][MAX_LENGTH + 1];
+    srand(27);
+    for (size_t i = 0; i < RANDOM_KEYS; i++) {
+        size_t len = rand() % (MAX_LENGTH + 1);
+        for (size_t j = 0; j < len; j++)
+            keys[i][j] = "ab"[rand() % 2];
+        keys[i][len] = '\0';
+    }
+
+    for (size_t i = 0; i < RANDOM_KEYS; i++)
+        for (size_t j = 0; j < RANDOM_KEYS; j++)
+            checkPair(keys[i], keys[j]);
+    printf("%d pairs of random keys agree with strcmp\n",
+           RANDOM_KEYS * RANDOM_KEYS);
+
+    // Keys owned by a list are found by a view of the same string
+    linkedList *l = ll_create(sizeof(strKey), freeStrKey);
+    for (size_t i = 0; i < nfixed; i++) {
+        strKey k = strKey_make(fixed[i], strlen(fixed[i]));
+        if (k.str == fixed[i] || strcmp(k.str, fixed[i]))
+            error_quit("strKey_make did not copy \"%s\"", fixed[i]);
+        ll_append(l, &k);
+    }
+
+    for (size_t i = 0; i < nfixed; i++) {
+        strKey v = strKey_view(fixed[i], strlen(fixed[i]));
+        if (!ll_search(l, &v, equalStrKey) || !ll_search(l, &v, compareStrKey))
+            error_quit("Key \"%s\" not found", fixed[i]);
+    }
+
+    strKey missing = strKey_view("abcdefgh!", 9);
+    if (ll_search(l, &missing, equalStrKey) ||
+        ll_search(l, &missing, compareStrKey))
+        error_quit("Found a key not in the list");
+    printf("Views find the keys a list owns\n");
+
+    ll_delete(l);
+
+    return 0;
+}
+
+/**
+ * checkPair:
+ *      Quit unless the key comparators agree with strcmp on two strings,
+ *      for both copied keys and views.
+ */
+void checkPair(const char *a, const char *b)
+{
+    strKey ka = strKey_make(a, strlen(a)), kb = strKey_view(b, strlen(b));
+    int expect = sign(strcmp(a, b));
+
+    if (compareStrKey(&ka, &kb) != expect ||
+        compareStrKey(&kb, &ka) != -expect)
+        error_quit("compareStrKey disagrees with strcmp on \"%s\", \"%s\"",
+                   a, b);
+
+    if ((equalStrKey(&ka, &kb) == EQUAL) != (expect == 0) ||
+        (equalStrKey(&kb, &ka) == EQUAL) != (expect == 0))
+        error_quit("equalStrKey disagrees with strcmp on \"%s\", \"%s\"",
+                   a, b);
+
+    freeStrKey(&ka);
+}
+
+/**
+ * sign:
+ *      Return -1, 0 or 1 for a negative, zero or positive int.
+ */
+int sign(int c)
+{
+    return (c > 0) - (c < 0);
+}
@@ -0,0 +1,285 @@
+/** demo_28_cursors.c - Exercise list cursors.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "lists.h"
+#include "errors.h"
+
+#define NODES 10                // nodes the lists start with
+
+static int freed = 0;           // elements passed to countFree
+
+void countFree(void *);
+void checkList(linkedList *, const int *, size_t, const char *);
+void checkDList(dLinkedList *, const int *, size_t, const char *);
+void checkCursor(llCursor *, const char *);
+void singly(void);
+void doubly(void);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    printf("==== CURSORS ====\n\n");
+
+    singly();
+    doubly();
+
+    return 0;
+}
+
+/**
+ * singly:
+ *      Edit a singly linked list through a cursor at the head, middle and
+ *      tail, checking the tracked predecessor after each step.
+ */
+void singly(void)
+{
+    linkedList *l = ll_create(sizeof(int), countFree);
+    int v;
+
+    for (int i = 0; i < NODES; i++)
+        ll_append(l, &i);
+
+    // Remove the head, the cursor moves on with no predecessor
+    llCursor c = ll_cursor(l);
+    llc_remove(&c);
+    checkCursor(&c, "removing the head");
+    if (c.prev || *(int *)llc_get(&c) != 1)
+        error_quit("Cursor not on the new head");
+
+    // Insert before the head, the new node becomes the predecessor
+    v = 100;
+    llc_insertBefore(&c, &v);
+    checkCursor(&c, "inserting before the head");
+    if (c.prev != l->head || *(int *)llc_get(&c) != 1)
+        error_quit("Cursor left its node inserting before the head");
+
+    // Remove, insert before and after in the middle
+    while (*(int *)llc_get(&c) != 5)
+        llc_next(&c);
+    llc_remove(&c);
+    checkCursor(&c, "removing in the middle");
+    v = 55;
+    llc_insertBefore(&c, &v);
+    v = 66;
+    llc_insertAfter(&c, &v);
+    checkCursor(&c, "inserting in the middle");
+    v = 60;
+    llc_set(&c, &v);
+    const int middle[] = { 100, 1, 2, 3, 4, 55, 60, 66, 7, 8, 9 };
+    checkList(l, middle, 11, "editing the middle");
+    if (freed != 3)
+        error_quit("%d elements freed instead of 3", freed);
+
+    // Remove the tail, the predecessor becomes the tail
+    while (c.curr != l->tail)
+        llc_next(&c);
+    llc_remove(&c);
+    checkCursor(&c, "removing the tail");
+    if (llc_valid(&c) || c.prev != l->tail || *(int *)l->tail->data != 8)
+        error_quit("Cursor or tail wrong after removing the tail");
+
+    // Inserting before a cursor past the tail appends
+    v = 99;
+    llc_insertBefore(&c, &v);
+    checkCursor(&c, "appending through the cursor");
+    if (c.prev != l->tail)
+        error_quit("Cursor past the tail lost the new tail");
+
+    // Insert after the tail
+    c = ll_cursor(l);
+    while (c.curr != l->tail)
+        llc_next(&c);
+    v = 101;
+    llc_insertAfter(&c, &v);
+    const int tail[] = { 100, 1, 2, 3, 4, 55, 60, 66, 7, 8, 99, 101 };
+    checkList(l, tail, 12, "editing the tail");
+
+    // Remove every even element in a single pass
+    freed = 0;
+    for (c = ll_cursor(l); llc_valid(&c);) {
+        if (*(int *)llc_get(&c) % 2 == 0)
+            llc_remove(&c);
+        else
+            llc_next(&c);
+        checkCursor(&c, "filtering");
+    }
+    const int odd[] = { 1, 3, 55, 7, 99, 101 };
+    checkList(l, odd, 6, "filtering");
+    if (freed != 6)
+        error_quit("%d elements freed instead of 6", freed);
+
+    printf("llCursor edits at the head, middle and tail\n");
+
+    // Remove everything, then insert into the empty list
+    for (c = ll_cursor(l); llc_valid(&c);)
+        llc_remove(&c);
+    checkList(l, NULL, 0, "emptying");
+    v = 7;
+    llc_insertBefore(&c, &v);
+    checkCursor(&c, "inserting into an empty list");
+    checkList(l, &v, 1, "inserting into an empty list");
+
+    freed = 0;
+    ll_delete(l);
+    if (freed != 1)
+        error_quit("ll_delete freed %d elements instead of 1", freed);
+}
+
+/**
+ * doubly:
+ *      Edit a doubly linked list through cursors walking from either end.
+ */
+void doubly(void)
+{
+    dLinkedList *l = dll_create(sizeof(int), countFree);
+    int v;
+
+    for (int i = 0; i < NODES; i++)
+        dll_append(l, &i);
+
+    // Remove the tail from a cursor at the end, then step back onto it
+    freed = 0;
+    dllCursor c = dll_cursorLast(l);
+    dlc_remove(&c);
+    if (dlc_valid(&c))
+        error_quit("Cursor still valid after removing the tail");
+    dlc_prev(&c);
+    if (c.curr != l->tail || *(int *)dlc_get(&c) != 8)
+        error_quit("Cursor did not move back to the new tail");
+    v = 88;
+    dlc_insertAfter(&c, &v);
+
+    // Remove, insert and replace in the middle walking backwards
+    while (*(int *)dlc_get(&c) != 4)
+        dlc_prev(&c);
+    dlc_remove(&c);
+    if (*(int *)dlc_get(&c) != 5)
+        error_quit("Cursor not on the node after the one removed");
+    v = 44;
+    dlc_insertBefore(&c, &v);
+    v = 50;
+    dlc_set(&c, &v);
+    v = 51;
+    dlc_insertAfter(&c, &v);
+
+    // Remove the head and insert before the new one
+    c = dll_cursor(l);
+    dlc_remove(&c);
+    v = 11;
+    dlc_insertBefore(&c, &v);
+    dlc_prev(&c);
+    if (c.curr != l->head || dlc_get(&c) != l->head->data)
+        error_quit("Cursor did not move back to the new head");
+    dlc_prev(&c);
+    if (dlc_valid(&c))
+        error_quit("Cursor still valid before the head");
+
+    // Inserting before a cursor that is not valid appends
+    v = 99;
+    dlc_insertBefore(&c, &v);
+    const int edited[] = { 11, 1, 2, 3, 44, 50, 51, 6, 7, 8, 88, 99 };
+    checkDList(l, edited, 12, "editing through cursors");
+    if (freed != 4)
+        error_quit("%d elements freed instead of 4", freed);
+
+    // Remove every odd element in a single pass
+    for (c = dll_cursor(l); dlc_valid(&c);) {
+        if (*(int *)dlc_get(&c) % 2)
+            dlc_remove(&c);
+        else
+            dlc_next(&c);
+    }
+    const int even[] = { 2, 44, 50, 6, 8, 88 };
+    checkDList(l, even, 6, "filtering");
+
+    printf("dllCursor edits at the head, middle and tail\n");
+
+    dll_delete(l);
+}
+
+/**
+ * countFree:
+ *      Free function that counts the elements passed to it.
+ */
+void countFree(void *data)
+{
+    (void)data;
+    freed++;
+}
+
+/**
+ * checkCursor:
+ *      Quit unless a cursor's tracked predecessor links to its node.
+ */
+void checkCursor(llCursor *c, const char *what)
+{
+    linkedListNode *next = c->prev ? c->prev->next : c->list->head;
+
+    if (next != c->curr)
+        error_quit("Cursor predecessor is stale after %s", what);
+}
+
+/**
+ * checkList:
+ *      Quit unless a list holds exactly the expected ints, with the right
+ *      tail and length.
+ */
+void checkList(linkedList *l, const int *expect, size_t n, const char *what)
+{
+    linkedListNode *node = l->head, *last = NULL;
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next)
+        if (!node || *(int *)node->data != expect[i])
+            error_quit("List differs at node %zu after %s", i, what);
+
+    if (node || l->tail != last || l->logicalLength != n)
+        error_quit("List has the wrong tail or length after %s", what);
+}
+
+/**
+ * checkDList:
+ *      Quit unless a list holds exactly the expected ints, linked both
+ *      ways, with the right tail and length.
+ */
+void checkDList(dLinkedList *l, const int *expect, size_t n,
+                const char *what)
+{
+    dLinkedListNode *node = l->head, *last = NULL;
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next)
+        if (!node || node->prev != last || *(int *)node->data != expect[i])
+            error_quit("List differs at node %zu after %s", i, what);
+
+    if (node || l->tail != last || l->logicalLength != n)
+        error_quit("List has the wrong tail or length after %s", what);
+}
@@ -0,0 +1,263 @@
+/** demo_29_filters.c - Exercise list filters.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "lists.h"
+#include "errors.h"
+
+#define NODES 10                // nodes the lists start with
+
+// Range of ints matched by inRange
+typedef struct range {
+    int low;                    // smallest int in the range
+    int high;                   // largest int in the range
+} range;
+
+static int freed = 0;           // elements passed to countFree
+
+void countFree(void *);
+bool multipleOf(const void *, void *);
+bool inRange(const void *, void *);
+void checkList(linkedList *, const int *, size_t, const char *);
+void checkDList(dLinkedList *, const int *, size_t, const char *);
+void expectFreed(int, const char *);
+void singly(void);
+void doubly(void);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    printf("==== FILTERS ====\n\n");
+
+    singly();
+    doubly();
+
+    return 0;
+}
+
+/**
+ * singly:
+ *      Filter a singly linked list, removing and moving its first and last
+ *      nodes along with nodes in between.
+ */
+void singly(void)
+{
+    linkedList *l = ll_create(sizeof(int), countFree);
+    linkedList *dst = ll_create(sizeof(int), countFree);
+    int three = 3, two = 2, v = 100;
+    range keep = { 2, 7 }, none = { 50, 60 };
+
+    for (int i = 0; i < NODES; i++)
+        ll_append(l, &i);
+    ll_append(dst, &v);
+
+    // Multiples of 3 include the head and tail
+    if (ll_removeIf(l, multipleOf, &three) != 4)
+        error_quit("ll_removeIf removed the wrong number of nodes");
+    const int removed[] = { 1, 2, 4, 5, 7, 8 };
+    checkList(l, removed, 6, "ll_removeIf");
+    expectFreed(4, "ll_removeIf");
+
+    // Retaining 2 to 7 drops the new head and tail
+    if (ll_retainIf(l, inRange, &keep) != 2)
+        error_quit("ll_retainIf removed the wrong number of nodes");
+    const int retained[] = { 2, 4, 5, 7 };
+    checkList(l, retained, 4, "ll_retainIf");
+    expectFreed(2, "ll_retainIf");
+
+    // Nothing matches, nothing changes
+    if (ll_removeIf(l, inRange, &none) || ll_retainIf(l, inRange, &keep))
+        error_quit("ll_removeIf or ll_retainIf removed a kept node");
+    checkList(l, retained, 4, "a filter matching nothing");
+    expectFreed(0, "a filter matching nothing");
+
+    // Moving the evens takes the head, the rest follow into dst
+    if (ll_moveIf(l, dst, multipleOf, &two) != 2)
+        error_quit("ll_moveIf moved the wrong number of nodes");
+    const int left[] = { 5, 7 }, moved[] = { 100, 2, 4 };
+    checkList(l, left, 2, "ll_moveIf");
+    checkList(dst, moved, 3, "ll_moveIf");
+
+    range all = { 0, NODES };
+    if (ll_moveIf(l, dst, inRange, &all) != 2)
+        error_quit("ll_moveIf moved the wrong number of nodes");
+    const int allMoved[] = { 100, 2, 4, 5, 7 };
+    checkList(l, NULL, 0, "ll_moveIf of every node");
+    checkList(dst, allMoved, 5, "ll_moveIf of every node");
+    expectFreed(0, "ll_moveIf");
+
+    // The emptied list is still usable
+    ll_append(l, &v);
+    checkList(l, &v, 1, "appending to an emptied list");
+
+    printf("ll filters keep head, tail and length\n");
+
+    ll_delete(l);
+    ll_delete(dst);
+    expectFreed(6, "ll_delete");
+}
+
+/**
+ * doubly:
+ *      Filter a doubly linked list, removing and moving its first and last
+ *      nodes along with nodes in between.
+ */
+void doubly(void)
+{
+    dLinkedList *l = dll_create(sizeof(int), countFree);
+    dLinkedList *dst = dll_create(sizeof(int), countFree);
+    int three = 3, two = 2, v = 100;
+    range keep = { 2, 7 };
+
+    for (int i = 0; i < NODES; i++)
+        dll_append(l, &i);
+
+    if (dll_removeIf(l, multipleOf, &three) != 4)
+        error_quit("dll_removeIf removed the wrong number of nodes");
+    const int removed[] = { 1, 2, 4, 5, 7, 8 };
+    checkDList(l, removed, 6, "dll_removeIf");
+    expectFreed(4, "dll_removeIf");
+
+    if (dll_retainIf(l, inRange, &keep) != 2)
+        error_quit("dll_retainIf removed the wrong number of nodes");
+    const int retained[] = { 2, 4, 5, 7 };
+    checkDList(l, retained, 4, "dll_retainIf");
+    expectFreed(2, "dll_retainIf");
+
+    // Move into an empty list, then the remaining nodes after them
+    if (dll_moveIf(l, dst, multipleOf, &two) != 2)
+        error_quit("dll_moveIf moved the wrong number of nodes");
+    const int left[] = { 5, 7 }, moved[] = { 2, 4 };
+    checkDList(l, left, 2, "dll_moveIf");
+    checkDList(dst, moved, 2, "dll_moveIf");
+
+    range all = { 0, NODES };
+    if (dll_moveIf(l, dst, inRange, &all) != 2)
+        error_quit("dll_moveIf moved the wrong number of nodes");
+    const int allMoved[] = { 2, 4, 5, 7 };
+    checkDList(l, NULL, 0, "dll_moveIf of every node");
+    checkDList(dst, allMoved, 4, "dll_moveIf of every node");
+    expectFreed(0, "dll_moveIf");
+
+    dll_push(l, &v);
+    checkDList(l, &v, 1, "pushing to an emptied list");
+
+    // Removing every node empties the list
+    if (dll_removeIf(dst, inRange, &all) != 4)
+        error_quit("dll_removeIf removed the wrong number of nodes");
+    checkDList(dst, NULL, 0, "dll_removeIf of every node");
+    expectFreed(4, "dll_removeIf of every node");
+
+    printf("dll filters keep head, tail, length and prev links\n");
+
+    dll_delete(l);
+    dll_delete(dst);
+    expectFreed(1, "dll_delete");
+}
+
+/**
+ * countFree:
+ *      Free function that counts the elements passed to it.
+ */
+void countFree(void *data)
+{
+    (void)data;
+    freed++;
+}
+
+/**
+ * multipleOf:
+ *      Predicate true for ints that are a multiple of the int in `ctx`.
+ */
+bool multipleOf(const void *data, void *ctx)
+{
+    return *(const int *)data % *(int *)ctx == 0;
+}
+
+/**
+ * inRange:
+ *      Predicate true for ints within the range in `ctx`.
+ */
+bool inRange(const void *data, void *ctx)
+{
+    const range *r = ctx;
+    int v = *(const int *)data;
+
+    return v >= r->low && v <= r->high;
+}
+
+/**
+ * expectFreed:
+ *      Quit unless `n` elements were freed since the last call.
+ */
+void expectFreed(int n, const char *what)
+{
+    if (freed != n)
+        error_quit("%s freed %d elements instead of %d", what, freed, n);
+
+    freed = 0;
+}
+
+/**
+ * checkList:
+ *      Quit unless a list holds exactly the expected ints, with the right
+ *      head, tail and length.
+ */
+void checkList(linkedList *l, const int *expect, size_t n, const char *what)
+{
+    linkedListNode *node = l->head, *last = NULL;
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next)
+        if (!node || *(int *)node->data != expect[i])
+            error_quit("List differs at node %zu after %s", i, what);
+
+    if (node || l->tail != last || l->logicalLength != n)
+        error_quit("List has the wrong tail or length after %s", what);
+}
+
+/**
+ * checkDList:
+ *      Quit unless a list holds exactly the expected ints, linked both
+ *      ways, with the right head, tail and length.
+ */
+void checkDList(dLinkedList *l, const int *expect, size_t n,
+                const char *what)
+{
+    dLinkedListNode *node = l->head, *last = NULL;
+
+    for (size_t i = 0; i < n; i++, last = node, node = node->next)
+        if (!node || node->prev != last || *(int *)node->data != expect[i])
+            error_quit("List differs at node %zu after %s", i, what);
+
+    if (node || l->tail != last || l->logicalLength != n)
+        error_quit("List has the wrong tail or length after %s", what);
+}
@@ -0,0 +1,213 @@
+/** demo_30_batches.c - Exercise batched list iteration.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "lists.h"
+#include "errors.h"
+
+#define NODES 10                // nodes in the lists iterated
+#define WRITTEN 100             // added to elements written through a batch
+#define DEFAULT_BATCH 64        // batch size picked for 0, LL/DLL_BATCH
+
+// State handed to the batch iterators through their context pointer
+typedef struct tally {
+    size_t batch;               // batch size asked for
+    size_t stopAt;              // batches to take before stopping, 0 for all
+    size_t calls;               // batches seen
+    int next;                   // int expected next
+    int add;                    // added to each element in a batch
+    bool partial;               // a batch smaller than asked for was seen
+} tally;
+
+bool gather(void **, size_t, void *);
+bool gatherCopy(void *, size_t, void *);
+void check(bool, bool, size_t, size_t, const char *);
+tally run(linkedList *, dLinkedList *, bool, size_t, size_t, int);
+void checkValues(linkedList *, dLinkedList *, size_t, const char *);
+
+static linkedList *list;        // singly linked list of 0 to NODES - 1
+static dLinkedList *dlist;      // doubly linked list of 0 to NODES - 1
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    list = ll_create(sizeof(int), NULL);
+    dlist = dll_create(sizeof(int), NULL);
+
+    printf("==== BATCHES ====\n\n");
+
+    for (int i = 0; i < NODES; i++) {
+        ll_append(list, &i);
+        dll_append(dlist, &i);
+    }
+
+    for (int doubly = 0; doubly < 2; doubly++) {
+        for (int copy = 0; copy < 2; copy++) {
+            const char *name = doubly ? copy ? "dll_foreachBatchCopy"
+                                             : "dll_foreachBatch"
+                                      : copy ? "ll_foreachBatchCopy"
+                                             : "ll_foreachBatch";
+            check(doubly, copy, 4, 0, name);    // partial last batch
+            check(doubly, copy, 5, 0, name);    // only full batches
+            check(doubly, copy, 0, 0, name);    // default batch size
+            check(doubly, copy, NODES + 1, 0, name);
+            check(doubly, copy, 4, 2, name);    // early stop
+            check(doubly, copy, 3, 4, name);    // stop on the last batch
+            check(doubly, copy, 1, 1, name);
+            printf("%s handles partial batches and early stops\n", name);
+        }
+    }
+
+    // Writes to copies are lost, writes through data pointers are not
+    run(list, NULL, true, 4, 0, WRITTEN);
+    run(NULL, dlist, true, 4, 0, WRITTEN);
+    checkValues(list, dlist, 0, "writing to a copied batch");
+    run(list, NULL, false, 4, 1, WRITTEN);
+    run(NULL, dlist, false, 4, 1, WRITTEN);
+    checkValues(list, dlist, 4, "writing through a batch");
+    printf("Writes reach the list through pointers, not through copies\n");
+
+    // An empty list never calls the iterator
+    linkedList *empty = ll_create(sizeof(int), NULL);
+    dLinkedList *dempty = dll_create(sizeof(int), NULL);
+    for (int copy = 0; copy < 2; copy++)
+        if (run(empty, NULL, copy, 4, 0, 0).calls ||
+            run(NULL, dempty, copy, 4, 0, 0).calls)
+            error_quit("Iterator called for an empty list");
+    ll_delete(empty);
+    dll_delete(dempty);
+    printf("Empty lists hand out no batches\n");
+
+    ll_delete(list);
+    dll_delete(dlist);
+
+    return 0;
+}
+
+/**
+ * check:
+ *      Iterate a list in batches and quit unless every element up to the
+ *      stop was seen once, in order, in the expected number of batches.
+ */
+void check(bool doubly, bool copy, size_t batch, size_t stopAt,
+           const char *name)
+{
+    tally t = run(doubly ? NULL : list, doubly ? dlist : NULL, copy, batch,
+                  stopAt, 0);
+    size_t size = batch ? batch : DEFAULT_BATCH;
+    size_t seen = stopAt && stopAt * size < NODES ? stopAt * size : NODES;
+
+    if ((size_t)t.next != seen || t.calls != (seen + size - 1) / size)
+        error_quit("%s with batch %zu stopping at %zu saw %d elements "
+                   "in %zu batches", name, batch, stopAt, t.next, t.calls);
+}
+
+/**
+ * run:
+ *      Iterate over whichever list is given in batches, through pointers
+ *      or copies, adding `add` to each element.  Returns the tally.
+ */
+tally run(linkedList *l, dLinkedList *d, bool copy, size_t batch,
+          size_t stopAt, int add)
+{
+    tally t = { batch ? batch : DEFAULT_BATCH, stopAt, 0, 0, add, false };
+
+    if (l && copy)
+        ll_foreachBatchCopy(l, batch, gatherCopy, &t);
+    else if (l)
+        ll_foreachBatch(l, batch, gather, &t);
+    else if (copy)
+        dll_foreachBatchCopy(d, batch, gatherCopy, &t);
+    else
+        dll_foreachBatch(d, batch, gather, &t);
+
+    return t;
+}
+
+/**
+ * gather:
+ *      Batch iterator checking the size of each batch and that its
+ *      elements follow on from the last batch.
+ */
+bool gather(void **elements, size_t n, void *ctx)
+{
+    tally *t = ctx;
+
+    if (!n || n > t->batch || t->partial)
+        error_quit("Batch of %zu elements after %zu batches", n, t->calls);
+    t->partial = n < t->batch;
+
+    for (size_t i = 0; i < n; i++) {
+        int *v = elements[i];
+        if (*v != t->next++)
+            error_quit("Element %d out of order", *v);
+        *v += t->add;
+    }
+
+    return ++t->calls != t->stopAt;
+}
+
+/**
+ * gatherCopy:
+ *      Copy batch iterator checking the same as gather.
+ */
+bool gatherCopy(void *elements, size_t n, void *ctx)
+{
+    void *pointers[NODES + 1];
+
+    if (n > NODES)
+        error_quit("Batch of %zu elements for %d nodes", n, NODES);
+
+    for (size_t i = 0; i < n; i++)
+        pointers[i] = (int *)elements + i;
+
+    return gather(pointers, n, ctx);
+}
+
+/**
+ * checkValues:
+ *      Quit unless the first `n` elements of both lists were raised by
+ *      WRITTEN and the rest were left alone.
+ */
+void checkValues(linkedList *l, dLinkedList *d, size_t n, const char *what)
+{
+    int a[NODES], b[NODES];
+
+    if (ll_toArray(l, a) != NODES || dll_toArray(d, b) != NODES)
+        error_quit("Lists changed length after %s", what);
+
+    for (int i = 0; i < NODES; i++) {
+        int expect = i + ((size_t)i < n ? WRITTEN : 0);
+        if (a[i] != expect || b[i] != expect)
+            error_quit("Element %d is wrong after %s", i, what);
+    }
+}
@@ -0,0 +1,233 @@
+/** demo_31_lazy_list.c - Exercise lazy lists.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "lazyList.h"
+#include "errors.h"
+
+#define STOP 5                  // element the first iteration stops at
+#define WINDOW 4                // elements kept by the bounded list
+#define FAR 20                  // element the windowed iteration stops at
+
+// State of the counting generator
+typedef struct counter {
+    int next;                   // next int to produce
+    int limit;                  // ints to produce, -1 for no end
+    size_t calls;               // times the generator was called
+} counter;
+
+static size_t freed = 0;        // elements passed to countFree
+static int expect = 0;          // next int an iteration should see
+static int stopAt = 0;          // int the iteration stops at
+static lazyList *walked = NULL; // list being iterated
+
+bool counting(void *, void *);
+bool upTo(void *, displayFunction);
+void countFree(void *);
+void endless(void);
+void windowed(void);
+void bounded(void);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(void)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    printf("==== LAZY LIST ====\n\n");
+
+    endless();
+    windowed();
+    bounded();
+
+    return 0;
+}
+
+/**
+ * endless:
+ *      Iterate an endless sequence with an early stop, then take elements
+ *      off its head.
+ */
+void endless(void)
+{
+    counter c = { 0, -1, 0 };
+    lazyList *l = lz_create(sizeof(int), countFree, counting, &c, 0);
+    int v;
+
+    // Only the elements up to the stop are generated
+    if (c.calls || lz_generated(l))
+        error_quit("Elements generated before they were needed");
+    walked = l;
+    expect = 0;
+    stopAt = STOP;
+    lz_foreach(l, upTo, NULL);
+    if (expect != STOP + 1 || c.calls != STOP + 1 ||
+        lz_generated(l) != STOP + 1 || lz_isDone(l))
+        error_quit("lz_foreach generated %zu elements stopping at %d",
+                   c.calls, STOP);
+
+    // Walking again reuses the kept elements
+    expect = 0;
+    lz_foreach(l, upTo, NULL);
+    if (c.calls != STOP + 1)
+        error_quit("lz_foreach generated kept elements again");
+    printf("lz_foreach stops early on an endless sequence\n");
+
+    // Peeking keeps the head, removing it drops and frees it
+    if (!lz_head(l, &v, false) || v != 0 || l->dropped)
+        error_quit("lz_head peek is wrong");
+    if (!lz_head(l, &v, true) || v != 0 || l->dropped != 1 || freed != 1)
+        error_quit("lz_head remove did not drop the head");
+    if (lz_getNodeAt(l, 1) || *(int *)lz_getNodeAt(l, 2)->data != 1)
+        error_quit("lz_getNodeAt does not count dropped positions");
+    if (lz_generated(l) != STOP + 1)
+        error_quit("lz_generated changed taking the head");
+    printf("lz_head with remove advances dropped\n");
+
+    lz_delete(l);
+    if (freed != STOP + 1)
+        error_quit("%zu of %d elements freed", freed, STOP + 1);
+    freed = 0;
+}
+
+/**
+ * windowed:
+ *      Walk an endless sequence through a bounded window, checking that
+ *      trimmed positions are gone and their elements freed.
+ */
+void windowed(void)
+{
+    counter c = { 0, -1, 0 };
+    lazyList *l = lz_create(sizeof(int), countFree, counting, &c, WINDOW);
+    linkedListNode *node;
+
+    // Reaching position 10 keeps only the last WINDOW elements
+    if (!(node = lz_getNodeAt(l, 10)) || *(int *)node->data != 9)
+        error_quit("lz_getNodeAt(10) is wrong");
+    if (c.calls != 10 || l->dropped != 10 - WINDOW ||
+        ll_length(l->nodes) != WINDOW || freed != 10 - WINDOW)
+        error_quit("Window did not trim to %d elements", WINDOW);
+
+    if (lz_getNodeAt(l, 0) || lz_getNodeAt(l, 10 - WINDOW))
+        error_quit("lz_getNodeAt returned a dropped position");
+    node = lz_getNodeAt(l, 10 - WINDOW + 1);
+    if (!node || *(int *)node->data != 10 - WINDOW)
+        error_quit("lz_getNodeAt lost the oldest kept position");
+    printf("lz_getNodeAt returns NULL for positions out of the window\n");
+
+    // Iterating slides the window, freeing each element it leaves behind
+    walked = l;
+    expect = 10 - WINDOW;
+    stopAt = FAR;
+    lz_foreach(l, upTo, NULL);
+    if (expect != FAR + 1 || c.calls != FAR + 1 ||
+        ll_length(l->nodes) != WINDOW || freed != FAR + 1 - WINDOW)
+        error_quit("lz_foreach did not slide the window");
+    printf("Trimmed elements are freed as the window slides\n");
+
+    lz_delete(l);
+    if (freed != FAR + 1)
+        error_quit("%zu of %d elements freed", freed, FAR + 1);
+    freed = 0;
+}
+
+/**
+ * bounded:
+ *      Exhaust a sequence that ends.
+ */
+void bounded(void)
+{
+    counter c = { 0, 3, 0 };
+    lazyList *l = lz_create(sizeof(int), countFree, counting, &c, 0);
+    int v;
+
+    walked = l;
+    expect = 0;
+    stopAt = -1;
+    lz_foreach(l, upTo, NULL);
+    if (expect != 3 || !lz_isDone(l) || lz_generated(l) != 3)
+        error_quit("lz_foreach did not reach the end of the sequence");
+    if (lz_getNodeAt(l, 4) || !lz_getNodeAt(l, 3))
+        error_quit("lz_getNodeAt is wrong at the end of the sequence");
+
+    for (int i = 0; i < 3; i++)
+        if (!lz_head(l, &v, true) || v != i)
+            error_quit("lz_head returned the wrong element");
+    if (lz_head(l, &v, true) || l->dropped != 3 || freed != 3)
+        error_quit("lz_head returned an element past the end");
+    printf("An ended sequence stops lz_foreach and lz_head\n");
+
+    lz_delete(l);
+    freed = 0;
+}
+
+/**
+ * counting:
+ *      Generator producing consecutive ints until the limit.
+ */
+bool counting(void *el, void *state)
+{
+    counter *c = state;
+
+    c->calls++;
+    if (c->limit >= 0 && c->next >= c->limit)
+        return false;
+
+    *(int *)el = c->next++;
+
+    return true;
+}
+
+/**
+ * upTo:
+ *      Iterator checking that ints arrive in order, within the window,
+ *      and stopping at stopAt.
+ */
+bool upTo(void *data, displayFunction display)
+{
+    (void)display;
+    int v = *(int *)data;
+
+    if (v != expect++)
+        error_quit("Iteration saw %d instead of %d", v, expect - 1);
+    if (walked->window && ll_length(walked->nodes) > walked->window)
+        error_quit("Window holds %zu elements", ll_length(walked->nodes));
+
+    return v != stopAt;
+}
+
+/**
+ * countFree:
+ *      Free function that counts the elements passed to it.
+ */
+void countFree(void *data)
+{
+    (void)data;
+    freed++;
+}
@@ -0,0 +1,141 @@
+/** demo_7_parallel_fib.c - Demo/benchmark of the work-stealing scheduler.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "lists.h"
+#include "tasks.h"
+#include "errors.h"
+
+#define DEFAULT_N 30
+#define CUTOFF 16               // below this fib(n) is computed serially
+
+// Arguments and result of one recursive Fibonacci task
+typedef struct fibArgs {
+    taskScheduler *sched;
+    int n;
+    long result;
+} fibArgs;
+
+long fibSerial(int);
+void fibTask(void *);
+double elapsed(struct timespec *, struct timespec *);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_N;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    struct timespec start, end;
+
+    printf("==== WORK-STEALING RECURSIVE FIBONACCI (n = %d) ====\n\n", n);
+
+    // Serial baseline
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long expected = fibSerial(n);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double serial = elapsed(&start, &end);
+    printf("serial        fib(%d) = %ld  %8.3f ms\n", n, expected, serial);
+
+    // Record the timings of each run in a list
+    linkedList *timings = ll_create(sizeof(double), NULL);
+
+    for (long workers = 1; workers <= (cpus < 2 ? 2 : cpus); workers *= 2) {
+        taskScheduler *s = ts_create((size_t)workers);
+        fibArgs root = { s, n, 0 };
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ts_run(s, fibTask, &root);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ts_delete(s);
+
+        double ms = elapsed(&start, &end);
+        ll_append(timings, &ms);
+        printf("%2ld worker(s)  fib(%d) = %ld  %8.3f ms  speedup %.2fx\n",
+               workers, n, root.result, ms, serial / ms);
+
+        if (root.result != expected) {
+            fprintf(stderr, "Wrong result, expected %ld\n", expected);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    printf("\n%zu runs done...\n", ll_length(timings));
+    ll_delete(timings);
+
+    return 0;
+}
+
+/**
+ * fibSerial:
+ *      Naive recursive Fibonacci.
+ */
+long fibSerial(int n)
+{
+    return n < 2 ? n : fibSerial(n - 1) + fibSerial(n - 2);
+}
+
+/**
+ * fibTask:
+ *      Fork-join recursive Fibonacci, fib(n - 1) is spawned while the
+ *      current task computes fib(n - 2).
+ */
+void fibTask(void *arg)
+{
+    fibArgs *a = arg;
+
+    if (a->n < CUTOFF) {
+        a->result = fibSerial(a->n);
+        return;
+    }
+
+    fibArgs x = { a->sched, a->n - 1, 0 };
+    fibArgs y = { a->sched, a->n - 2, 0 };
+    task t;
+
+    ts_spawn(a->sched, &t, fibTask, &x);
+    fibTask(&y);
+    ts_sync(a->sched, &t);
+
+    a->result = x.result + y.result;
+}
+
+/**
+ * elapsed:
+ *      Milliseconds between two timestamps.
+ */
+double elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e3 +
+        (end->tv_nsec - start->tv_nsec) / 1e6;
+}
@@ -0,0 +1,218 @@
+/** demo_8_rcu_readers.c - Demo/benchmark of RCU list reader scaling.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "lists.h"
+#include "rcu.h"
+#include "errors.h"
+
+#define ROUTES 256              // entries in the routing table
+#define QUIESCE_EVERY 64        // lookups between quiescent states
+#define DEFAULT_MS 100          // duration of each run
+
+// Shared benchmark state
+typedef struct bench {
+    rcuList *rcu;               // RCU routing table
+    rcuDomain *domain;          // readers of the RCU table
+    dLinkedList *dll;           // rwlock protected routing table
+    pthread_rwlock_t rwlock;    // guards dll
+    atomic_bool stop;           // tells threads to finish
+    atomic_ulong writes;        // updates done by the writer
+} bench;
+
+// Per reader thread state
+typedef struct reader {
+    bench *b;
+    bool useRcu;
+    unsigned int seed;
+    unsigned long lookups;
+} reader;
+
+void *rcuReaderMain(void *);
+void *rwlockReaderMain(void *);
+void *writerMain(void *);
+void run(bench *, bool, long, int);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    int ms = argc > 1 ? atoi(argv[1]) : DEFAULT_MS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long maxReaders = cpus < 4 ? 4 : cpus;
+    bench b;
+
+    b.domain = rcu_createDomain();
+    b.rcu = rl_create(sizeof(int), NULL, b.domain);
+    b.dll = dll_create(sizeof(int), NULL);
+    pthread_rwlock_init(&b.rwlock, NULL);
+
+    for (int i = 0; i < ROUTES; i++) {
+        rl_append(b.rcu, &i);
+        dll_append(b.dll, &i);
+    }
+
+    printf("==== RCU LIST VS RWLOCK DLINKEDLIST, %d ROUTES, WRITER CHURN ====\n\n",
+           ROUTES);
+
+    for (long readers = 1; readers <= maxReaders; readers *= 2) {
+        run(&b, false, readers, ms);
+        run(&b, true, readers, ms);
+    }
+
+    // No readers left, free everything
+    rl_barrier(b.rcu);
+    if (b.rcu->retiredCount != 0) {
+        fprintf(stderr, "Retired nodes left after barrier\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rl_delete(b.rcu);
+    rcu_deleteDomain(b.domain);
+    dll_delete(b.dll);
+    pthread_rwlock_destroy(&b.rwlock);
+
+    return 0;
+}
+
+/**
+ * run:
+ *      Run `nreaders` lookup threads against one table for `ms`
+ *      milliseconds while a writer churns it, print the throughput.
+ */
+void run(bench *b, bool useRcu, long nreaders, int ms)
+{
+    pthread_t writer, threads[nreaders];
+    reader readers[nreaders];
+    unsigned long total = 0;
+
+    atomic_init(&b->stop, false);
+    atomic_init(&b->writes, 0);
+
+    for (long i = 0; i < nreaders; i++) {
+        readers[i] = (reader){ b, useRcu, (unsigned int)i + 1, 0 };
+        pthread_create(&threads[i], NULL,
+                       useRcu ? rcuReaderMain : rwlockReaderMain, &readers[i]);
+    }
+    pthread_create(&writer, NULL, writerMain, &(reader){ b, useRcu, 0, 0 });
+
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    atomic_store(&b->stop, true);
+
+    for (long i = 0; i < nreaders; i++) {
+        pthread_join(threads[i], NULL);
+        total += readers[i].lookups;
+    }
+    pthread_join(writer, NULL);
+
+    printf("%-7s %2ld reader(s): %10.0f lookups/s  (%lu writes)\n",
+           useRcu ? "rcu" : "rwlock", nreaders, total * 1000.0 / ms,
+           atomic_load(&b->writes));
+}
+
+/**
+ * rcuReaderMain:
+ *      Lookup random routes in the RCU table.
+ */
+void *rcuReaderMain(void *arg)
+{
+    reader *r = arg;
+    rcuReader *self = rcu_registerReader(r->b->domain);
+
+    while (!atomic_load_explicit(&r->b->stop, memory_order_relaxed)) {
+        for (int i = 0; i < QUIESCE_EVERY; i++) {
+            int key = rand_r(&r->seed) % ROUTES;
+            rl_search(r->b->rcu, &key, compareInt);
+        }
+        r->lookups += QUIESCE_EVERY;
+        rcu_quiescent(self);
+    }
+
+    rcu_unregisterReader(self);
+
+    return NULL;
+}
+
+/**
+ * rwlockReaderMain:
+ *      Lookup random routes in the rwlock protected table.
+ */
+void *rwlockReaderMain(void *arg)
+{
+    reader *r = arg;
+
+    while (!atomic_load_explicit(&r->b->stop, memory_order_relaxed)) {
+        for (int i = 0; i < QUIESCE_EVERY; i++) {
+            int key = rand_r(&r->seed) % ROUTES;
+            pthread_rwlock_rdlock(&r->b->rwlock);
+            dll_search(r->b->dll, &key, compareInt);
+            pthread_rwlock_unlock(&r->b->rwlock);
+        }
+        r->lookups += QUIESCE_EVERY;
+    }
+
+    return NULL;
+}
+
+/**
+ * writerMain:
+ *      Churn the table: replace, delete and re-add routes.
+ */
+void *writerMain(void *arg)
+{
+    reader *w = arg;
+    bench *b = w->b;
+    struct timespec pause = { 0, 100000 }; // 100us between updates
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        int key = rand_r(&w->seed) % ROUTES;
+
+        if (w->useRcu) {
+            rl_replace(b->rcu, &key, &key, compareInt);
+            rl_deleteNode(b->rcu, &key, compareInt);
+            rl_append(b->rcu, &key);
+        } else {
+            pthread_rwlock_wrlock(&b->rwlock);
+            dll_deleteNode(b->dll, &key, compareInt);
+            dll_append(b->dll, &key);
+            pthread_rwlock_unlock(&b->rwlock);
+        }
+
+        atomic_fetch_add(&b->writes, 1);
+        nanosleep(&pause, NULL);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,170 @@
+/** demo_9_pipeline_batch.c - Demo/benchmark of batched blocking queues.
+
+Copyright (c) 2021 Michael Berry
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include "queues.h"
+#include "errors.h"
+
+#define DEFAULT_ITEMS 1000000   // items pushed through the pipeline
+#define QUEUE_CAPACITY 1024     // capacity of each stage's queue
+#define MAX_BATCH 256           // largest batch size measured
+
+// One producer -> transform -> consumer pipeline
+typedef struct pipeline {
+    blockingQueue *in;          // producer to transform
+    blockingQueue *out;         // transform to consumer
+    size_t items;               // number of items to produce
+    size_t batch;               // items moved per queue operation
+    long long sum;              // sum computed by the consumer
+} pipeline;
+
+void *producer(void *);
+void *transform(void *);
+void *consumer(void *);
+double runPipeline(size_t, size_t, long long *);
+
+/**
+ * main:
+ *      Program entry point.
+ */
+int main(int argc, char **argv)
+{
+    // Set up some signal handlers
+    signal(SIGINT, sig_int);
+    signal(SIGSEGV, sig_seg);
+
+    size_t items = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_ITEMS;
+    size_t batches[] = { 1, 16, 256 };
+
+    // Every item i becomes 2 * i, so the consumer sees n * (n - 1)
+    long long expected = (long long)items * (long long)(items - 1);
+
+    printf("==== PRODUCER -> TRANSFORM -> CONSUMER, %zu ITEMS ====\n\n", items);
+
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        long long sum;
+        double secs = runPipeline(items, batches[i], &sum);
+
+        printf("batch %3zu: %12.0f items/s\n", batches[i], items / secs);
+
+        if (sum != expected) {
+            fprintf(stderr, "Wrong sum %lld, expected %lld\n", sum, expected);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * runPipeline:
+ *      Run the three stage pipeline once.  Returns the elapsed seconds.
+ */
+double runPipeline(size_t items, size_t batch, long long *sum)
+{
+    pipeline p = { bq_create(sizeof(long), QUEUE_CAPACITY, NULL),
+                   bq_create(sizeof(long), QUEUE_CAPACITY, NULL),
+                   items, batch, 0 };
+    pthread_t threads[3];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&threads[0], NULL, producer, &p);
+    pthread_create(&threads[1], NULL, transform, &p);
+    pthread_create(&threads[2], NULL, consumer, &p);
+
+    for (int i = 0; i < 3; i++)
+        pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    bq_delete(p.in);
+    bq_delete(p.out);
+    *sum = p.sum;
+
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/**
+ * producer:
+ *      Generate the items 0 .. n - 1 then close the queue.
+ */
+void *producer(void *arg)
+{
+    pipeline *p = arg;
+    long buf[MAX_BATCH];
+
+    for (size_t i = 0; i < p->items; ) {
+        size_t n = 0;
+        while (n < p->batch && i < p->items)
+            buf[n++] = (long)i++;
+
+        bq_enqueueBatch(p->in, buf, n, -1);
+    }
+
+    bq_close(p->in);
+
+    return NULL;
+}
+
+/**
+ * transform:
+ *      Double every item, close the output queue once the input drains.
+ */
+void *transform(void *arg)
+{
+    pipeline *p = arg;
+    long buf[MAX_BATCH];
+    size_t n;
+
+    while ((n = bq_dequeueBatch(p->in, buf, p->batch, -1)) > 0) {
+        for (size_t i = 0; i < n; i++)
+            buf[i] *= 2;
+
+        bq_enqueueBatch(p->out, buf, n, -1);
+    }
+
+    bq_close(p->out);
+
+    return NULL;
+}
+
+/**
+ * consumer:
+ *      Sum every item until the queue drains.
+ */
+void *consumer(void *arg)
+{
+    pipeline *p = arg;
+    long buf[MAX_BATCH];
+    size_t n;
+
+    while ((n = bq_dequeueBatch(p->out, buf, p->batch, -1)) > 0)
+        for (size_t i = 0; i < n; i++)
+            p->sum += buf[i];
+
+    return NULL;
+}